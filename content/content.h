@@ -160,6 +160,11 @@ union content_msg_data {
 		 * if false, scroll point (x0, y0) to top left of viewport
 		 */
 		bool area;
+		/*
+		 * if true, scroll by (x0, y0) from the current position,
+		 * ignoring area
+		 */
+		bool relative;
 		int x0, y0;
 		int x1, y1;
 	} scroll;
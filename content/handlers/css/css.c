@@ -514,6 +514,12 @@ void nscss_content_done(struct content_css_data *css, void *pw)
 /**
  * Handle notification of the need for an imported stylesheet
  *
+ * This is called by the parser as soon as it encounters an import rule,
+ * so the imported sheet is fetched while the rest of its parent, and
+ * any sibling imports, are still being fetched and parsed. Only the
+ * registration of imports with the parent is ordered; see
+ * nscss_register_imports().
+ *
  * \param pw      CSS object requesting the import
  * \param parent  Stylesheet requesting the import
  * \param url     URL of the imported sheet
@@ -685,6 +691,11 @@ css_error nscss_import_complete(nscss_import_ctx *ctx)
 /**
  * Register imports with a stylesheet
  *
+ * Imports must be registered in the order they appear in the sheet, so
+ * registration stops at the first import still being fetched. Imports
+ * after it continue to be fetched concurrently and are registered in a
+ * single pass once it completes.
+ *
  * \param c  CSS object containing the imports
  * \return CSS_OK on success, appropriate error otherwise
  */
@@ -713,6 +724,11 @@ css_error nscss_register_imports(struct content_css_data *c)
 			return error;
 	}
 
+#ifdef NSCSS_IMPORT_TRACE
+	NSLOG(netsurf, INFO, "Registered imports %d to %d of %d for %p",
+	      c->next_to_register, index, c->import_count, c);
+#endif
+
 	/* Record identity of the next import to register */
 	c->next_to_register = (uint32_t) index;
 
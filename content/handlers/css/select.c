@@ -17,8 +17,10 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <nsutils/assert.h>
 
 #include "utils/nsoption.h"
 #include "utils/corestrings.h"
@@ -27,6 +29,7 @@
 #include "netsurf/plot_style.h"
 #include "netsurf/url_db.h"
 #include "desktop/system_colour.h"
+#include "content/urldb.h"
 
 #include "css/internal.h"
 #include "css/hints.h"
@@ -91,6 +94,45 @@ static css_error set_libcss_node_data(void *pw, void *node,
 static css_error get_libcss_node_data(void *pw, void *node,
 		void **libcss_node_data);
 
+/**
+ * Style sharing cache
+ *
+ * Holds the selection made for the most recently styled element, so
+ * that an equivalent following sibling can reuse it without running
+ * selection again.
+ */
+struct nscss_style_share {
+	dom_node *node;		/**< Element selected for, or NULL */
+	css_select_ctx *select_ctx; /**< Selection context used */
+	const css_computed_style *parent_style; /**< Parent style used */
+	const css_computed_style *root_style; /**< Root style used */
+	css_computed_style *partial; /**< Selected style before composition */
+	unsigned int lookups;	/**< Number of elements styled */
+	unsigned int hits;	/**< Number of elements that shared a style */
+};
+
+/**
+ * Mark the selection in progress as not shareable
+ *
+ * Called when a callback looks at anything other than the element's own
+ * name and attributes or its ancestors. Such a selection may differ
+ * between otherwise identical siblings.
+ *
+ * libcss also looks for earlier siblings of the same name after
+ * matching, to share its own node data. Those lookups are not marked;
+ * see named_generic_sibling_node().
+ *
+ * \param pw  Selection context the callback was given, may be NULL
+ */
+static inline void nscss_select_taint(void *pw)
+{
+	nscss_select_ctx *ctx = pw;
+
+	if (ctx != NULL) {
+		ctx->tainted = true;
+	}
+}
+
 /**
  * Selection callback table for libcss
  */
@@ -191,6 +233,59 @@ css_stylesheet *nscss_create_inline_style(const uint8_t *data, size_t len,
 	return sheet;
 }
 
+/**
+ * Absolute URL of a link, stored as libdom node user data
+ *
+ * Caches the result of resolving an anchor's href so that restyles
+ * can check visited state without joining URLs again.
+ */
+struct nscss_link_url {
+	dom_string *href; /**< href attribute value the URL was made from */
+	nsurl *base; /**< base URL the href was resolved against */
+	nsurl *url; /**< resolved absolute URL */
+};
+
+/**
+ * Destroy a cached link URL
+ *
+ * \param link The cached link URL to destroy
+ */
+static void nscss_link_url_destroy(struct nscss_link_url *link)
+{
+	dom_string_unref(link->href);
+	nsurl_unref(link->base);
+	nsurl_unref(link->url);
+	free(link);
+}
+
+/* Handler for link URL cache, stored as libdom node user data */
+static void nscss_link_url_user_data_handler(dom_node_operation operation,
+		dom_string *key, void *data, struct dom_node *src,
+		struct dom_node *dst)
+{
+	if (dom_string_isequal(corestring_dom___ns_key_link_url_node_data,
+			key) == false || data == NULL) {
+		return;
+	}
+
+	switch (operation) {
+	case DOM_NODE_CLONED:
+	case DOM_NODE_RENAMED:
+	case DOM_NODE_IMPORTED:
+	case DOM_NODE_ADOPTED:
+		/* Copies resolve their own URL on first selection */
+		break;
+
+	case DOM_NODE_DELETED:
+		nscss_link_url_destroy(data);
+		break;
+
+	default:
+		NSLOG(netsurf, INFO, "User data operation not handled.");
+		assert(0);
+	}
+}
+
 /* Handler for libcss_node_data, stored as libdom node user data */
 static void nscss_dom_user_data_handler(dom_node_operation operation,
 		dom_string *key, void *data, struct dom_node *src,
@@ -239,6 +334,300 @@ static void nscss_dom_user_data_handler(dom_node_operation operation,
 	}
 }
 
+/**
+ * Find the element preceding a node
+ *
+ * \param n  DOM node
+ * \return The previous element sibling, or NULL. No reference is taken.
+ */
+static dom_node *nscss_style_share_previous(dom_node *n)
+{
+	void *prev;
+
+	sibling_node(NULL, n, &prev);
+
+	return prev;
+}
+
+/**
+ * Determine if an element has any element children
+ *
+ * \param n  DOM element
+ * \return true if there is a child element or on error, else false
+ */
+static bool nscss_style_share_has_child_element(dom_node *n)
+{
+	dom_node *child, *next;
+	dom_node_type type;
+	dom_exception exc;
+
+	exc = dom_node_get_first_child(n, &child);
+	if (exc != DOM_NO_ERR) {
+		return true;
+	}
+
+	while (child != NULL) {
+		exc = dom_node_get_node_type(child, &type);
+		if (exc != DOM_NO_ERR || type == DOM_ELEMENT_NODE) {
+			dom_node_unref(child);
+			return true;
+		}
+
+		exc = dom_node_get_next_sibling(child, &next);
+		dom_node_unref(child);
+		if (exc != DOM_NO_ERR) {
+			return true;
+		}
+		child = next;
+	}
+
+	return false;
+}
+
+/**
+ * Determine if two elements have identical attributes
+ *
+ * \param a  DOM element
+ * \param b  DOM element
+ * \return true if every attribute has the same value on both elements
+ */
+static bool nscss_style_share_attributes_equal(dom_node *a, dom_node *b)
+{
+	dom_namednodemap *a_attrs, *b_attrs;
+	uint32_t a_count, b_count, idx;
+	dom_exception exc;
+	bool equal = false;
+
+	exc = dom_node_get_attributes(a, &a_attrs);
+	if (exc != DOM_NO_ERR) {
+		return false;
+	}
+
+	exc = dom_node_get_attributes(b, &b_attrs);
+	if (exc != DOM_NO_ERR) {
+		dom_namednodemap_unref(a_attrs);
+		return false;
+	}
+
+	exc = dom_namednodemap_get_length(a_attrs, &a_count);
+	if (exc != DOM_NO_ERR) {
+		goto out;
+	}
+
+	exc = dom_namednodemap_get_length(b_attrs, &b_count);
+	if (exc != DOM_NO_ERR || a_count != b_count) {
+		goto out;
+	}
+
+	for (idx = 0; idx < a_count; idx++) {
+		dom_attr *attr;
+		dom_string *name, *a_value, *b_value = NULL;
+
+		exc = dom_namednodemap_item(a_attrs, idx, (void *) &attr);
+		if (exc != DOM_NO_ERR || attr == NULL) {
+			goto out;
+		}
+
+		exc = dom_attr_get_name(attr, &name);
+		if (exc != DOM_NO_ERR) {
+			dom_node_unref(attr);
+			goto out;
+		}
+
+		exc = dom_attr_get_value(attr, &a_value);
+		dom_node_unref(attr);
+		if (exc != DOM_NO_ERR) {
+			dom_string_unref(name);
+			goto out;
+		}
+
+		exc = dom_element_get_attribute(b, name, &b_value);
+		dom_string_unref(name);
+		if (exc != DOM_NO_ERR || b_value == NULL ||
+				dom_string_isequal(a_value, b_value) == false) {
+			dom_string_unref(a_value);
+			if (b_value != NULL) {
+				dom_string_unref(b_value);
+			}
+			goto out;
+		}
+
+		dom_string_unref(a_value);
+		dom_string_unref(b_value);
+	}
+
+	equal = true;
+
+out:
+	dom_namednodemap_unref(b_attrs);
+	dom_namednodemap_unref(a_attrs);
+
+	return equal;
+}
+
+/**
+ * Find a selected style an element can share
+ *
+ * The check is conservative. The element must directly follow the
+ * element in the cache, have the same name and attributes, no id, no
+ * inline style and no child elements, and the cached selection must
+ * not have depended on anything but the element and its ancestors.
+ *
+ * \param ctx           CSS selection context
+ * \param n             Element to select for
+ * \param inline_style  Inline style associated with element, or NULL
+ * \return The partial style to share, or NULL if there is none
+ */
+static css_computed_style *nscss_style_share_find(nscss_select_ctx *ctx,
+		dom_node *n, const css_stylesheet *inline_style)
+{
+	struct nscss_style_share *share = ctx->share;
+	css_qname name, share_name;
+	lwc_string *id;
+	bool equal;
+
+	if (share == NULL || share->node == NULL || inline_style != NULL ||
+			share->select_ctx != ctx->ctx ||
+			share->parent_style != ctx->parent_style ||
+			share->root_style != ctx->root_style ||
+			nscss_style_share_previous(n) != share->node) {
+		return NULL;
+	}
+
+	if (node_id(ctx, n, &id) != CSS_OK) {
+		return NULL;
+	}
+	if (id != NULL) {
+		lwc_string_unref(id);
+		return NULL;
+	}
+
+	if (node_name(ctx, n, &name) != CSS_OK) {
+		return NULL;
+	}
+	if (node_name(ctx, share->node, &share_name) != CSS_OK) {
+		lwc_string_unref(name.name);
+		return NULL;
+	}
+	equal = (name.name == share_name.name);
+	lwc_string_unref(share_name.name);
+	lwc_string_unref(name.name);
+
+	if (equal == false ||
+			nscss_style_share_has_child_element(n) ||
+			nscss_style_share_attributes_equal(n,
+					share->node) == false) {
+		return NULL;
+	}
+
+	return share->partial;
+}
+
+/**
+ * Record a selected style for sharing with the following sibling
+ *
+ * \param ctx           CSS selection context
+ * \param n             Element selected for
+ * \param inline_style  Inline style associated with element, or NULL
+ * \param styles        Selection results for the element
+ * \param partial       Selected style before composition
+ * \return true if the cache took ownership of \a partial, else false
+ */
+static bool nscss_style_share_store(nscss_select_ctx *ctx, dom_node *n,
+		const css_stylesheet *inline_style,
+		const css_select_results *styles,
+		css_computed_style *partial)
+{
+	struct nscss_style_share *share = ctx->share;
+	int pseudo_element;
+	lwc_string *id;
+
+	if (share == NULL) {
+		return false;
+	}
+
+	/* Whatever happens, the cached element is no longer the
+	 * previous sibling of the next element styled */
+	nscss_style_share_flush(share);
+
+	if (ctx->tainted || inline_style != NULL ||
+			nscss_style_share_has_child_element(n)) {
+		return false;
+	}
+
+	for (pseudo_element = CSS_PSEUDO_ELEMENT_NONE + 1;
+			pseudo_element < CSS_PSEUDO_ELEMENT_COUNT;
+			pseudo_element++) {
+		if (styles->styles[pseudo_element] != NULL) {
+			return false;
+		}
+	}
+
+	if (node_id(ctx, n, &id) != CSS_OK) {
+		return false;
+	}
+	if (id != NULL) {
+		lwc_string_unref(id);
+		return false;
+	}
+
+	share->node = dom_node_ref(n);
+	share->select_ctx = ctx->ctx;
+	share->parent_style = ctx->parent_style;
+	share->root_style = ctx->root_style;
+	share->partial = partial;
+
+	return true;
+}
+
+/* exported interface documented in css/select.h */
+nserror nscss_style_share_create(struct nscss_style_share **share_out)
+{
+	struct nscss_style_share *share;
+
+	share = calloc(1, sizeof(*share));
+	if (share == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	*share_out = share;
+
+	return NSERROR_OK;
+}
+
+/* exported interface documented in css/select.h */
+void nscss_style_share_flush(struct nscss_style_share *share)
+{
+	if (share == NULL) {
+		return;
+	}
+
+	if (share->node != NULL) {
+		dom_node_unref(share->node);
+		share->node = NULL;
+	}
+	if (share->partial != NULL) {
+		css_computed_style_destroy(share->partial);
+		share->partial = NULL;
+	}
+}
+
+/* exported interface documented in css/select.h */
+void nscss_style_share_destroy(struct nscss_style_share *share)
+{
+	if (share == NULL) {
+		return;
+	}
+
+	NSLOG(netsurf, INFO, "Style sharing: %u of %u elements (%u%%)",
+	      share->hits, share->lookups,
+	      share->lookups == 0 ? 0 : share->hits * 100 / share->lookups);
+
+	nscss_style_share_flush(share);
+
+	free(share);
+}
+
 /**
  * Get style selection results for an element
  *
@@ -255,14 +644,55 @@ css_select_results *nscss_get_style(nscss_select_ctx *ctx, dom_node *n,
 		const css_unit_ctx *unit_len_ctx,
 		const css_stylesheet *inline_style)
 {
-	css_computed_style *composed;
+	css_computed_style *composed, *partial;
 	css_select_results *styles;
 	int pseudo_element;
 	css_error error;
 
+	if (ctx->share != NULL) {
+		ctx->share->lookups++;
+	}
+
+	/* Reuse the previous sibling's selection, if it is equivalent */
+	partial = nscss_style_share_find(ctx, n, inline_style);
+	if (partial != NULL) {
+		error = css_computed_style_compose(ctx->parent_style,
+				partial, unit_len_ctx, &composed);
+		if (error != CSS_OK) {
+			return NULL;
+		}
+
+		/* libcss has no constructor for selection results. It
+		 * allocates them with calloc() in css_select_style() and
+		 * css_select_results_destroy() releases them with free(),
+		 * so they are allocated the same way here. The results
+		 * must hold nothing but the styles for this to be whole. */
+		ns_static_assert(sizeof(*styles) ==
+				sizeof(styles->styles));
+		styles = calloc(1, sizeof(*styles));
+		if (styles == NULL) {
+			css_computed_style_destroy(composed);
+			return NULL;
+		}
+		styles->styles[CSS_PSEUDO_ELEMENT_NONE] = composed;
+
+		/* Chain along the run of equivalent siblings */
+		dom_node_unref(ctx->share->node);
+		ctx->share->node = dom_node_ref(n);
+		ctx->share->hits++;
+
+		return styles;
+	}
+
 	/* Select style for node */
+	ctx->tainted = false;
+	ctx->sibling_lookup = NULL;
 	error = css_select_style(ctx->ctx, n, unit_len_ctx, media, inline_style,
 			&selection_handler, ctx, &styles);
+	if (ctx->sibling_lookup != NULL) {
+		/* A sibling was looked at to match a selector */
+		nscss_select_taint(ctx);
+	}
 
 	if (error != CSS_OK || styles == NULL) {
 		/* Failed selecting partial style -- bail out */
@@ -282,10 +712,14 @@ css_select_results *nscss_get_style(nscss_select_ctx *ctx, dom_node *n,
 			return NULL;
 		}
 
-		/* Replace select_results style with composed style */
-		css_computed_style_destroy(
-				styles->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		/* Replace select_results style with composed style,
+		 * keeping the partial style for sharing if possible */
+		partial = styles->styles[CSS_PSEUDO_ELEMENT_NONE];
 		styles->styles[CSS_PSEUDO_ELEMENT_NONE] = composed;
+		if (nscss_style_share_store(ctx, n, inline_style,
+				styles, partial) == false) {
+			css_computed_style_destroy(partial);
+		}
 	}
 
 	for (pseudo_element = CSS_PSEUDO_ELEMENT_NONE + 1;
@@ -518,6 +952,7 @@ css_error named_sibling_node(void *pw, void *node,
 	dom_exception err;
 
 	*sibling = NULL;
+	nscss_select_taint(pw);
 
 	/* Find sibling element */
 	err = dom_node_get_previous_sibling(n, &n);
@@ -568,28 +1003,21 @@ css_error named_sibling_node(void *pw, void *node,
 }
 
 /**
- * Callback to find a named generic sibling node.
- *
- * \param pw       HTML document
- * \param node     DOM node
- * \param qname    Node name to search for
- * \param sibling  Pointer to location to receive ancestor
- * \return CSS_OK.
+ * Find the nearest preceding sibling element with a given name.
  *
- * \post \a sibling will contain the result, or NULL if there is no match
+ * \param n      DOM node
+ * \param qname  Node name to search for
+ * \return The sibling, or NULL if there is none. No reference is taken.
  */
-css_error named_generic_sibling_node(void *pw, void *node,
-		const css_qname *qname, void **sibling)
+static dom_node *
+nscss_find_named_generic_sibling(dom_node *n, const css_qname *qname)
 {
-	dom_node *n = node;
 	dom_node *prev;
 	dom_exception err;
 
-	*sibling = NULL;
-
 	err = dom_node_get_previous_sibling(n, &n);
 	if (err != DOM_NO_ERR)
-		return CSS_OK;
+		return NULL;
 
 	while (n != NULL) {
 		dom_node_type type;
@@ -598,22 +1026,21 @@ css_error named_generic_sibling_node(void *pw, void *node,
 		err = dom_node_get_node_type(n, &type);
 		if (err != DOM_NO_ERR) {
 			dom_node_unref(n);
-			return CSS_OK;
+			return NULL;
 		}
 
 		if (type == DOM_ELEMENT_NODE) {
 			err = dom_node_get_node_name(n, &name);
 			if (err != DOM_NO_ERR) {
 				dom_node_unref(n);
-				return CSS_OK;
+				return NULL;
 			}
 
 			if (dom_string_caseless_lwc_isequal(name,
 					qname->name)) {
 				dom_string_unref(name);
 				dom_node_unref(n);
-				*sibling = n;
-				break;
+				return n;
 			}
 			dom_string_unref(name);
 		}
@@ -621,13 +1048,48 @@ css_error named_generic_sibling_node(void *pw, void *node,
 		err = dom_node_get_previous_sibling(n, &prev);
 		if (err != DOM_NO_ERR) {
 			dom_node_unref(n);
-			return CSS_OK;
+			return NULL;
 		}
 
 		dom_node_unref(n);
 		n = prev;
 	}
 
+	return NULL;
+}
+
+/**
+ * Callback to find a named generic sibling node.
+ *
+ * libcss calls this to match sibling combinators and, after matching,
+ * to find siblings it may share node data with. Only the former makes
+ * the selection depend on the element's siblings. libcss always asks
+ * for the node data of a sibling found for sharing next, so the sibling
+ * is remembered until then. The selection is marked as not shareable
+ * if another lookup comes first, or if nothing is found.
+ *
+ * \param pw       HTML document
+ * \param node     DOM node
+ * \param qname    Node name to search for
+ * \param sibling  Pointer to location to receive ancestor
+ * \return CSS_OK.
+ *
+ * \post \a sibling will contain the result, or NULL if there is no match
+ */
+css_error named_generic_sibling_node(void *pw, void *node,
+		const css_qname *qname, void **sibling)
+{
+	nscss_select_ctx *ctx = pw;
+
+	*sibling = nscss_find_named_generic_sibling(node, qname);
+
+	if (ctx != NULL) {
+		if (ctx->sibling_lookup != NULL || *sibling == NULL) {
+			nscss_select_taint(ctx);
+		}
+		ctx->sibling_lookup = *sibling;
+	}
+
 	return CSS_OK;
 }
 
@@ -666,6 +1128,7 @@ css_error sibling_node(void *pw, void *node, void **sibling)
 	dom_exception err;
 
 	*sibling = NULL;
+	nscss_select_taint(pw);
 
 	/* Find sibling element */
 	err = dom_node_get_previous_sibling(n, &n);
@@ -1323,6 +1786,8 @@ css_error node_count_siblings(void *pw, void *n, bool same_name,
 	dom_exception exc;
 	dom_string *node_name = NULL;
 
+	nscss_select_taint(pw);
+
 	if (same_name) {
 		dom_node *node = n;
 		exc = dom_node_get_node_name(node, &node_name);
@@ -1386,6 +1851,7 @@ css_error node_is_empty(void *pw, void *node, bool *match)
 	dom_exception err;
 
 	*match = true;
+	nscss_select_taint(pw);
 
 	err = dom_node_get_first_child(n, &n);
 	if (err != DOM_NO_ERR) {
@@ -1471,9 +1937,9 @@ css_error node_is_link(void *pw, void *n, bool *match)
 css_error node_is_visited(void *pw, void *node, bool *match)
 {
 	nscss_select_ctx *ctx = pw;
+	struct nscss_link_url *link;
 	nsurl *url;
 	nserror error;
-	const struct url_data *data;
 
 	dom_exception exc;
 	dom_node *n = node;
@@ -1502,27 +1968,56 @@ css_error node_is_visited(void *pw, void *node, bool *match)
 		return CSS_OK;
 	}
 
-	/* Make href absolute */
-	/* TODO: this duplicates what we do for box->href
-	 *       should we put the absolute URL on the dom node? */
-	error = nsurl_join(ctx->base_url, dom_string_data(s), &url);
+	/* Reuse the absolute URL resolved by a previous selection if
+	 * neither the href nor the base URL have changed since */
+	exc = dom_node_get_user_data(n,
+			corestring_dom___ns_key_link_url_node_data,
+			(void *) &link);
+	if (exc == DOM_NO_ERR && link != NULL &&
+			link->base == ctx->base_url &&
+			dom_string_isequal(link->href, s)) {
+		dom_string_unref(s);
 
-	/* Finished with href string */
-	dom_string_unref(s);
+		*match = urldb_get_url_visited(link->url);
+
+		return CSS_OK;
+	}
 
+	/* Make href absolute */
+	/* TODO: this duplicates what we do for box->href */
+	error = nsurl_join(ctx->base_url, dom_string_data(s), &url);
 	if (error != NSERROR_OK) {
 		/* Couldn't make nsurl object */
+		dom_string_unref(s);
 		return CSS_NOMEM;
 	}
 
-	data = urldb_get_url_data(url);
-
-	/* Visited if in the db and has
-	 * non-zero visit count */
-	if (data != NULL && data->visits > 0)
-		*match = true;
-
-	nsurl_unref(url);
+	/* Visited if in the db and has non-zero visit count */
+	*match = urldb_get_url_visited(url);
+
+	/* Remember the resolved URL on the node; failure here only
+	 * costs a join on the next restyle */
+	link = malloc(sizeof(*link));
+	if (link != NULL) {
+		struct nscss_link_url *old_link = NULL;
+
+		link->href = s;
+		link->base = nsurl_ref(ctx->base_url);
+		link->url = url;
+
+		exc = dom_node_set_user_data(n,
+				corestring_dom___ns_key_link_url_node_data,
+				link, nscss_link_url_user_data_handler,
+				(void *) &old_link);
+		if (exc != DOM_NO_ERR) {
+			nscss_link_url_destroy(link);
+		} else if (old_link != NULL) {
+			nscss_link_url_destroy(old_link);
+		}
+	} else {
+		dom_string_unref(s);
+		nsurl_unref(url);
+	}
 
 	return CSS_OK;
 }
@@ -1753,6 +2248,13 @@ css_error get_libcss_node_data(void *pw, void *node, void **libcss_node_data)
 {
 	dom_node *n = node;
 	dom_exception err;
+	nscss_select_ctx *ctx = pw;
+
+	/* Node data for a sibling found by the last generic sibling
+	 * lookup means libcss is looking for a style to share */
+	if (ctx != NULL && ctx->sibling_lookup == node) {
+		ctx->sibling_lookup = NULL;
+	}
 
 	/* Get this node's node data */
 	err = dom_node_get_user_data(n,
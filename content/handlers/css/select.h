@@ -25,8 +25,11 @@
 
 #include <libcss/libcss.h>
 
+#include "utils/errors.h"
+
 struct content;
 struct nsurl;
+struct nscss_style_share;
 
 /**
  * Selection context
@@ -39,6 +42,14 @@ typedef struct nscss_select_ctx
 	lwc_string *universal;
 	const css_computed_style *root_style;
 	const css_computed_style *parent_style;
+	/** Style sharing cache, or NULL. Only used by nscss_get_style */
+	struct nscss_style_share *share;
+	/** Whether the selection in progress may not be shared. Only used
+	 * by nscss_get_style, which resets it before each selection */
+	bool tainted;
+	/** Sibling returned by the last generic sibling lookup whose node
+	 * data libcss has not yet asked for, or NULL */
+	void *sibling_lookup;
 } nscss_select_ctx;
 
 css_stylesheet *nscss_create_inline_style(const uint8_t *data, size_t len,
@@ -53,6 +64,34 @@ css_computed_style *nscss_get_blank_style(nscss_select_ctx *ctx,
 		const css_unit_ctx *unit_len_ctx,
 		const css_computed_style *parent);
 
+/**
+ * Create a style sharing cache
+ *
+ * Siblings that are equivalent for selection, such as table cells and
+ * list items, are given the style selected for the previous sibling.
+ *
+ * \param share_out  Updated to the new cache on success
+ * \return NSERROR_OK on success, NSERROR_NOMEM on memory exhaustion
+ */
+nserror nscss_style_share_create(struct nscss_style_share **share_out);
+
+/**
+ * Empty a style sharing cache
+ *
+ * Must be called when the document changes, as the cached selection
+ * may depend on the previous state of the element or its ancestors.
+ *
+ * \param share  The cache to empty, may be NULL
+ */
+void nscss_style_share_flush(struct nscss_style_share *share);
+
+/**
+ * Destroy a style sharing cache, logging its hit rate
+ *
+ * \param share  The cache to destroy, may be NULL
+ */
+void nscss_style_share_destroy(struct nscss_style_share *share);
+
 
 css_error named_ancestor_node(void *pw, void *node,
 		const css_qname *qname, void **ancestor);
@@ -47,6 +47,7 @@ struct rect;
 
 
 typedef void (*box_construct_complete_cb)(struct html_content *c, bool success);
+typedef void (*box_construct_progress_cb)(struct html_content *c);
 
 
 /**
@@ -88,7 +89,12 @@ typedef enum {
 	REPLACE_DIM = 1 << 9,	/* replaced element has given dimensions */
 	IFRAME      = 1 << 10,	/* box contains an iframe */
 	CONVERT_CHILDREN = 1 << 11,  /* wanted children converting */
-	IS_REPLACED = 1 << 12	/* box is a replaced element */
+	IS_REPLACED = 1 << 12,	/* box is a replaced element */
+	NEEDS_LAYOUT = 1 << 13,	/* box or a descendant changed since layout */
+	LAYOUT_REUSED = 1 << 14, /* previous layout of box was kept */
+	ABS_DESCENDANT = 1 << 15, /* box has absolutely positioned descendant */
+	MINMAX_VIEWPORT = 1 << 16, /* min, max widths depend on viewport size */
+	LAYOUT_ESTIMATED = 1 << 17 /* height estimated, children not laid out */
 } box_flags;
 
 
@@ -146,6 +152,72 @@ struct column {
 };
 
 
+/**
+ * Results of a box's previous layout.
+ *
+ * Kept so that a box which has not changed, and is given the same space,
+ * need not be laid out again.
+ */
+struct box_layout_cache {
+	int avail_width;	/**< Width available, or UNKNOWN_WIDTH */
+	int avail_height;	/**< Height given before layout, or AUTO */
+	int width;		/**< Resulting content width */
+	int height;		/**< Resulting content height */
+};
+
+
+/**
+ * Run of consecutive children of a box with many children.
+ *
+ * The area covers the border and descendant boxes of the run's non-float
+ * children, relative to the parent, so that hit-testing and redraw can
+ * skip whole runs which lie elsewhere.
+ */
+struct box_child_run {
+	struct box *first;	/**< First child in the run */
+	struct box *last;	/**< Last non-float child in run, or NULL */
+	int x0;			/**< Left edge of run's area */
+	int y0;			/**< Top edge of run's area */
+	int x1;			/**< Right edge of run's area */
+	int y1;			/**< Bottom edge of run's area */
+};
+
+
+/**
+ * Data which only a few kinds of box have.
+ *
+ * Kept out of struct box so that the fields read for every box during
+ * layout and redraw share fewer cache lines.
+ */
+struct box_extra {
+	/**
+	 * (Image)map to use with this object, or NULL if none
+	 */
+	char *usemap;
+
+	/**
+	 * Parameters for the object, or NULL.
+	 */
+	struct object_params *object_params;
+
+	/**
+	 * Iframe's browser_window, or NULL if none
+	 */
+	struct browser_window *iframe;
+
+	/**
+	 * Spatial index of children, built with the descendant boxes for
+	 * boxes with many children, or NULL.
+	 */
+	struct box_child_run *child_runs;
+
+	/**
+	 * Number of entries in child_runs.
+	 */
+	unsigned int child_run_count;
+};
+
+
 /**
  * Linked list of object element parameters.
  */
@@ -185,169 +257,162 @@ struct box {
 	 */
 	box_flags flags;
 
+	/* Geometry, read and written by layout and redraw. */
+
 	/**
-	 * DOM node that generated this box or NULL
+	 * Coordinate of left padding edge relative to parent box, or
+	 * relative to ancestor that contains this box in
+	 * float_children for FLOAT_.
 	 */
-	struct dom_node *node;
+	int x;
 
 	/**
-	 * Computed styles for elements and their pseudo elements.
-	 *  NULL on non-element boxes.
+	 * Coordinate of top padding edge, relative as for x.
 	 */
-	css_select_results *styles;
+	int y;
 
 	/**
-	 * Style for this box. 0 for INLINE_CONTAINER and
-	 *  FLOAT_*. Pointer into a box's 'styles' select results,
-	 *  except for implied boxes, where it is a pointer to an
-	 *  owned computed style.
+	 * Width of content box (excluding padding etc.).
 	 */
-	css_computed_style *style;
+	int width;
 
 	/**
-	 *  value of id attribute (or name for anchors)
+	 * Height of content box (excluding padding etc.).
 	 */
-	lwc_string *id;
+	int height;
 
+	/* These four variables determine the maximum extent of a box's
+	 * descendants. They are relative to the x,y coordinates of the box.
+	 *
+	 * Their use depends on the overflow CSS property:
+	 *
+	 * Overflow:	Usage:
+	 * visible	The content of the box is displayed within these
+	 *		dimensions.
+	 * hidden	These are ignored. Content is plotted within the box
+	 *		dimensions.
+	 * scroll	These are used to determine the extent of the
+	 *		scrollable area.
+	 * auto		As "scroll".
+	 */
+	int descendant_x0;  /**< left edge of descendants */
+	int descendant_y0;  /**< top edge of descendants */
+	int descendant_x1;  /**< right edge of descendants */
+	int descendant_y1;  /**< bottom edge of descendants */
 
 	/**
-	 * Next sibling box, or NULL.
+	 * Margin: TOP, RIGHT, BOTTOM, LEFT.
 	 */
-	struct box *next;
+	int margin[4];
 
 	/**
-	 * Previous sibling box, or NULL.
+	 * Padding: TOP, RIGHT, BOTTOM, LEFT.
 	 */
-	struct box *prev;
+	int padding[4];
 
 	/**
-	 * First child box, or NULL.
+	 * Border: TOP, RIGHT, BOTTOM, LEFT.
 	 */
-	struct box *children;
+	struct box_border border[4];
 
 	/**
-	 * Last child box, or NULL.
+	 * Width of box taking all line breaks (including margins
+	 * etc). Must be non-negative.
 	 */
-	struct box *last;
+	int min_width;
 
 	/**
-	 * Parent box, or NULL.
+	 * Width that would be taken with no line breaks. Must be
+	 * non-negative.
 	 */
-	struct box *parent;
+	int max_width;
 
 	/**
-	 * INLINE_END box corresponding to this INLINE box, or INLINE
-	 * box corresponding to this INLINE_END box.
+	 * Previous layout of this box, valid unless NEEDS_LAYOUT is set.
 	 */
-	struct box *inline_end;
+	struct box_layout_cache layout_cache;
 
+	/* Tree structure. */
 
 	/**
-	 * First float child box, or NULL. Float boxes are in the tree
-	 * twice, in this list for the block box which defines the
-	 * area for floats, and also in the standard tree given by
-	 * children, next, prev, etc.
+	 * Style for this box. 0 for INLINE_CONTAINER and
+	 *  FLOAT_*. Pointer into a box's 'styles' select results,
+	 *  except for implied boxes, where it is a pointer to an
+	 *  owned computed style.
 	 */
-	struct box *float_children;
+	css_computed_style *style;
 
 	/**
-	 * Next sibling float box.
+	 * Parent box, or NULL.
 	 */
-	struct box *next_float;
+	struct box *parent;
 
 	/**
-	 * If box is a float, points to box's containing block
+	 * First child box, or NULL.
 	 */
-	struct box *float_container;
+	struct box *children;
 
 	/**
-	 * Level below which subsequent floats must be cleared.  This
-	 * is used only for boxes with float_children
+	 * Last child box, or NULL.
 	 */
-	int clear_level;
+	struct box *last;
 
 	/**
-	 * Level below which floats have been placed.
+	 * Next sibling box, or NULL.
 	 */
-	int cached_place_below_level;
-
+	struct box *next;
 
 	/**
-	 * Coordinate of left padding edge relative to parent box, or
-	 * relative to ancestor that contains this box in
-	 * float_children for FLOAT_.
-	 */
-	int x;
-	/**
-	 * Coordinate of top padding edge, relative as for x.
+	 * Previous sibling box, or NULL.
 	 */
-	int y;
+	struct box *prev;
 
 	/**
-	 * Width of content box (excluding padding etc.).
-	 */
-	int width;
-	/**
-	 * Height of content box (excluding padding etc.).
-	 */
-	int height;
-
-	/* These four variables determine the maximum extent of a box's
-	 * descendants. They are relative to the x,y coordinates of the box.
-	 *
-	 * Their use depends on the overflow CSS property:
-	 *
-	 * Overflow:	Usage:
-	 * visible	The content of the box is displayed within these
-	 *		dimensions.
-	 * hidden	These are ignored. Content is plotted within the box
-	 *		dimensions.
-	 * scroll	These are used to determine the extent of the
-	 *		scrollable area.
-	 * auto		As "scroll".
+	 * INLINE_END box corresponding to this INLINE box, or INLINE
+	 * box corresponding to this INLINE_END box.
 	 */
-	int descendant_x0;  /**< left edge of descendants */
-	int descendant_y0;  /**< top edge of descendants */
-	int descendant_x1;  /**< right edge of descendants */
-	int descendant_y1;  /**< bottom edge of descendants */
+	struct box *inline_end;
 
 	/**
-	 * Margin: TOP, RIGHT, BOTTOM, LEFT.
+	 * First float child box, or NULL. Float boxes are in the tree
+	 * twice, in this list for the block box which defines the
+	 * area for floats, and also in the standard tree given by
+	 * children, next, prev, etc.
 	 */
-	int margin[4];
+	struct box *float_children;
 
 	/**
-	 * Padding: TOP, RIGHT, BOTTOM, LEFT.
+	 * Next sibling float box.
 	 */
-	int padding[4];
+	struct box *next_float;
 
 	/**
-	 * Border: TOP, RIGHT, BOTTOM, LEFT.
+	 * If box is a float, points to box's containing block
 	 */
-	struct box_border border[4];
+	struct box *float_container;
 
 	/**
-	 * Horizontal scroll.
+	 * Level below which subsequent floats must be cleared.  This
+	 * is used only for boxes with float_children
 	 */
-	struct scrollbar *scroll_x;
+	int clear_level;
 
 	/**
-	 * Vertical scroll.
+	 * Level below which floats have been placed.
 	 */
-	struct scrollbar *scroll_y;
+	int cached_place_below_level;
 
 	/**
-	 * Width of box taking all line breaks (including margins
-	 * etc). Must be non-negative.
+	 * Index of the run containing this box in parent's child_runs.
 	 */
-	int min_width;
+	unsigned int child_run;
+
+	/* Text content. */
 
 	/**
-	 * Width that would be taken with no line breaks. Must be
-	 * non-negative.
+	 * Width of space after current text (depends on font and size).
 	 */
-	int max_width;
-
+	int space;
 
 	/**
 	 * Text, or NULL if none. Unterminated.
@@ -359,32 +424,32 @@ struct box {
 	 */
 	size_t length;
 
-	/**
-	 * Width of space after current text (depends on font and size).
-	 */
-	int space;
-
 	/**
 	 * Byte offset within a textual representation of this content.
 	 */
 	size_t byte_offset;
 
+	/* Less frequently used data. */
 
 	/**
-	 * Link, or NULL.
+	 * Horizontal scroll.
 	 */
-	struct nsurl *href;
+	struct scrollbar *scroll_x;
 
 	/**
-	 * Link target, or NULL.
+	 * Vertical scroll.
 	 */
-	const char *target;
+	struct scrollbar *scroll_y;
 
 	/**
-	 * Title, or NULL.
+	 * List marker box if this is a list-item, or NULL.
 	 */
-	const char *title;
+	struct box *list_marker;
 
+	/**
+	 * Array of table column data for TABLE only.
+	 */
+	struct column *col;
 
 	/**
 	 * Number of columns for TABLE / TABLE_CELL.
@@ -401,55 +466,61 @@ struct box {
 	 */
 	unsigned int start_column;
 
-	/**
-	 * Array of table column data for TABLE only.
-	 */
-	struct column *col;
-
 	/**
 	 * List item value.
 	 */
 	int list_value;
 
 	/**
-	 * List marker box if this is a list-item, or NULL.
+	 * Link, or NULL.
 	 */
-	struct box *list_marker;
-
+	struct nsurl *href;
 
 	/**
-	 * Form control data, or NULL if not a form control.
+	 * Link target, or NULL.
 	 */
-	struct form_control* gadget;
-
+	const char *target;
 
 	/**
-	 * (Image)map to use with this object, or NULL if none
+	 * Title, or NULL.
 	 */
-	char *usemap;
+	const char *title;
 
+	/**
+	 * Form control data, or NULL if not a form control.
+	 */
+	struct form_control* gadget;
 
 	/**
 	 * Background image for this box, or NULL if none
 	 */
 	struct hlcache_handle *background;
 
-
 	/**
 	 * Object in this box (usually an image), or NULL if none.
 	 */
 	struct hlcache_handle* object;
 
 	/**
-	 * Parameters for the object, or NULL.
+	 * DOM node that generated this box or NULL
 	 */
-	struct object_params *object_params;
+	struct dom_node *node;
+
+	/**
+	 * Computed styles for elements and their pseudo elements.
+	 *  NULL on non-element boxes.
+	 */
+	css_select_results *styles;
 
+	/**
+	 *  value of id attribute (or name for anchors)
+	 */
+	lwc_string *id;
 
 	/**
-	 * Iframe's browser_window, or NULL if none
+	 * Rarely used data, or NULL if the box has none.
 	 */
-	struct browser_window *iframe;
+	struct box_extra *extra;
 
 };
 
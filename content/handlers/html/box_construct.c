@@ -26,12 +26,15 @@
  */
 
 #include <string.h>
+#include <nsutils/time.h>
 #include <dom/dom.h>
 
 #include "utils/errors.h"
 #include "utils/nsoption.h"
 #include "utils/corestrings.h"
 #include "utils/talloc.h"
+#include "utils/arena.h"
+#include "utils/log.h"
 #include "utils/string.h"
 #include "utils/ascii.h"
 #include "utils/nsurl.h"
@@ -47,8 +50,31 @@
 #include "html/box_construct.h"
 #include "html/box_special.h"
 #include "html/box_normalise.h"
+#include "html/display_list.h"
 #include "html/form_internal.h"
 
+/** Time (in ms) spent converting nodes before yielding */
+#define BOX_CONSTRUCT_SLICE_MS 10
+
+/** Number of nodes converted between checks of the slice time */
+#define BOX_CONSTRUCT_SLICE_CHECK 16
+
+/**
+ * Children of a displayed box which were constructed after the box tree
+ * was last displayed.
+ *
+ * Construction only ever appends children to boxes which are still open,
+ * and those are always reached from the root by following last
+ * children. These are recorded when a partial tree is displayed so any
+ * children added since can be unlinked while construction yields.
+ */
+struct box_construct_tail {
+	struct box *box;	/**< Box which may gain children */
+	struct box *shown;	/**< Last child displayed, or NULL */
+	struct box *tail;	/**< First hidden child, or NULL if none */
+	struct box *last;	/**< Last hidden child */
+};
+
 /**
  * Context for box tree construction
  */
@@ -61,7 +87,16 @@ struct box_construct_ctx {
 
 	box_construct_complete_cb cb;	/**< Callback to invoke on completion */
 
+	/** Callback to display partial box tree, or NULL */
+	box_construct_progress_cb progress_cb;
+	uint64_t render_time;		/**< Time of next partial display */
+	uint64_t render_period;		/**< Time between partial displays */
+
+	struct box_construct_tail *tails; /**< Boxes with hidden children */
+	unsigned int tail_count;	/**< Number of entries in tails */
+
 	int *bctx;			/**< talloc context */
+	struct arena *arena;		/**< Allocator for box text */
 };
 
 /**
@@ -285,6 +320,7 @@ box_get_style(html_content *c,
 	ctx.universal = c->universal;
 	ctx.root_style = root_style;
 	ctx.parent_style = parent_style;
+	ctx.share = c->style_share;
 
 	/* Select style for element */
 	styles = nscss_get_style(&ctx, n, &c->media, &c->unit_len_ctx,
@@ -514,7 +550,7 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 		if (t == NULL)
 			return false;
 
-		props.title = talloc_strdup(ctx->bctx, t);
+		props.title = arena_strdup(ctx->arena, t);
 
 		free(t);
 
@@ -1064,7 +1100,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 
 		box->type = BOX_TEXT;
 
-		box->text = talloc_strdup(ctx->bctx, text);
+		box->text = arena_strdup(ctx->arena, text);
 		free(text);
 		if (box->text == NULL)
 			return false;
@@ -1183,7 +1219,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 
 			box->type = BOX_TEXT;
 
-			box->text = talloc_strdup(ctx->bctx, current);
+			box->text = arena_strdup(ctx->arena, current);
 			if (box->text == NULL) {
 				free(text);
 				return false;
@@ -1227,6 +1263,230 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 }
 
 
+/**
+ * Destroy a box construction context
+ *
+ * \param ctx The context to destroy
+ */
+static void box_construct_ctx_destroy(struct box_construct_ctx *ctx)
+{
+	free(ctx->tails);
+	free(ctx);
+}
+
+
+/**
+ * Link children hidden while construction yielded back into the tree
+ *
+ * Layout may have split the last displayed child, so the hidden
+ * children follow whatever is now the last child of each box.
+ *
+ * \param ctx The box construction context
+ */
+static void box_construct_show_tails(struct box_construct_ctx *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->tail_count; i++) {
+		struct box_construct_tail *t = &ctx->tails[i];
+
+		t->shown = t->box->last;
+
+		if (t->tail == NULL)
+			continue;
+
+		if (t->shown == NULL)
+			t->box->children = t->tail;
+		else
+			t->shown->next = t->tail;
+		t->tail->prev = t->shown;
+		t->box->last = t->last;
+		t->tail = NULL;
+
+		/* previous layout of the box is out of date */
+		box_mark_dirty(t->box, true);
+	}
+}
+
+
+/**
+ * Unlink children constructed since the box tree was last displayed
+ *
+ * \param ctx The box construction context
+ */
+static void box_construct_hide_tails(struct box_construct_ctx *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->tail_count; i++) {
+		struct box_construct_tail *t = &ctx->tails[i];
+		struct box *first;
+
+		first = (t->shown == NULL) ? t->box->children : t->shown->next;
+		if (first == NULL)
+			continue;
+
+		t->tail = first;
+		t->last = t->box->last;
+
+		if (t->shown == NULL)
+			t->box->children = NULL;
+		else
+			t->shown->next = NULL;
+		t->box->last = t->shown;
+	}
+}
+
+
+/**
+ * Record the boxes which construction may still append children to
+ *
+ * \param ctx The box construction context
+ * \return true on success, false on memory exhaustion
+ */
+static bool box_construct_record_tails(struct box_construct_ctx *ctx)
+{
+	struct box_construct_tail *tails;
+	unsigned int count = 0;
+	struct box *box;
+
+	for (box = ctx->root_box; box != NULL; box = box->last)
+		count++;
+
+	tails = realloc(ctx->tails, count * sizeof(*tails));
+	if (tails == NULL)
+		return false;
+
+	ctx->tails = tails;
+	ctx->tail_count = count;
+
+	for (box = ctx->root_box; box != NULL; box = box->last) {
+		tails->box = box;
+		tails->shown = box->last;
+		tails->tail = NULL;
+		tails->last = NULL;
+		tails++;
+	}
+
+	return true;
+}
+
+
+/**
+ * Determine if a box still being constructed may be displayed
+ *
+ * Normalising a partial tree must not change how the rest of the
+ * document is constructed, so only block boxes within block boxes, and
+ * inline boxes, may be open. Children of an open block which need an
+ * implied table may be followed by more table parts, so must wait until
+ * the table is complete.
+ *
+ * \param box A box whose element is still being converted
+ * \return true if the tree may be normalised and displayed
+ */
+static bool box_construct_open_box_displayable(const struct box *box)
+{
+	switch (box->type) {
+	case BOX_INLINE:
+		return true;
+
+	case BOX_BLOCK:
+		if (box->parent != NULL && box->parent->type != BOX_BLOCK)
+			return false;
+
+		if (box->last != NULL &&
+				(box->last->type == BOX_TABLE_ROW_GROUP ||
+				 box->last->type == BOX_TABLE_ROW ||
+				 box->last->type == BOX_TABLE_CELL))
+			return false;
+
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/**
+ * Determine if the partially constructed box tree may be displayed
+ *
+ * \param ctx The box construction context
+ * \return true if the tree may be normalised and displayed
+ */
+static bool box_construct_displayable(struct box_construct_ctx *ctx)
+{
+	dom_node *node;
+	dom_node *parent;
+	dom_exception err;
+	struct box *box;
+
+	if (ctx->root_box == NULL || ctx->root_box->type != BOX_BLOCK)
+		return false;
+
+	/* the ancestors of the next node to convert are still open */
+	node = dom_node_ref(ctx->n);
+	while (node != NULL) {
+		err = dom_node_get_parent_node(node, &parent);
+		dom_node_unref(node);
+		if (err != DOM_NO_ERR)
+			return false;
+
+		if (parent == NULL)
+			break;
+
+		box = box_for_node(parent);
+		if (box != NULL &&
+				box_construct_open_box_displayable(box) == false) {
+			dom_node_unref(parent);
+			return false;
+		}
+
+		node = parent;
+	}
+
+	return true;
+}
+
+
+/**
+ * Normalise and display the box tree constructed so far
+ *
+ * \param ctx The box construction context
+ * \return true on success, false on memory exhaustion
+ */
+static bool box_construct_render(struct box_construct_ctx *ctx)
+{
+	struct box root;
+	struct box *box;
+
+	memset(&root, 0, sizeof(root));
+
+	root.type = BOX_BLOCK;
+	root.children = root.last = ctx->root_box;
+	root.children->parent = &root;
+
+	if (box_normalise_block(&root, ctx->root_box, ctx->content) == false)
+		return false;
+
+	assert(root.children == ctx->root_box);
+	ctx->root_box->parent = NULL;
+	ctx->content->layout = ctx->root_box;
+	html_display_list_invalidate(ctx->content->display_list);
+
+	/* the innermost open box may have changed without gaining
+	 * children, e.g. its last text gaining a trailing space */
+	for (box = ctx->root_box; box->last != NULL; box = box->last)
+		;
+	box_mark_dirty(box, true);
+
+	ctx->progress_cb(ctx->content);
+
+	/* the tree as displayed, including any layout changes */
+	return box_construct_record_tails(ctx);
+}
+
+
 /**
  * Convert an ELEMENT node to a box tree fragment,
  * then schedule conversion of the next ELEMENT node
@@ -1236,7 +1496,13 @@ static void convert_xml_to_box(struct box_construct_ctx *ctx)
 	dom_node *next;
 	bool convert_children;
 	uint32_t num_processed = 0;
-	const uint32_t max_processed_before_yield = 10;
+	uint64_t slice_end;
+	uint64_t now;
+
+	nsu_getmonotonic_ms(&now);
+	slice_end = now + BOX_CONSTRUCT_SLICE_MS;
+
+	box_construct_show_tails(ctx);
 
 	do {
 		convert_children = true;
@@ -1246,7 +1512,7 @@ static void convert_xml_to_box(struct box_construct_ctx *ctx)
 		if (box_construct_element(ctx, &convert_children) == false) {
 			ctx->cb(ctx->content, false);
 			dom_node_unref(ctx->n);
-			free(ctx);
+			box_construct_ctx_destroy(ctx);
 			return;
 		}
 
@@ -1260,7 +1526,7 @@ static void convert_xml_to_box(struct box_construct_ctx *ctx)
 			if (err != DOM_NO_ERR) {
 				ctx->cb(ctx->content, false);
 				dom_node_unref(next);
-				free(ctx);
+				box_construct_ctx_destroy(ctx);
 				return;
 			}
 
@@ -1272,7 +1538,7 @@ static void convert_xml_to_box(struct box_construct_ctx *ctx)
 				if (box_construct_text(ctx) == false) {
 					ctx->cb(ctx->content, false);
 					dom_node_unref(ctx->n);
-					free(ctx);
+					box_construct_ctx_destroy(ctx);
 					return;
 				}
 			}
@@ -1298,31 +1564,98 @@ static void convert_xml_to_box(struct box_construct_ctx *ctx)
 				ctx->cb(ctx->content, false);
 			} else {
 				ctx->content->layout = root.children;
+				html_display_list_invalidate(
+						ctx->content->display_list);
 				ctx->content->layout->parent = NULL;
 
+				if (ctx->tails != NULL) {
+					struct box *box;
+
+					/* a partial tree was displayed */
+					for (box = ctx->root_box;
+							box->last != NULL;
+							box = box->last)
+						;
+					box_mark_dirty(box, true);
+				}
+
 				ctx->cb(ctx->content, true);
 			}
 
 			assert(ctx->n == NULL);
 
-			free(ctx);
+			box_construct_ctx_destroy(ctx);
+			return;
+		}
+
+		if ((++num_processed % BOX_CONSTRUCT_SLICE_CHECK) == 0) {
+			nsu_getmonotonic_ms(&now);
+		}
+	} while (now < slice_end);
+
+	/* Display what has been constructed so far, if it is time */
+	if (ctx->progress_cb != NULL &&
+			now >= ctx->render_time &&
+			box_construct_displayable(ctx)) {
+		NSLOG(netsurf, INFO, "Displaying partial box tree (%p)",
+		      ctx->content);
+
+		if (box_construct_render(ctx) == false) {
+			ctx->cb(ctx->content, false);
+			dom_node_unref(ctx->n);
+			box_construct_ctx_destroy(ctx);
 			return;
 		}
-	} while (++num_processed < max_processed_before_yield);
+
+		/* each update costs a layout of everything so far */
+		ctx->render_period *= 2;
+		ctx->render_time = now + ctx->render_period;
+	}
+
+	/* Keep the displayed tree as it was laid out while yielding */
+	box_construct_hide_tails(ctx);
 
 	/* More work to do: schedule a continuation */
 	guit->misc->schedule(0, (void *)convert_xml_to_box, ctx);
 }
 
 
+/**
+ * Determine if a document contains any elements with a given name
+ *
+ * \param c content of type CONTENT_HTML
+ * \param name element name to look for
+ * \return true if an element was found or on error, else false
+ */
+static bool box_construct_document_has(html_content *c, dom_string *name)
+{
+	dom_nodelist *nlist;
+	dom_exception exc;
+	uint32_t length;
+
+	exc = dom_document_get_elements_by_tag_name(c->document, name, &nlist);
+	if (exc != DOM_NO_ERR)
+		return true;
+
+	exc = dom_nodelist_get_length(nlist, &length);
+	dom_nodelist_unref(nlist);
+	if (exc != DOM_NO_ERR)
+		return true;
+
+	return length != 0;
+}
+
+
 /* exported function documented in html/box_construct.h */
 nserror
 dom_to_box(dom_node *n,
 	   html_content *c,
 	   box_construct_complete_cb cb,
+	   box_construct_progress_cb progress_cb,
 	   void **box_conversion_context)
 {
 	struct box_construct_ctx *ctx;
+	uint64_t now;
 
 	assert(box_conversion_context != NULL);
 
@@ -1334,6 +1667,25 @@ dom_to_box(dom_node *n,
 		}
 	}
 
+	if (c->box_arena == NULL) {
+		/* text and titles need no destructor, so are bump
+		 * allocated and released together with the box tree
+		 */
+		nserror err = arena_create(0, &c->box_arena);
+		if (err != NSERROR_OK) {
+			return err;
+		}
+	}
+
+	if (c->link_base == NULL) {
+		/* prepare the base URL for resolving the document's links */
+		nserror err = nsurl_join_base_create(c->base_url,
+				&c->link_base);
+		if (err != NSERROR_OK) {
+			return err;
+		}
+	}
+
 	ctx = malloc(sizeof(*ctx));
 	if (ctx == NULL) {
 		return NSERROR_NOMEM;
@@ -1343,7 +1695,25 @@ dom_to_box(dom_node *n,
 	ctx->n = dom_node_ref(n);
 	ctx->root_box = NULL;
 	ctx->cb = cb;
+	ctx->progress_cb = progress_cb;
+	ctx->render_period = nsoption_uint(progressive_render_period) * 10;
+	ctx->tails = NULL;
+	ctx->tail_count = 0;
 	ctx->bctx = c->bctx;
+	ctx->arena = c->box_arena;
+
+	/* Frames are created by the browser window only once the
+	 * content is first displayed, so must all exist by then. */
+	if (ctx->render_period == 0 ||
+			box_construct_document_has(c,
+					corestring_dom_frameset) ||
+			box_construct_document_has(c,
+					corestring_dom_iframe)) {
+		ctx->progress_cb = NULL;
+	}
+
+	nsu_getmonotonic_ms(&now);
+	ctx->render_time = now + ctx->render_period;
 
 	*box_conversion_context = ctx;
 
@@ -1363,7 +1733,7 @@ nserror cancel_dom_to_box(void *box_conversion_context)
 	}
 
 	dom_node_unref(ctx->n);
-	free(ctx);
+	box_construct_ctx_destroy(ctx);
 
 	return NSERROR_OK;
 }
@@ -1442,7 +1812,11 @@ box_extract_link(const html_content *content,
 	}
 
 	/* construct absolute URL */
-	error = nsurl_join(base, s1, result);
+	if (content->link_base != NULL && base == content->base_url) {
+		error = nsurl_join_prepared(content->link_base, s1, result);
+	} else {
+		error = nsurl_join(base, s1, result);
+	}
 	free(s);
 	if (error != NSERROR_OK) {
 		*result = NULL;
@@ -75,13 +75,20 @@
 /**
  * Construct a box tree from a dom and html content
  *
+ * While a large document is converted, the box tree built so far is
+ * periodically normalised and passed to \a progress_cb so it can be
+ * displayed. Between conversion slices the tree is then left exactly as
+ * it was displayed; boxes constructed since are hidden until the next
+ * update.
+ *
  * \param n dom document
  * \param c content of type CONTENT_HTML to construct box tree in
  * \param cb callback to report conversion completion
+ * \param progress_cb callback to display a partial box tree, or NULL
  * \param box_conversion_context pointer that recives the conversion context
  * \return netsurf error code indicating status of call
  */
-nserror dom_to_box(struct dom_node *n, struct html_content *c, box_construct_complete_cb cb, void **box_conversion_context);
+nserror dom_to_box(struct dom_node *n, struct html_content *c, box_construct_complete_cb cb, box_construct_progress_cb progress_cb, void **box_conversion_context);
 
 
 /**
@@ -578,6 +578,63 @@ void box_bounds(struct box *box, struct rect *r)
 }
 
 
+/**
+ * Skip the following siblings of a box which can not contain a point.
+ *
+ * Uses the spatial index of the box's parent to step over whole runs of
+ * children whose area does not include the point.  Walking on from the
+ * returned box, without visiting its children, reaches the same boxes
+ * containing the point as walking on from the given box.
+ *
+ * \param  b      box not containing the point
+ * \param  x      point, in global coordinates
+ * \param  y      point, in global coordinates
+ * \param  box_x  box's global x-coord, updated to position of returned box
+ * \param  box_y  box's global y-coord, updated to position of returned box
+ * \return  box to continue walking from
+ */
+static struct box *
+box_skip_child_runs(struct box *b, int x, int y, int *box_x, int *box_y)
+{
+	const struct box_child_run *runs;
+	struct box *last;
+	unsigned int count;
+	unsigned int i;
+
+	if (b->parent == NULL || b->parent->extra == NULL ||
+			b->parent->extra->child_runs == NULL ||
+			box_is_float(b))
+		return b;
+
+	runs = b->parent->extra->child_runs;
+	count = b->parent->extra->child_run_count;
+	i = b->child_run;
+
+	/* Only skip from the end of a run; the rest of this run may
+	 * contain the point. */
+	if (runs[i].last != b)
+		return b;
+
+	/* point relative to parent */
+	x -= *box_x - b->x;
+	y -= *box_y - b->y;
+
+	last = b;
+	for (i++; i < count; i++) {
+		if (runs[i].x0 <= x && x < runs[i].x1 &&
+				runs[i].y0 <= y && y < runs[i].y1)
+			break;
+		if (runs[i].last != NULL)
+			last = runs[i].last;
+	}
+
+	*box_x += last->x - b->x;
+	*box_y += last->y - b->y;
+
+	return last;
+}
+
+
 /* Exported function documented in html/box.h */
 struct box *
 box_at_point(const css_unit_ctx *unit_len_ctx,
@@ -590,6 +647,11 @@ box_at_point(const css_unit_ctx *unit_len_ctx,
 
 	assert(box);
 
+	if (box->flags & LAYOUT_ESTIMATED) {
+		/* Children have not been laid out */
+		return NULL;
+	}
+
 	skip_children = false;
 	while ((box = box_next_xy(box, box_x, box_y, skip_children))) {
 		if (box_contains_point(unit_len_ctx, box, x - *box_x, y - *box_y,
@@ -600,9 +662,10 @@ box_at_point(const css_unit_ctx *unit_len_ctx,
 			if (physically)
 				return box;
 
-			skip_children = false;
+			skip_children = (box->flags & LAYOUT_ESTIMATED) != 0;
 		} else {
 			skip_children = true;
+			box = box_skip_child_runs(box, x, y, box_x, box_y);
 		}
 	}
 
@@ -746,7 +809,7 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 		fprintf(stream, "(object '%s') ",
 			nsurl_access(hlcache_handle_get_url(box->object)));
 	}
-	if (box->iframe) {
+	if (box_get_iframe(box)) {
 		fprintf(stream, "(iframe) ");
 	}
 	if (box->gadget)
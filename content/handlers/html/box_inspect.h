@@ -139,6 +139,39 @@ static inline bool box_is_first_child(struct box *b)
 	return (b->parent == NULL || b == b->parent->children);
 }
 
+/**
+ * Get the browser window of an iframe box.
+ *
+ * \param[in] b  Box to check.
+ * \return iframe's browser window, or NULL if none.
+ */
+static inline struct browser_window *box_get_iframe(const struct box *b)
+{
+	return (b->extra != NULL) ? b->extra->iframe : NULL;
+}
+
+/**
+ * Get the name of the image map used by a box.
+ *
+ * \param[in] b  Box to check.
+ * \return map name, or NULL if none.
+ */
+static inline const char *box_get_usemap(const struct box *b)
+{
+	return (b->extra != NULL) ? b->extra->usemap : NULL;
+}
+
+/**
+ * Get the object parameters of a box.
+ *
+ * \param[in] b  Box to check.
+ * \return object parameters, or NULL if none.
+ */
+static inline struct object_params *box_get_object_params(const struct box *b)
+{
+	return (b->extra != NULL) ? b->extra->object_params : NULL;
+}
+
 static inline unsigned box_count_children(const struct box *b)
 {
 	const struct box *c = b->children;
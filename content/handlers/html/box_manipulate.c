@@ -107,7 +107,7 @@ box_create(css_select_results *styles,
 	talloc_set_destructor(box, box_talloc_destructor);
 
 	box->type = BOX_INLINE;
-	box->flags = 0;
+	box->flags = NEEDS_LAYOUT;
 	box->flags = style_owned ? (box->flags | STYLE_OWNED) : box->flags;
 	box->styles = styles;
 	box->style = style;
@@ -116,11 +116,13 @@ box_create(css_select_results *styles,
 	box->height = 0;
 	box->descendant_x0 = box->descendant_y0 = 0;
 	box->descendant_x1 = box->descendant_y1 = 0;
+	box->child_run = 0;
 	for (i = 0; i != 4; i++)
 		box->margin[i] = box->padding[i] = box->border[i].width = 0;
 	box->scroll_x = box->scroll_y = NULL;
 	box->min_width = 0;
 	box->max_width = UNKNOWN_MAX_WIDTH;
+	box->layout_cache.avail_width = UNKNOWN_WIDTH;
 	box->byte_offset = 0;
 	box->text = NULL;
 	box->length = 0;
@@ -145,12 +147,10 @@ box_create(css_select_results *styles,
 	box->list_marker = NULL;
 	box->col = NULL;
 	box->gadget = NULL;
-	box->usemap = NULL;
 	box->id = id;
 	box->background = NULL;
 	box->object = NULL;
-	box->object_params = NULL;
-	box->iframe = NULL;
+	box->extra = NULL;
 	box->node = NULL;
 
 	return box;
@@ -190,6 +190,45 @@ void box_insert_sibling(struct box *box, struct box *new_box)
 }
 
 
+/* Exported function documented in html/box_manipulate.h */
+void box_mark_dirty(struct box *box, bool minmax)
+{
+	for (; box != NULL; box = box->parent) {
+		box->flags |= NEEDS_LAYOUT;
+		if (minmax)
+			box->max_width = UNKNOWN_MAX_WIDTH;
+	}
+}
+
+
+/* Exported function documented in html/box_manipulate.h */
+struct box_extra *box_get_extra(struct box *box)
+{
+	if (box->extra == NULL) {
+		box->extra = talloc_zero(box, struct box_extra);
+	}
+
+	return box->extra;
+}
+
+
+/* Exported function documented in html/box_manipulate.h */
+nserror box_set_iframe(struct box *box, struct browser_window *iframe)
+{
+	if (iframe == NULL && box->extra == NULL) {
+		/* nothing to unset */
+		return NSERROR_OK;
+	}
+
+	if (box_get_extra(box) == NULL) {
+		return NSERROR_NOMEM;
+	}
+	box->extra->iframe = iframe;
+
+	return NSERROR_OK;
+}
+
+
 /* Exported function documented in html/box.h */
 void box_unlink_and_free(struct box *box)
 {
@@ -63,6 +63,38 @@ void box_add_child(struct box *parent, struct box *child);
 void box_insert_sibling(struct box *box, struct box *new_box);
 
 
+/**
+ * Mark a box as changed since it was last laid out.
+ *
+ * The box and its ancestors are flagged as needing layout, so the next
+ * layout will not reuse their previous results.
+ *
+ * \param box	  box which changed
+ * \param minmax  true if the box's minimum and maximum widths may also
+ *		  have changed and need recalculating
+ */
+void box_mark_dirty(struct box *box, bool minmax);
+
+
+/**
+ * Get the rarely used data of a box, creating it if necessary.
+ *
+ * \param box  box to get data of
+ * \return  the box's extra data, or NULL on memory exhaustion
+ */
+struct box_extra *box_get_extra(struct box *box);
+
+
+/**
+ * Set the browser window of an iframe box.
+ *
+ * \param box     box to set the browser window of
+ * \param iframe  the iframe's browser window, or NULL to unset
+ * \return NSERROR_OK on success, or NSERROR_NOMEM on memory exhaustion
+ */
+nserror box_set_iframe(struct box *box, struct browser_window *iframe);
+
+
 /**
  * Unlink a box from the box tree and then free it recursively.
  *
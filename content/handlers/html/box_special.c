@@ -550,6 +550,37 @@ box_get_attribute(dom_node *n,
 }
 
 
+/**
+ * Record the image map named by an element's usemap attribute.
+ *
+ * \param  n	     dom element node
+ * \param  content  html content being converted
+ * \param  box      box for the element
+ * \return  true on success, false on memory exhaustion
+ */
+static bool
+box_set_usemap(dom_node *n, html_content *content, struct box *box)
+{
+	struct box_extra *extra;
+	char *usemap = NULL;
+
+	if (!box_get_attribute(n, "usemap", content->bctx, &usemap))
+		return false;
+	if (usemap == NULL)
+		return true;
+	if (usemap[0] == '#')
+		usemap++;
+
+	extra = box_get_extra(box);
+	if (extra == NULL)
+		return false;
+
+	extra->usemap = usemap;
+
+	return true;
+}
+
+
 /**
  * Helper function for adding textarea widget to box.
  *
@@ -971,7 +1002,9 @@ box_embed(dom_node *n,
 
 	dom_namednodemap_unref(attrs);
 
-	box->object_params = params;
+	if (box_get_extra(box) == NULL)
+		return false;
+	box->extra->object_params = params;
 
 	/* start fetch */
 	box->flags |= IS_REPLACED;
@@ -1063,6 +1096,12 @@ box_iframe(dom_node *n,
 		return true;
 	}
 
+	/* the iframe's browser window is recorded in the box's extra data */
+	if (box_get_extra(box) == NULL) {
+		nsurl_unref(url);
+		return false;
+	}
+
 	/* create a new iframe */
 	iframe = talloc(content->bctx, struct content_html_iframe);
 	if (iframe == NULL) {
@@ -1185,10 +1224,8 @@ box_image(dom_node *n,
 	}
 
 	/* imagemap associated with this image */
-	if (!box_get_attribute(n, "usemap", content->bctx, &box->usemap))
+	if (!box_set_usemap(n, content, box))
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	/* get image URL */
 	err = dom_element_get_attribute(n, corestring_dom_src, &s);
@@ -1416,11 +1453,8 @@ box_object(dom_node *n,
 			box_is_root(n)) == CSS_DISPLAY_NONE)
 		return true;
 
-	if (box_get_attribute(n, "usemap", content->bctx, &box->usemap) ==
-			false)
+	if (box_set_usemap(n, content, box) == false)
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	params = talloc(content->bctx, struct object_params);
 	if (params == NULL)
@@ -1624,7 +1658,9 @@ box_object(dom_node *n,
 		c = next;
 	}
 
-	box->object_params = params;
+	if (box_get_extra(box) == NULL)
+		return false;
+	box->extra->object_params = params;
 
 	/* start fetch (MIME type is ok or not specified) */
 	box->flags |= IS_REPLACED;
@@ -0,0 +1,1049 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * HTML display list implementation.
+ *
+ * Recording redraws the box tree through a plotter table which appends
+ * each operation, with the area it can affect, to a flat array of
+ * entries. Variable length data (polygon points, paths and text) is
+ * copied into an arena which is released with the recording.
+ *
+ * Clip operations are entries too, and a replay applies them lazily,
+ * only when an operation inside them is actually plotted. Every run of
+ * DISPLAY_LIST_CHUNK entries also has the union of their areas, so that
+ * whole runs outside the redraw clip are skipped at once.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/arena.h"
+#include "utils/log.h"
+#include "netsurf/inttypes.h"
+#include "netsurf/types.h"
+#include "netsurf/plot_style.h"
+#include "netsurf/plotters.h"
+#include "netsurf/content.h"
+
+#include "html/box.h"
+#include "html/display_list.h"
+
+/** Number of entries covered by the area of a chunk */
+#define DISPLAY_LIST_CHUNK 64
+
+/** Extent of the coordinate space recorded */
+#define DISPLAY_LIST_LIMIT 0x10000000
+
+/** Number of polygon coordinates translated without an allocation */
+#define DISPLAY_LIST_POLYGON_BUFFER 32
+
+/**
+ * Display list entry operations
+ */
+enum display_list_op {
+	DISPLAY_LIST_CLIP, /**< Set clip rectangle */
+	DISPLAY_LIST_RECTANGLE, /**< Plot rectangle */
+	DISPLAY_LIST_LINE, /**< Plot line */
+	DISPLAY_LIST_POLYGON, /**< Plot polygon */
+	DISPLAY_LIST_PATH, /**< Plot path */
+	DISPLAY_LIST_ARC, /**< Plot arc */
+	DISPLAY_LIST_DISC, /**< Plot disc */
+	DISPLAY_LIST_TEXT, /**< Plot text */
+	DISPLAY_LIST_LIVE, /**< Redraw from the box tree */
+	DISPLAY_LIST_CONTENT, /**< Redraw another content */
+};
+
+/**
+ * Display list entry
+ */
+struct display_list_entry {
+	enum display_list_op op; /**< Operation */
+	bool text; /**< Entry plots the text of a live text entry */
+	struct rect extent; /**< Area the entry may draw in */
+	union {
+		struct rect clip;
+		struct {
+			plot_style_t style;
+			struct rect rect;
+		} shape; /**< rectangle and line */
+		struct {
+			plot_style_t style;
+			int *p;
+			unsigned int n;
+		} polygon;
+		struct {
+			plot_style_t style;
+			float *p;
+			unsigned int n;
+			float transform[6];
+		} path;
+		struct {
+			plot_style_t style;
+			int x;
+			int y;
+			int radius;
+			int angle1;
+			int angle2;
+		} arc; /**< arc and disc */
+		struct {
+			plot_font_style_t fstyle;
+			int x;
+			int y;
+			char *text;
+			size_t length;
+		} text;
+		struct {
+			struct html_display_list_box box;
+			struct rect clip;
+		} live;
+		struct {
+			struct hlcache_handle *h;
+			struct content_redraw_data data;
+			struct rect clip;
+		} content;
+	} u;
+};
+
+/**
+ * Summary of a run of DISPLAY_LIST_CHUNK entries
+ */
+struct display_list_chunk {
+	struct rect extent; /**< Union of the entries' areas */
+	int clip; /**< Index of the clip in effect after the run, or -1 */
+};
+
+/**
+ * Display list state
+ */
+enum display_list_state {
+	DISPLAY_LIST_INVALID, /**< Nothing recorded */
+	DISPLAY_LIST_RECORDING, /**< Recording in progress */
+	DISPLAY_LIST_VALID, /**< Recording may be replayed */
+	DISPLAY_LIST_FAILED, /**< Recording failed; do not try again */
+};
+
+/**
+ * HTML display list
+ */
+struct html_display_list {
+	enum display_list_state state; /**< Current state */
+	bool failed; /**< An operation could not be recorded */
+	colour background; /**< Background colour the recording began with */
+
+	struct display_list_entry *entries; /**< Recorded entries */
+	size_t count; /**< Number of entries in use */
+	size_t alloc; /**< Number of entries allocated */
+
+	struct display_list_chunk *chunks; /**< Chunk summaries */
+	size_t chunk_alloc; /**< Number of chunk summaries allocated */
+
+	struct arena *arena; /**< Variable length entry data */
+
+	/** Clip rectangle in effect while recording */
+	struct rect clip;
+
+	struct box *text_box; /**< Box whose text is being recorded */
+	int text_x; /**< X coordinate of text_box */
+	int text_y; /**< Y coordinate of text_box */
+};
+
+
+/**
+ * Determine if two rectangles intersect
+ */
+static inline bool
+display_list_intersects(const struct rect *a, const struct rect *b)
+{
+	return a->x0 < b->x1 && b->x0 < a->x1 &&
+		a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+
+/**
+ * Intersect a rectangle with another
+ *
+ * \param r     Rectangle to update
+ * \param clip  Rectangle to intersect with
+ * \return true if the intersection is not empty
+ */
+static inline bool
+display_list_intersect(struct rect *r, const struct rect *clip)
+{
+	if (r->x0 < clip->x0) r->x0 = clip->x0;
+	if (r->y0 < clip->y0) r->y0 = clip->y0;
+	if (r->x1 > clip->x1) r->x1 = clip->x1;
+	if (r->y1 > clip->y1) r->y1 = clip->y1;
+
+	return r->x0 < r->x1 && r->y0 < r->y1;
+}
+
+
+/**
+ * Append an entry to a display list being recorded
+ *
+ * Entries which can not draw inside the recording clip are dropped.
+ *
+ * \param list    Display list being recorded
+ * \param op      Operation of the entry
+ * \param extent  Area the entry may draw in, clipped on return
+ * \return The new entry, or NULL if dropped or on memory exhaustion
+ */
+static struct display_list_entry *
+display_list_append(struct html_display_list *list,
+		enum display_list_op op, const struct rect *extent)
+{
+	struct display_list_entry *e;
+
+	if (list->count == list->alloc) {
+		size_t alloc = list->alloc != 0 ? list->alloc * 2 : 256;
+
+		e = realloc(list->entries, alloc * sizeof(*e));
+		if (e == NULL) {
+			list->failed = true;
+			return NULL;
+		}
+		list->entries = e;
+		list->alloc = alloc;
+	}
+
+	e = &list->entries[list->count];
+	e->op = op;
+	e->text = (list->text_box != NULL);
+	e->extent = *extent;
+	if (op != DISPLAY_LIST_CLIP &&
+			!display_list_intersect(&e->extent, &list->clip)) {
+		return NULL;
+	}
+	list->count++;
+
+	return e;
+}
+
+
+/**
+ * Extend the area of a shape by the width of its stroke
+ */
+static void
+display_list_stroke(struct rect *extent, const plot_style_t *pstyle)
+{
+	int width = 1;
+
+	if (pstyle->stroke_type != PLOT_OP_TYPE_NONE) {
+		width += plot_style_fixed_to_int(pstyle->stroke_width);
+	}
+	extent->x0 -= width;
+	extent->y0 -= width;
+	extent->x1 += width;
+	extent->y1 += width;
+}
+
+
+/**
+ * Recording plotter: set clip rectangle
+ */
+static nserror
+display_list_clip(const struct redraw_context *ctx, const struct rect *clip)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+
+	list->clip = *clip;
+
+	/* a clip with nothing plotted in it need not be kept */
+	if (list->count != 0 &&
+			list->entries[list->count - 1].op == DISPLAY_LIST_CLIP) {
+		list->entries[list->count - 1].u.clip = *clip;
+		return NSERROR_OK;
+	}
+
+	e = display_list_append(list, DISPLAY_LIST_CLIP, clip);
+	if (e == NULL) {
+		return NSERROR_NOMEM;
+	}
+	e->u.clip = *clip;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot an arc segment
+ */
+static nserror
+display_list_arc(const struct redraw_context *ctx,
+		const plot_style_t *pstyle,
+		int x, int y, int radius, int angle1, int angle2)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent = {
+		x - radius, y - radius, x + radius, y + radius
+	};
+
+	display_list_stroke(&extent, pstyle);
+	e = display_list_append(list, DISPLAY_LIST_ARC, &extent);
+	if (e != NULL) {
+		e->u.arc.style = *pstyle;
+		e->u.arc.x = x;
+		e->u.arc.y = y;
+		e->u.arc.radius = radius;
+		e->u.arc.angle1 = angle1;
+		e->u.arc.angle2 = angle2;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a circle
+ */
+static nserror
+display_list_disc(const struct redraw_context *ctx,
+		const plot_style_t *pstyle, int x, int y, int radius)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent = {
+		x - radius, y - radius, x + radius, y + radius
+	};
+
+	display_list_stroke(&extent, pstyle);
+	e = display_list_append(list, DISPLAY_LIST_DISC, &extent);
+	if (e != NULL) {
+		e->u.arc.style = *pstyle;
+		e->u.arc.x = x;
+		e->u.arc.y = y;
+		e->u.arc.radius = radius;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a line
+ */
+static nserror
+display_list_line(const struct redraw_context *ctx,
+		const plot_style_t *pstyle, const struct rect *line)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent = {
+		line->x0 < line->x1 ? line->x0 : line->x1,
+		line->y0 < line->y1 ? line->y0 : line->y1,
+		line->x0 < line->x1 ? line->x1 : line->x0,
+		line->y0 < line->y1 ? line->y1 : line->y0
+	};
+
+	display_list_stroke(&extent, pstyle);
+	e = display_list_append(list, DISPLAY_LIST_LINE, &extent);
+	if (e != NULL) {
+		e->u.shape.style = *pstyle;
+		e->u.shape.rect = *line;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a rectangle
+ */
+static nserror
+display_list_rectangle(const struct redraw_context *ctx,
+		const plot_style_t *pstyle, const struct rect *rectangle)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent = *rectangle;
+
+	display_list_stroke(&extent, pstyle);
+	e = display_list_append(list, DISPLAY_LIST_RECTANGLE, &extent);
+	if (e != NULL) {
+		e->u.shape.style = *pstyle;
+		e->u.shape.rect = *rectangle;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a polygon
+ */
+static nserror
+display_list_polygon(const struct redraw_context *ctx,
+		const plot_style_t *pstyle, const int *p, unsigned int n)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent;
+	unsigned int i;
+
+	if (n == 0) {
+		return NSERROR_OK;
+	}
+
+	extent.x0 = extent.x1 = p[0];
+	extent.y0 = extent.y1 = p[1];
+	for (i = 1; i < n; i++) {
+		if (p[i * 2] < extent.x0) extent.x0 = p[i * 2];
+		if (p[i * 2] > extent.x1) extent.x1 = p[i * 2];
+		if (p[i * 2 + 1] < extent.y0) extent.y0 = p[i * 2 + 1];
+		if (p[i * 2 + 1] > extent.y1) extent.y1 = p[i * 2 + 1];
+	}
+
+	display_list_stroke(&extent, pstyle);
+	e = display_list_append(list, DISPLAY_LIST_POLYGON, &extent);
+	if (e != NULL) {
+		e->u.polygon.style = *pstyle;
+		e->u.polygon.n = n;
+		e->u.polygon.p = arena_alloc(list->arena, n * 2 * sizeof(int));
+		if (e->u.polygon.p == NULL) {
+			list->count--;
+			list->failed = true;
+		} else {
+			memcpy(e->u.polygon.p, p, n * 2 * sizeof(int));
+		}
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a path
+ *
+ * Path coordinates are not examined, so the path may draw anywhere
+ * inside the clip.
+ */
+static nserror
+display_list_path(const struct redraw_context *ctx,
+		const plot_style_t *pstyle,
+		const float *p, unsigned int n,
+		const float transform[6])
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+
+	e = display_list_append(list, DISPLAY_LIST_PATH, &list->clip);
+	if (e != NULL) {
+		e->u.path.style = *pstyle;
+		e->u.path.n = n;
+		memcpy(e->u.path.transform, transform,
+				sizeof(e->u.path.transform));
+		e->u.path.p = arena_alloc(list->arena, n * sizeof(float));
+		if (e->u.path.p == NULL) {
+			list->count--;
+			list->failed = true;
+		} else {
+			memcpy(e->u.path.p, p, n * sizeof(float));
+		}
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Recording plotter: plot a bitmap
+ *
+ * Every bitmap in a document belongs to a live entry, so this is only
+ * reached by a redraw path the display list does not support.
+ */
+static nserror
+display_list_bitmap(const struct redraw_context *ctx,
+		struct bitmap *bitmap,
+		int x, int y, int width, int height,
+		colour bg, bitmap_flags_t flags)
+{
+	struct html_display_list *list = ctx->priv;
+
+	list->failed = true;
+
+	return NSERROR_NOT_IMPLEMENTED;
+}
+
+
+/**
+ * Recording plotter: plot text
+ */
+static nserror
+display_list_text(const struct redraw_context *ctx,
+		const plot_font_style_t *fstyle,
+		int x, int y, const char *text, size_t length)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent;
+
+	if (list->text_box != NULL) {
+		/* the text box, allowing for glyphs overhanging it */
+		int slack = list->text_box->height;
+
+		extent.x0 = list->text_x - slack;
+		extent.y0 = list->text_y - slack;
+		extent.x1 = list->text_x + list->text_box->width + slack;
+		extent.y1 = list->text_y + list->text_box->height + slack;
+	} else {
+		/* the width is unknown without measuring the text */
+		int size = plot_style_fixed_to_int(fstyle->size * 2);
+
+		extent.x0 = x - size;
+		extent.y0 = y - size;
+		extent.x1 = list->clip.x1;
+		extent.y1 = y + size;
+	}
+
+	e = display_list_append(list, DISPLAY_LIST_TEXT, &extent);
+	if (e != NULL) {
+		e->u.text.fstyle = *fstyle;
+		e->u.text.x = x;
+		e->u.text.y = y;
+		e->u.text.length = length;
+		e->u.text.text = arena_strndup(list->arena, text, length);
+		if (e->u.text.text == NULL) {
+			list->count--;
+			list->failed = true;
+		}
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Plotter table used to record display lists
+ */
+static const struct plotter_table display_list_plotters = {
+	.clip = display_list_clip,
+	.arc = display_list_arc,
+	.disc = display_list_disc,
+	.line = display_list_line,
+	.rectangle = display_list_rectangle,
+	.polygon = display_list_polygon,
+	.path = display_list_path,
+	.bitmap = display_list_bitmap,
+	.text = display_list_text,
+	.option_knockout = false,
+};
+
+
+/**
+ * Release a display list's recording
+ */
+static void display_list_discard(struct html_display_list *list)
+{
+	arena_destroy(list->arena);
+	list->arena = NULL;
+	list->count = 0;
+	list->failed = false;
+	list->text_box = NULL;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_create(struct html_display_list **list_out)
+{
+	struct html_display_list *list;
+
+	list = calloc(1, sizeof(*list));
+	if (list == NULL) {
+		return NSERROR_NOMEM;
+	}
+	list->state = DISPLAY_LIST_INVALID;
+
+	*list_out = list;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_destroy(struct html_display_list *list)
+{
+	if (list == NULL) {
+		return;
+	}
+
+	display_list_discard(list);
+	free(list->entries);
+	free(list->chunks);
+	free(list);
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_invalidate(struct html_display_list *list)
+{
+	if (list == NULL || list->state == DISPLAY_LIST_INVALID) {
+		return;
+	}
+
+	display_list_discard(list);
+	list->state = DISPLAY_LIST_INVALID;
+}
+
+
+/* exported interface documented in html/display_list.h */
+bool html_display_list_valid(const struct html_display_list *list,
+		colour background)
+{
+	return list->state == DISPLAY_LIST_VALID &&
+		list->background == background;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_record_start(struct html_display_list *list,
+		colour background, struct redraw_context *ctx,
+		struct rect *clip)
+{
+	nserror res;
+
+	if (list->state == DISPLAY_LIST_FAILED) {
+		return NSERROR_NOT_IMPLEMENTED;
+	}
+
+	display_list_discard(list);
+
+	res = arena_create(0, &list->arena);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	list->state = DISPLAY_LIST_RECORDING;
+	list->background = background;
+
+	clip->x0 = -DISPLAY_LIST_LIMIT;
+	clip->y0 = -DISPLAY_LIST_LIMIT;
+	clip->x1 = DISPLAY_LIST_LIMIT;
+	clip->y1 = DISPLAY_LIST_LIMIT;
+	list->clip = *clip;
+
+	ctx->interactive = false;
+	ctx->background_images = true;
+	ctx->plot = &display_list_plotters;
+	ctx->priv = list;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_record_end(struct html_display_list *list,
+		bool success)
+{
+	struct display_list_chunk *chunk = NULL;
+	size_t chunks;
+	size_t used;
+	size_t i;
+	int clip = -1;
+
+	if (!success || list->failed) {
+		NSLOG(netsurf, INFO, "Display list recording failed");
+		display_list_discard(list);
+		list->state = DISPLAY_LIST_FAILED;
+		return NSERROR_NOT_IMPLEMENTED;
+	}
+
+	chunks = (list->count + DISPLAY_LIST_CHUNK - 1) / DISPLAY_LIST_CHUNK;
+	if (chunks > list->chunk_alloc) {
+		chunk = realloc(list->chunks, chunks * sizeof(*chunk));
+		if (chunk == NULL) {
+			display_list_discard(list);
+			list->state = DISPLAY_LIST_INVALID;
+			return NSERROR_NOMEM;
+		}
+		list->chunks = chunk;
+		list->chunk_alloc = chunks;
+	}
+
+	for (i = 0; i < list->count; i++) {
+		const struct display_list_entry *e = &list->entries[i];
+
+		if (i % DISPLAY_LIST_CHUNK == 0) {
+			chunk = &list->chunks[i / DISPLAY_LIST_CHUNK];
+			chunk->extent.x0 = chunk->extent.y0 = DISPLAY_LIST_LIMIT;
+			chunk->extent.x1 = chunk->extent.y1 = -DISPLAY_LIST_LIMIT;
+		}
+
+		if (e->op == DISPLAY_LIST_CLIP) {
+			clip = i;
+		} else {
+			if (e->extent.x0 < chunk->extent.x0)
+				chunk->extent.x0 = e->extent.x0;
+			if (e->extent.y0 < chunk->extent.y0)
+				chunk->extent.y0 = e->extent.y0;
+			if (e->extent.x1 > chunk->extent.x1)
+				chunk->extent.x1 = e->extent.x1;
+			if (e->extent.y1 > chunk->extent.y1)
+				chunk->extent.y1 = e->extent.y1;
+		}
+		chunk->clip = clip;
+	}
+
+	list->text_box = NULL;
+	list->state = DISPLAY_LIST_VALID;
+
+	arena_stats(list->arena, &used, NULL);
+	NSLOG(netsurf, DEBUG, "Display list of %"PRIsizet" entries, "
+	      "%"PRIsizet" bytes of data", list->count, used);
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+bool html_display_list_recording(const struct redraw_context *ctx)
+{
+	return ctx->plot == &display_list_plotters;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_live(const struct redraw_context *ctx,
+		enum html_display_list_live kind, struct box *box,
+		int x, int y, const struct rect *extent,
+		const struct rect *clip, colour background)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect r = *extent;
+
+	if (!display_list_intersect(&r, clip)) {
+		return NSERROR_OK;
+	}
+
+	e = display_list_append(list, DISPLAY_LIST_LIVE, &r);
+	if (e != NULL) {
+		e->text = false;
+		e->u.live.box.kind = kind;
+		e->u.live.box.box = box;
+		e->u.live.box.x = x;
+		e->u.live.box.y = y;
+		e->u.live.box.background = background;
+		e->u.live.clip = *clip;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_text_box(const struct redraw_context *ctx,
+		struct box *box, int x, int y, colour background)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+	struct rect extent;
+	int slack;
+
+	list->text_box = NULL;
+	if (box == NULL) {
+		return;
+	}
+
+	/* the text box, allowing for glyphs overhanging it */
+	slack = box->height;
+	extent.x0 = x - slack;
+	extent.y0 = y - slack;
+	extent.x1 = x + box->width + slack;
+	extent.y1 = y + box->height + slack;
+
+	e = display_list_append(list, DISPLAY_LIST_LIVE, &extent);
+	if (e != NULL) {
+		e->u.live.box.kind = HTML_DISPLAY_LIST_LIVE_TEXT;
+		e->u.live.box.box = box;
+		e->u.live.box.x = x;
+		e->u.live.box.y = y;
+		e->u.live.box.background = background;
+		e->u.live.clip = list->clip;
+	}
+
+	/* text outside the clip is dropped along with its live entry */
+	if (!list->failed) {
+		list->text_box = box;
+		list->text_x = x;
+		list->text_y = y;
+	}
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_content(const struct redraw_context *ctx,
+		struct hlcache_handle *h,
+		const struct content_redraw_data *data,
+		const struct rect *clip)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_list_entry *e;
+
+	e = display_list_append(list, DISPLAY_LIST_CONTENT, clip);
+	if (e != NULL) {
+		e->u.content.h = h;
+		e->u.content.data = *data;
+		e->u.content.clip = *clip;
+	}
+
+	return list->failed ? NSERROR_NOMEM : NSERROR_OK;
+}
+
+
+/**
+ * Translate a rectangle
+ */
+static inline void
+display_list_translate(struct rect *r, const struct rect *from, int x, int y)
+{
+	r->x0 = from->x0 + x;
+	r->y0 = from->y0 + y;
+	r->x1 = from->x1 + x;
+	r->y1 = from->y1 + y;
+}
+
+
+/**
+ * Plot a polygon entry
+ */
+static nserror
+display_list_replay_polygon(const struct display_list_entry *e,
+		int x, int y, const struct redraw_context *ctx)
+{
+	int buffer[DISPLAY_LIST_POLYGON_BUFFER];
+	int *p = buffer;
+	unsigned int i;
+	nserror res;
+
+	if (e->u.polygon.n * 2 > DISPLAY_LIST_POLYGON_BUFFER) {
+		p = malloc(e->u.polygon.n * 2 * sizeof(int));
+		if (p == NULL) {
+			return NSERROR_NOMEM;
+		}
+	}
+
+	for (i = 0; i < e->u.polygon.n; i++) {
+		p[i * 2] = e->u.polygon.p[i * 2] + x;
+		p[i * 2 + 1] = e->u.polygon.p[i * 2 + 1] + y;
+	}
+
+	res = ctx->plot->polygon(ctx, &e->u.polygon.style, p, e->u.polygon.n);
+
+	if (p != buffer) {
+		free(p);
+	}
+
+	return res;
+}
+
+
+/**
+ * Plot a display list entry
+ *
+ * \param e     Entry to plot
+ * \param x     X coordinate of the document origin
+ * \param y     Y coordinate of the document origin
+ * \param clip  Clip rectangle in effect for the entry
+ * \param ctx   Redraw context
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror
+display_list_replay_entry(const struct display_list_entry *e,
+		int x, int y, const struct rect *clip,
+		const struct redraw_context *ctx)
+{
+	struct rect r;
+	float transform[6];
+
+	switch (e->op) {
+	case DISPLAY_LIST_RECTANGLE:
+		display_list_translate(&r, &e->u.shape.rect, x, y);
+		if (e->u.shape.style.stroke_type == PLOT_OP_TYPE_NONE &&
+				!display_list_intersect(&r, clip)) {
+			/* fills, such as backgrounds, may have been recorded
+			 * far larger than they will ever be plotted */
+			return NSERROR_OK;
+		}
+		return ctx->plot->rectangle(ctx, &e->u.shape.style, &r);
+
+	case DISPLAY_LIST_LINE:
+		display_list_translate(&r, &e->u.shape.rect, x, y);
+		return ctx->plot->line(ctx, &e->u.shape.style, &r);
+
+	case DISPLAY_LIST_POLYGON:
+		return display_list_replay_polygon(e, x, y, ctx);
+
+	case DISPLAY_LIST_PATH:
+		memcpy(transform, e->u.path.transform, sizeof(transform));
+		transform[4] += x;
+		transform[5] += y;
+		return ctx->plot->path(ctx, &e->u.path.style,
+				e->u.path.p, e->u.path.n, transform);
+
+	case DISPLAY_LIST_ARC:
+		return ctx->plot->arc(ctx, &e->u.arc.style,
+				e->u.arc.x + x, e->u.arc.y + y,
+				e->u.arc.radius,
+				e->u.arc.angle1, e->u.arc.angle2);
+
+	case DISPLAY_LIST_DISC:
+		return ctx->plot->disc(ctx, &e->u.arc.style,
+				e->u.arc.x + x, e->u.arc.y + y,
+				e->u.arc.radius);
+
+	case DISPLAY_LIST_TEXT:
+		return ctx->plot->text(ctx, &e->u.text.fstyle,
+				e->u.text.x + x, e->u.text.y + y,
+				e->u.text.text, e->u.text.length);
+
+	default:
+		break;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+bool html_display_list_replay(const struct html_display_list *list,
+		const struct html_content *html,
+		int x, int y,
+		const struct rect *clip,
+		bool live_text,
+		html_display_list_live_cb live,
+		const struct redraw_context *ctx)
+{
+	struct rect area; /* redraw clip in recorded coordinates */
+	struct rect current; /* clip in effect, in target coordinates */
+	bool current_valid = false;
+	int clip_index = -1;
+	size_t i = 0;
+
+	area.x0 = clip->x0 - x;
+	area.y0 = clip->y0 - y;
+	area.x1 = clip->x1 - x;
+	area.y1 = clip->y1 - y;
+
+	while (i < list->count) {
+		const struct display_list_entry *e;
+
+		if (i % DISPLAY_LIST_CHUNK == 0) {
+			const struct display_list_chunk *chunk;
+
+			chunk = &list->chunks[i / DISPLAY_LIST_CHUNK];
+			if (!display_list_intersects(&chunk->extent, &area)) {
+				/* nothing in this run needs plotting */
+				if (chunk->clip != clip_index) {
+					clip_index = chunk->clip;
+					current_valid = false;
+				}
+				i += DISPLAY_LIST_CHUNK;
+				continue;
+			}
+		}
+
+		e = &list->entries[i];
+		if (e->op == DISPLAY_LIST_CLIP) {
+			clip_index = i++;
+			current_valid = false;
+			continue;
+		}
+		i++;
+
+		if (live_text ? e->text :
+				(e->op == DISPLAY_LIST_LIVE &&
+				 e->u.live.box.kind ==
+				 HTML_DISPLAY_LIST_LIVE_TEXT)) {
+			continue;
+		}
+
+		if (!display_list_intersects(&e->extent, &area)) {
+			continue;
+		}
+
+		if (e->op == DISPLAY_LIST_LIVE ||
+				e->op == DISPLAY_LIST_CONTENT) {
+			struct html_display_list_box box;
+			struct content_redraw_data data;
+			struct rect r;
+
+			display_list_translate(&r, e->op == DISPLAY_LIST_LIVE ?
+					&e->u.live.clip : &e->u.content.clip,
+					x, y);
+			if (!display_list_intersect(&r, clip)) {
+				continue;
+			}
+			if (ctx->plot->clip(ctx, &r) != NSERROR_OK) {
+				return false;
+			}
+			current_valid = false;
+
+			if (e->op == DISPLAY_LIST_LIVE) {
+				box = e->u.live.box;
+				box.x += x;
+				box.y += y;
+				if (!live(html, &box, &r, ctx)) {
+					return false;
+				}
+			} else {
+				/* We just continue if redraw fails */
+				data = e->u.content.data;
+				data.x += x;
+				data.y += y;
+				content_redraw(e->u.content.h, &data, &r, ctx);
+			}
+			continue;
+		}
+
+		if (!current_valid) {
+			if (clip_index == -1) {
+				current = *clip;
+			} else {
+				display_list_translate(&current,
+						&list->entries[clip_index].u.clip,
+						x, y);
+				display_list_intersect(&current, clip);
+			}
+			if (current.x0 < current.x1 &&
+					current.y0 < current.y1 &&
+					ctx->plot->clip(ctx, &current) !=
+					NSERROR_OK) {
+				return false;
+			}
+			current_valid = true;
+		}
+
+		if (current.x0 >= current.x1 || current.y0 >= current.y1) {
+			/* clipped away entirely */
+			continue;
+		}
+
+		if (display_list_replay_entry(e, x, y, &current, ctx) !=
+				NSERROR_OK) {
+			return false;
+		}
+	}
+
+	/* leave the clip as the box tree redraw would */
+	return ctx->plot->clip(ctx, clip) == NSERROR_OK;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * HTML display list interface.
+ *
+ * A display list is a flat record, in paint order, of the plot
+ * operations made when a laid out box tree is redrawn. Replaying it
+ * plots only the operations which intersect the clip rectangle,
+ * without walking the box tree or converting computed styles.
+ *
+ * Anything whose appearance can change without a relayout is not
+ * recorded as plot operations. Instead the list holds a live entry
+ * that is redrawn from the box tree on every replay. These are the
+ * contents of replaced elements (objects, images, iframes, canvases
+ * and form controls), background images, scrollbars and the children
+ * of scrollable boxes. Text is recorded, but is redrawn live while a
+ * selection or search may highlight it.
+ */
+
+#ifndef NETSURF_HTML_DISPLAY_LIST_H
+#define NETSURF_HTML_DISPLAY_LIST_H
+
+#include <stdbool.h>
+
+#include "utils/errors.h"
+#include "netsurf/types.h"
+
+struct box;
+struct rect;
+struct hlcache_handle;
+struct html_content;
+struct redraw_context;
+struct content_redraw_data;
+struct html_display_list;
+
+/**
+ * Kinds of display list entry redrawn live from the box tree
+ */
+enum html_display_list_live {
+	/** Content of a replaced element or form control */
+	HTML_DISPLAY_LIST_LIVE_REPLACED,
+	/** Children of a scrollable box */
+	HTML_DISPLAY_LIST_LIVE_CHILDREN,
+	/** Scrollbars of a box */
+	HTML_DISPLAY_LIST_LIVE_SCROLLBARS,
+	/** Text of a box, redrawn live only while it may be highlighted */
+	HTML_DISPLAY_LIST_LIVE_TEXT,
+};
+
+/**
+ * A live display list entry
+ *
+ * The coordinates are the box's own for HTML_DISPLAY_LIST_LIVE_TEXT
+ * and its parent's for every other kind. They are translated to the
+ * replay origin before being passed to the live redraw callback.
+ */
+struct html_display_list_box {
+	enum html_display_list_live kind; /**< Kind of entry */
+	struct box *box; /**< Box to redraw */
+	int x; /**< X coordinate for the redraw */
+	int y; /**< Y coordinate for the redraw */
+	colour background; /**< Background colour under the box */
+};
+
+/**
+ * Callback to redraw a live display list entry from the box tree
+ *
+ * \param html  The HTML content being redrawn
+ * \param live  The live entry, translated to the replay origin
+ * \param clip  Clip rectangle in effect for the entry
+ * \param ctx   Redraw context
+ * \return true on success, false on failure
+ */
+typedef bool (*html_display_list_live_cb)(const struct html_content *html,
+		const struct html_display_list_box *live,
+		const struct rect *clip,
+		const struct redraw_context *ctx);
+
+/**
+ * Create an empty display list
+ *
+ * \param list_out  Updated to the new display list on success
+ * \return NSERROR_OK on success, NSERROR_NOMEM on memory exhaustion
+ */
+nserror html_display_list_create(struct html_display_list **list_out);
+
+/**
+ * Destroy a display list
+ *
+ * \param list  The display list to destroy, may be NULL
+ */
+void html_display_list_destroy(struct html_display_list *list);
+
+/**
+ * Discard the recording in a display list
+ *
+ * Must be called whenever the box tree, its layout or anything the
+ * recorded plot operations were made from changes.
+ *
+ * \param list  The display list to invalidate, may be NULL
+ */
+void html_display_list_invalidate(struct html_display_list *list);
+
+/**
+ * Determine if a display list holds a usable recording
+ *
+ * \param list        The display list
+ * \param background  Background colour the replay will start with
+ * \return true if the list can be replayed, false if it must be recorded
+ */
+bool html_display_list_valid(const struct html_display_list *list,
+		colour background);
+
+/**
+ * Start recording a display list
+ *
+ * Any previous recording is discarded. The box tree should be redrawn
+ * with the returned context and clip at scale 1 and an origin of
+ * (0, 0), and the recording then finished with
+ * html_display_list_record_end().
+ *
+ * \param list        The display list to record into
+ * \param background  Background colour the redraw starts with
+ * \param ctx         Updated to the redraw context to record with
+ * \param clip        Updated to the clip rectangle to record with
+ * \return NSERROR_OK on success, NSERROR_NOT_IMPLEMENTED if recording
+ *         failed since the list was last invalidated, or appropriate
+ *         error otherwise
+ */
+nserror html_display_list_record_start(struct html_display_list *list,
+		colour background, struct redraw_context *ctx,
+		struct rect *clip);
+
+/**
+ * Finish recording a display list
+ *
+ * \param list     The display list being recorded
+ * \param success  Whether the redraw being recorded succeeded
+ * \return NSERROR_OK if the list is now valid, appropriate error otherwise
+ */
+nserror html_display_list_record_end(struct html_display_list *list,
+		bool success);
+
+/**
+ * Determine if a redraw is being recorded into a display list
+ *
+ * \param ctx  Redraw context of the redraw
+ * \return true if the redraw is being recorded, false otherwise
+ */
+bool html_display_list_recording(const struct redraw_context *ctx);
+
+/**
+ * Record a live entry
+ *
+ * \param ctx         Recording redraw context
+ * \param kind        Kind of entry
+ * \param box         Box to redraw
+ * \param x           X coordinate for the redraw
+ * \param y           Y coordinate for the redraw
+ * \param extent      Area the entry may draw in
+ * \param clip        Clip rectangle in effect for the entry
+ * \param background  Background colour under the box
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+nserror html_display_list_live(const struct redraw_context *ctx,
+		enum html_display_list_live kind, struct box *box,
+		int x, int y, const struct rect *extent,
+		const struct rect *clip, colour background);
+
+/**
+ * Set the box which text subsequently recorded belongs to
+ *
+ * While set, recorded text is redrawn live as a
+ * HTML_DISPLAY_LIST_LIVE_TEXT entry when replayed with text highlights.
+ *
+ * \param ctx         Recording redraw context
+ * \param box         Box with text content, or NULL to clear
+ * \param x           X coordinate of the box
+ * \param y           Y coordinate of the box
+ * \param background  Background colour under the box
+ */
+void html_display_list_text_box(const struct redraw_context *ctx,
+		struct box *box, int x, int y, colour background);
+
+/**
+ * Record the redraw of another content
+ *
+ * The content is redrawn on every replay, as it may change without the
+ * document being laid out again.
+ *
+ * \param ctx   Recording redraw context
+ * \param h     Content to redraw
+ * \param data  Redraw data for the content
+ * \param clip  Clip rectangle for the redraw
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+nserror html_display_list_content(const struct redraw_context *ctx,
+		struct hlcache_handle *h,
+		const struct content_redraw_data *data,
+		const struct rect *clip);
+
+/**
+ * Replay a display list
+ *
+ * \param list       The display list to replay
+ * \param html       The HTML content the list was recorded from
+ * \param x          X coordinate of the document origin
+ * \param y          Y coordinate of the document origin
+ * \param clip       Clip rectangle to redraw
+ * \param live_text  Redraw text live, as it may be highlighted
+ * \param live       Callback to redraw live entries
+ * \param ctx        Redraw context
+ * \return true on success, false on failure
+ */
+bool html_display_list_replay(const struct html_display_list *list,
+		const struct html_content *html,
+		int x, int y,
+		const struct rect *clip,
+		bool live_text,
+		html_display_list_live_cb live,
+		const struct redraw_context *ctx);
+
+#endif
@@ -34,6 +34,7 @@
 #include "utils/nsurl.h"
 #include "content/content.h"
 #include "javascript/js.h"
+#include "css/select.h"
 
 #include "netsurf/bitmap.h"
 
@@ -72,6 +73,10 @@ static bool html_process_inserted_base(html_content *htmlc, dom_node *node)
 				nsurl_unref(htmlc->base_url);
 			}
 			htmlc->base_url = url;
+
+			/* Links must no longer resolve against the old base */
+			nsurl_join_base_destroy(htmlc->link_base);
+			htmlc->link_base = NULL;
 		}
 	}
 
@@ -709,6 +714,9 @@ dom_default_action_DOMSubtreeModified_cb(struct dom_event *evt, void *pw)
 	dom_exception exc;
 	html_content *htmlc = pw;
 
+	/* Styles selected before the change may no longer apply */
+	nscss_style_share_flush(htmlc->style_share);
+
 	exc = dom_event_get_target(evt, &node);
 	if ((exc == DOM_NO_ERR) && (node != NULL)) {
 		if (htmlc->title == (dom_node *)node) {
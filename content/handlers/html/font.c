@@ -22,8 +22,14 @@
  * HTML internal font handling implementation.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/errors.h"
 #include "utils/nsoption.h"
 #include "netsurf/plot_style.h"
+#include "netsurf/layout.h"
 #include "css/utils.h"
 
 #include "html/font.h"
@@ -163,3 +169,213 @@ void font_plot_style_from_css(
 	fstyle->foreground = nscss_color_to_ns(col);
 	fstyle->background = 0;
 }
+
+
+/** Number of entries in a text measurement cache; must be a power of two */
+#define FONT_MEASURE_CACHE_SIZE 1024
+
+/** Available width recorded for entries holding a width measurement */
+#define FONT_MEASURE_WIDTH -1
+
+/**
+ * Result of measuring or splitting some text in a font style.
+ */
+struct font_measure_entry {
+	const char *text; /**< Text measured, or NULL if unused */
+	size_t length; /**< Length of text, in bytes */
+	uint32_t hash; /**< Hash of the bytes of text */
+	lwc_string * const *families; /**< Font families */
+	plot_font_generic_family_t family; /**< Generic font family */
+	plot_style_fixed size; /**< Font size */
+	int weight; /**< Font weight */
+	plot_font_flags_t flags; /**< Font flags */
+	int x; /**< Width available to split, or FONT_MEASURE_WIDTH */
+	size_t offset; /**< Split point */
+	int width; /**< Width of text before split point */
+};
+
+/**
+ * Direct mapped cache of text measurements.
+ */
+struct font_measure_cache {
+	unsigned int hits; /**< Lookups found in cache since last stats */
+	unsigned int misses; /**< Lookups measured since last stats */
+	struct font_measure_entry entry[FONT_MEASURE_CACHE_SIZE];
+};
+
+
+/**
+ * Hash the bytes of some text
+ *
+ * The hash guards against text being replaced by other text of the
+ * same length at the same address.
+ *
+ * \param text    Text to hash
+ * \param length  Length of text, in bytes
+ * \return FNV-1a hash of the text
+ */
+static uint32_t font_measure_hash(const char *text, size_t length)
+{
+	uint32_t hash = 0x811c9dc5;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		hash ^= (uint8_t)text[i];
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+
+/**
+ * Find the cache entry for a measurement
+ *
+ * \param cache   Cache to search
+ * \param fstyle  Plot style of the text
+ * \param text    Text measured
+ * \param length  Length of text, in bytes
+ * \param x       Width available, or FONT_MEASURE_WIDTH
+ * \param hit     Updated to true if the entry holds the measurement
+ * \return The entry which holds, or should be filled with, the measurement
+ */
+static struct font_measure_entry *
+font_measure_cache_find(struct font_measure_cache *cache,
+			const plot_font_style_t *fstyle,
+			const char *text, size_t length, int x, bool *hit)
+{
+	struct font_measure_entry *e;
+	uint32_t hash = font_measure_hash(text, length);
+	uintptr_t key;
+
+	key = (uintptr_t)text ^ ((uintptr_t)fstyle->families >> 4) ^
+			(uintptr_t)fstyle->size ^ (uintptr_t)(x * 31) ^ hash;
+	e = &cache->entry[(key ^ (key >> 10)) & (FONT_MEASURE_CACHE_SIZE - 1)];
+
+	*hit = (e->text == text && e->length == length && e->hash == hash &&
+			e->x == x &&
+			e->families == fstyle->families &&
+			e->family == fstyle->family &&
+			e->size == fstyle->size &&
+			e->weight == fstyle->weight &&
+			e->flags == fstyle->flags);
+
+	if (*hit) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+		e->text = text;
+		e->length = length;
+		e->hash = hash;
+		e->x = x;
+		e->families = fstyle->families;
+		e->family = fstyle->family;
+		e->size = fstyle->size;
+		e->weight = fstyle->weight;
+		e->flags = fstyle->flags;
+	}
+
+	return e;
+}
+
+
+/* exported interface documented in html/font.h */
+nserror font_measure_cache_create(struct font_measure_cache **cache)
+{
+	*cache = calloc(1, sizeof(**cache));
+	if (*cache == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/font.h */
+void font_measure_cache_destroy(struct font_measure_cache *cache)
+{
+	free(cache);
+}
+
+
+/* exported interface documented in html/font.h */
+void font_measure_cache_stats(struct font_measure_cache *cache,
+			      unsigned int *hits, unsigned int *misses)
+{
+	*hits = cache->hits;
+	*misses = cache->misses;
+
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+
+/* exported interface documented in html/font.h */
+nserror font_measure_width(struct font_measure_cache *cache,
+			   const struct gui_layout_table *font_func,
+			   const plot_font_style_t *fstyle,
+			   const char *string, size_t length, int *width)
+{
+	struct font_measure_entry *e;
+	nserror res;
+	bool hit;
+
+	if (cache == NULL) {
+		return font_func->width(fstyle, string, length, width);
+	}
+
+	e = font_measure_cache_find(cache, fstyle, string, length,
+			FONT_MEASURE_WIDTH, &hit);
+	if (hit) {
+		*width = e->width;
+		return NSERROR_OK;
+	}
+
+	res = font_func->width(fstyle, string, length, width);
+	if (res != NSERROR_OK) {
+		e->text = NULL;
+		return res;
+	}
+
+	e->offset = length;
+	e->width = *width;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/font.h */
+nserror font_measure_split(struct font_measure_cache *cache,
+			   const struct gui_layout_table *font_func,
+			   const plot_font_style_t *fstyle,
+			   const char *string, size_t length, int x,
+			   size_t *char_offset, int *actual_x)
+{
+	struct font_measure_entry *e;
+	nserror res;
+	bool hit;
+
+	if (cache == NULL || x < 0) {
+		return font_func->split(fstyle, string, length, x,
+				char_offset, actual_x);
+	}
+
+	e = font_measure_cache_find(cache, fstyle, string, length, x, &hit);
+	if (hit) {
+		*char_offset = e->offset;
+		*actual_x = e->width;
+		return NSERROR_OK;
+	}
+
+	res = font_func->split(fstyle, string, length, x,
+			char_offset, actual_x);
+	if (res != NSERROR_OK) {
+		e->text = NULL;
+		return res;
+	}
+
+	e->offset = *char_offset;
+	e->width = *actual_x;
+
+	return NSERROR_OK;
+}
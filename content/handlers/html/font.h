@@ -27,7 +27,11 @@
 #ifndef NETSURF_HTML_FONT_H
 #define NETSURF_HTML_FONT_H
 
+#include "utils/errors.h"
+
 struct plot_font_style;
+struct font_measure_cache;
+struct gui_layout_table;
 
 /**
  * Populate a font style using data from a computed CSS style
@@ -40,4 +44,73 @@ void font_plot_style_from_css(const css_unit_ctx *unit_len_ctx,
 			      const css_computed_style *css,
 			      struct plot_font_style *fstyle);
 
+/**
+ * Create a cache of text measurements
+ *
+ * \param cache  Updated to the new cache
+ * \return NSERROR_OK on success, NSERROR_NOMEM on memory exhaustion
+ */
+nserror font_measure_cache_create(struct font_measure_cache **cache);
+
+/**
+ * Destroy a text measurement cache
+ *
+ * \param cache  Cache to destroy, or NULL
+ */
+void font_measure_cache_destroy(struct font_measure_cache *cache);
+
+/**
+ * Obtain the number of lookups made in a text measurement cache
+ *
+ * The counts are reset, so each call reports the lookups made since the
+ * previous call.
+ *
+ * \param cache   Cache to query
+ * \param hits    Updated with the number of lookups answered by the cache
+ * \param misses  Updated with the number of lookups passed to the frontend
+ */
+void font_measure_cache_stats(struct font_measure_cache *cache,
+			      unsigned int *hits, unsigned int *misses);
+
+/**
+ * Measure the width of a string, using a cache
+ *
+ * As the layout table width() callback, except that the result is
+ * remembered for the same text and font style.
+ *
+ * \param cache     Cache to use, or NULL to measure directly
+ * \param font_func Font layout functions
+ * \param fstyle    Plot style for the text
+ * \param string    UTF-8 string to measure
+ * \param length    Length of string, in bytes
+ * \param width     Updated to width of string[0..length)
+ * \return NSERROR_OK and width updated or appropriate error code
+ */
+nserror font_measure_width(struct font_measure_cache *cache,
+			   const struct gui_layout_table *font_func,
+			   const struct plot_font_style *fstyle,
+			   const char *string, size_t length, int *width);
+
+/**
+ * Find where to split a string to fit a width, using a cache
+ *
+ * As the layout table split() callback, except that the result is
+ * remembered for the same text, font style and width.
+ *
+ * \param cache       Cache to use, or NULL to measure directly
+ * \param font_func   Font layout functions
+ * \param fstyle      Plot style for the text
+ * \param string      UTF-8 string to split
+ * \param length      Length of string, in bytes
+ * \param x           Width available
+ * \param char_offset Updated to offset in string of split point
+ * \param actual_x    Updated to width of string[0..char_offset)
+ * \return NSERROR_OK and outputs updated or appropriate error code
+ */
+nserror font_measure_split(struct font_measure_cache *cache,
+			   const struct gui_layout_table *font_func,
+			   const struct plot_font_style *fstyle,
+			   const char *string, size_t length, int x,
+			   size_t *char_offset, int *actual_x);
+
 #endif
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
@@ -37,10 +38,12 @@
 #include "utils/log.h"
 #include "utils/messages.h"
 #include "utils/talloc.h"
+#include "utils/arena.h"
 #include "utils/utf8.h"
 #include "utils/nsoption.h"
 #include "utils/string.h"
 #include "utils/ascii.h"
+#include "utils/nsurl.h"
 #include "netsurf/content.h"
 #include "netsurf/browser_window.h"
 #include "netsurf/utf8.h"
@@ -56,11 +59,13 @@
 #include "netsurf/bitmap.h"
 #include "javascript/js.h"
 #include "desktop/gui_internal.h"
+#include "css/select.h"
 
 #include "html/html.h"
 #include "html/private.h"
 #include "html/dom_event.h"
 #include "html/css.h"
+#include "html/display_list.h"
 #include "html/object.h"
 #include "html/html_save.h"
 #include "html/interaction.h"
@@ -68,6 +73,7 @@
 #include "html/box_construct.h"
 #include "html/box_inspect.h"
 #include "html/form_internal.h"
+#include "html/font.h"
 #include "html/imagemap.h"
 #include "html/layout.h"
 #include "html/textselection.h"
@@ -223,6 +229,10 @@ static void html_box_convert_done(html_content *c, bool success)
 
 	c->box_conversion_context = NULL;
 
+	/* Stopping while the box tree was built only affects fetches made
+	 * for it; the completed tree is displayed as usual */
+	c->stopped = false;
+
 	/* Clean up and report error if unsuccessful or aborted */
 	if ((success == false) || (c->aborted)) {
 		html_object_free_objects(c);
@@ -273,20 +283,57 @@ static void html_box_convert_done(html_content *c, bool success)
 	dom_hubbub_parser_destroy(c->parser);
 	c->parser = NULL;
 
-	content_set_ready(&c->base);
+	if (content__get_status(&c->base) == CONTENT_STATUS_LOADING) {
+		content_set_ready(&c->base);
+	} else if (c->had_initial_layout) {
+		/* a partial box tree is displayed; lay out the whole */
+		content__reformat(&c->base, false, c->base.available_width,
+				c->base.available_height);
+	}
 
 	html_proceed_to_done(c);
 
 	dom_node_unref(html);
 }
 
+/**
+ * Display a partially constructed box tree
+ *
+ * \param c HTML content whose box tree is being constructed
+ */
+static void html_box_convert_progress(html_content *c)
+{
+	if (c->aborted) {
+		return;
+	}
+
+	switch (content__get_status(&c->base)) {
+	case CONTENT_STATUS_LOADING:
+		content_set_ready(&c->base);
+		break;
+
+	case CONTENT_STATUS_READY:
+		if (c->had_initial_layout) {
+			content__reformat(&c->base, false,
+					c->base.available_width,
+					c->base.available_height);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
 /* Documented in html_internal.h */
 nserror
 html_proceed_to_done(html_content *html)
 {
 	switch (content__get_status(&html->base)) {
 	case CONTENT_STATUS_READY:
-		if (html->base.active == 0) {
+		/* box conversion may continue after the content is ready */
+		if (html->base.active == 0 &&
+		    html->box_conversion_context == NULL) {
 			content_set_done(&html->base);
 			return NSERROR_OK;
 		}
@@ -376,6 +423,12 @@ void html_finish_conversion(html_content *htmlc)
 		return;
 	}
 
+	/* sharing styles between siblings is only an optimisation */
+	error = nscss_style_share_create(&htmlc->style_share);
+	if (error != NSERROR_OK) {
+		htmlc->style_share = NULL;
+	}
+
 
 	/* fire a simple event named load at the Document's Window
 	 * object, but with its target set to the Document object (and
@@ -401,7 +454,9 @@ void html_finish_conversion(html_content *htmlc)
 
 	html_get_dimensions(htmlc);
 
-	error = dom_to_box(html, htmlc, html_box_convert_done, &htmlc->box_conversion_context);
+	error = dom_to_box(html, htmlc, html_box_convert_done,
+			html_box_convert_progress,
+			&htmlc->box_conversion_context);
 	if (error != NSERROR_OK) {
 		NSLOG(netsurf, INFO, "box conversion failed");
 		dom_node_unref(html);
@@ -468,17 +523,30 @@ html_create_html_data(html_content *c, const http_parameter *params)
 	c->quirks = DOM_DOCUMENT_QUIRKS_MODE_NONE;
 	c->encoding = NULL;
 	c->base_url = nsurl_ref(content_get_url(&c->base));
+	c->link_base = NULL;
 	c->base_target = NULL;
 	c->aborted = false;
+	c->stopped = false;
 	c->refresh = false;
 	c->reflowing = false;
+	c->layout_viewport_width = -1;
+	c->layout_viewport_height = -1;
+	c->layout_reuse = false;
+	c->layout_lazy = false;
+	c->layout_lazy_y0 = 0;
+	c->layout_lazy_y1 = 0;
+	c->layout_lazy_scheduled = false;
+	c->layout_lazy_top = 0;
+	c->layout_estimated = 0;
 	c->title = NULL;
 	c->bctx = NULL;
+	c->box_arena = NULL;
 	c->layout = NULL;
 	c->background_colour = NS_TRANSPARENT;
 	c->stylesheet_count = 0;
 	c->stylesheets = NULL;
 	c->select_ctx = NULL;
+	c->style_share = NULL;
 	c->media.type = CSS_MEDIA_SCREEN;
 	c->universal = NULL;
 	c->num_objects = 0;
@@ -490,6 +558,8 @@ html_create_html_data(html_content *c, const http_parameter *params)
 	c->iframe = NULL;
 	c->page = NULL;
 	c->font_func = guit->layout;
+	c->measure_cache = NULL;
+	c->display_list = NULL;
 	c->drag_type = HTML_DRAG_NONE;
 	c->drag_owner.no_owner = true;
 	c->selection_type = HTML_SELECTION_NONE;
@@ -1024,11 +1094,19 @@ static void html_stop(struct content *c)
 		break;
 
 	case CONTENT_STATUS_READY:
+		if (htmlc->box_conversion_context != NULL) {
+			/* The rest of the box tree is still built, so that
+			 * the whole document is shown, but the objects it
+			 * references are not fetched */
+			htmlc->stopped = true;
+		}
+
 		html_object_abort_objects(htmlc);
 
 		/* If there are no further active fetches and we're still
 		 * in the READY state, transition to the DONE state. */
-		if (c->status == CONTENT_STATUS_READY && c->active == 0) {
+		if (c->status == CONTENT_STATUS_READY && c->active == 0 &&
+		    htmlc->box_conversion_context == NULL) {
 			content_set_done(c);
 		}
 
@@ -1062,12 +1140,30 @@ static void html_reformat(struct content *c, int width, int height)
 
 	htmlc->reflowing = true;
 
+	html_display_list_invalidate(htmlc->display_list);
+
 	htmlc->unit_len_ctx.viewport_width = css_unit_device2css_px(
 			INTTOFIX(width), htmlc->unit_len_ctx.device_dpi);
 	htmlc->unit_len_ctx.viewport_height = css_unit_device2css_px(
 			INTTOFIX(height), htmlc->unit_len_ctx.device_dpi);
 	htmlc->unit_len_ctx.root_style = htmlc->layout->style;
 
+	if (htmlc->measure_cache == NULL) {
+		if (font_measure_cache_create(
+				&htmlc->measure_cache) != NSERROR_OK) {
+			/* layout measures text directly without a cache */
+			htmlc->measure_cache = NULL;
+		}
+	}
+
+	/* Only contents displayed in a browser window are redrawn
+	 * interactively, allowing their layout to be completed on demand */
+	htmlc->layout_lazy = htmlc->bw != NULL && nsoption_bool(lazy_layout);
+	if (htmlc->layout_lazy_y1 <= htmlc->layout_lazy_y0) {
+		htmlc->layout_lazy_y0 = 0;
+		htmlc->layout_lazy_y1 = 2 * height;
+	}
+
 	layout_document(htmlc, width, height);
 	layout = htmlc->layout;
 
@@ -1093,6 +1189,18 @@ static void html_reformat(struct content *c, int width, int height)
 	/* calculate next reflow time at three times what it took to reflow */
 	nsu_getmonotonic_ms(&ms_after);
 
+	NSLOG(netsurf, DEBUG, "Reformatted %p to %dx%d in %"PRIu64"ms",
+	      c, width, height, ms_after - ms_before);
+
+	if (htmlc->measure_cache != NULL) {
+		unsigned int hits, misses;
+
+		font_measure_cache_stats(htmlc->measure_cache, &hits, &misses);
+		NSLOG(layout, INFO, "Text measurement cache %u hits, %u misses"
+		      " (%u%%)", hits, misses,
+		      hits + misses == 0 ? 0 : 100 * hits / (hits + misses));
+	}
+
 	ms_interval = (ms_after - ms_before) * 3;
 	if (ms_interval < (nsoption_uint(min_reflow_period) * 10)) {
 		ms_interval = nsoption_uint(min_reflow_period) * 10;
@@ -1101,17 +1209,198 @@ static void html_reformat(struct content *c, int width, int height)
 }
 
 
+/**
+ * Find the first box in normal flow shown below a position
+ *
+ * Only blocks crossing the position are searched within. Inline
+ * containers and boxes with scrollbars are not searched within.
+ *
+ * \param box    Box to search the children of
+ * \param box_y  Position of box, in document coordinates
+ * \param top    Position to search below, in document coordinates
+ * \return the first box shown, or NULL if there is none
+ */
+static struct box *
+html_layout_lazy_anchor(struct box *box, int box_y, int top)
+{
+	struct box *c;
+
+	for (c = box->children; c != NULL; c = c->next) {
+		int y = box_y + c->y;
+		struct box *anchor;
+
+		if (c->style != NULL &&
+				(css_computed_position(c->style) ==
+						CSS_POSITION_ABSOLUTE ||
+				 css_computed_position(c->style) ==
+						CSS_POSITION_FIXED)) {
+			continue;
+		}
+
+		if (y + c->padding[TOP] + c->height +
+				c->padding[BOTTOM] <= top) {
+			continue;
+		}
+
+		if (y < top && c->type != BOX_INLINE_CONTAINER &&
+				c->scroll_x == NULL && c->scroll_y == NULL) {
+			anchor = html_layout_lazy_anchor(c, y, top);
+			if (anchor != NULL) {
+				return anchor;
+			}
+		}
+
+		return c;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Lay out the area of a document most recently requested to be shown
+ *
+ * Correcting the estimated heights of text above the area shown would
+ * move what is being read, so the first box shown may be kept in place
+ * by scrolling by however far the layout moved it.
+ *
+ * \param htmlc  HTML content to reformat
+ * \param keep   Whether to keep the first box shown in place
+ */
+static void html_layout_lazy_reformat(html_content *htmlc, bool keep)
+{
+	content_status status = content__get_status(&htmlc->base);
+	struct box *anchor = NULL;
+	int x, y, anchor_y = 0;
+
+	htmlc->layout_lazy_scheduled = false;
+
+	if (status != CONTENT_STATUS_READY && status != CONTENT_STATUS_DONE) {
+		return;
+	}
+
+	if (keep && htmlc->layout != NULL) {
+		anchor = html_layout_lazy_anchor(htmlc->layout,
+				htmlc->layout->y, htmlc->layout_lazy_top);
+		if (anchor != NULL) {
+			box_coords(anchor, &x, &anchor_y);
+		}
+	}
+
+	content__reformat(&htmlc->base, false, htmlc->base.available_width,
+			htmlc->base.available_height);
+
+	if (anchor != NULL) {
+		box_coords(anchor, &x, &y);
+		if (y != anchor_y) {
+			union content_msg_data msg_data;
+
+			msg_data.scroll.area = false;
+			msg_data.scroll.relative = true;
+			msg_data.scroll.x0 = 0;
+			msg_data.scroll.y0 = y - anchor_y;
+			content_broadcast(&htmlc->base, CONTENT_MSG_SCROLL,
+					&msg_data);
+		}
+	}
+}
+
+
+/**
+ * Scheduler callback to lay out the area of a document being displayed
+ *
+ * \param p HTML content to reformat
+ */
+static void html_layout_lazy_callback(void *p)
+{
+	html_layout_lazy_reformat(p, true);
+}
+
+
+/**
+ * Lay out the estimated area of a document around a box, if any
+ *
+ * The positions of boxes within text whose layout was only estimated
+ * are not known, so the text is laid out before they are used.
+ *
+ * \param htmlc  HTML content containing the box
+ * \param box    box whose position is needed
+ */
+static void html_layout_lazy_box(html_content *htmlc, struct box *box)
+{
+	struct box *cont;
+	int x, y;
+
+	if (htmlc->layout_estimated == 0) {
+		return;
+	}
+
+	for (cont = box; cont != NULL; cont = cont->parent) {
+		if (cont->flags & LAYOUT_ESTIMATED) {
+			break;
+		}
+	}
+	if (cont == NULL) {
+		return;
+	}
+
+	box_coords(cont, &x, &y);
+	html_layout_lazy_show(htmlc, y, y + cont->padding[TOP] +
+			cont->height + cont->padding[BOTTOM]);
+
+	if (htmlc->layout_lazy_scheduled) {
+		/* the position is needed now, not when scheduled */
+		guit->misc->schedule(-1, html_layout_lazy_callback, htmlc);
+		html_layout_lazy_reformat(htmlc, false);
+	}
+}
+
+
+/* exported interface documented in html/private.h */
+void html_layout_lazy_show(html_content *htmlc, int y0, int y1)
+{
+	int margin = htmlc->layout_viewport_height;
+
+	if (htmlc->layout_estimated == 0 || htmlc->reflowing ||
+			(y0 >= htmlc->layout_lazy_y0 &&
+			 y1 <= htmlc->layout_lazy_y1)) {
+		return;
+	}
+
+	/* lay out a viewport's height either side, so that scrolling
+	 * a little does not need another layout */
+	htmlc->layout_lazy_y0 = y0 - margin;
+	htmlc->layout_lazy_y1 = y1 + margin;
+
+	/* the layout keeps the topmost area shown in place */
+	if (!htmlc->layout_lazy_scheduled || y0 < htmlc->layout_lazy_top) {
+		htmlc->layout_lazy_top = y0;
+	}
+	htmlc->layout_lazy_scheduled = true;
+
+	guit->misc->schedule(0, html_layout_lazy_callback, htmlc);
+}
+
+
 /**
  * Redraw a box.
  *
+ * The box's appearance is assumed to have changed, so the document's
+ * display list is discarded, unless the box is drawn live from the box
+ * tree.
+ *
  * \param  h	content containing the box, of type CONTENT_HTML
  * \param  box  box to redraw
  */
 
 void html_redraw_a_box(hlcache_handle *h, struct box *box)
 {
+	html_content *html = (html_content *) hlcache_handle_get_content(h);
 	int x, y;
 
+	if (!html_redraw_box_is_live(box))
+		html_display_list_invalidate(html->display_list);
+
 	box_coords(box, &x, &y);
 
 	content_request_redraw(h, x, y,
@@ -1123,6 +1412,10 @@ void html_redraw_a_box(hlcache_handle *h, struct box *box)
 /**
  * Redraw a box.
  *
+ * The box's appearance is assumed to have changed, so the document's
+ * display list is discarded, unless the box is drawn live from the box
+ * tree.
+ *
  * \param html  content containing the box, of type CONTENT_HTML
  * \param box  box to redraw.
  */
@@ -1131,6 +1424,9 @@ void html__redraw_a_box(struct html_content *html, struct box *box)
 {
 	int x, y;
 
+	if (!html_redraw_box_is_live(box))
+		html_display_list_invalidate(html->display_list);
+
 	box_coords(box, &x, &y);
 
 	content__request_redraw((struct content *)html, x, y,
@@ -1193,6 +1489,11 @@ static void html_free_layout(html_content *htmlc)
 		 */
 		talloc_free(htmlc->bctx);
 	}
+	if (htmlc->box_arena != NULL) {
+		/* box text has the same lifetime as the box tree */
+		arena_destroy(htmlc->box_arena);
+		htmlc->box_arena = NULL;
+	}
 }
 
 /**
@@ -1213,6 +1514,8 @@ static void html_destroy(struct content *c)
 		}
 	}
 
+	guit->misc->schedule(-1, html_layout_lazy_callback, html);
+
 	selection_destroy(html->sel);
 
 	/* Destroy forms */
@@ -1227,6 +1530,12 @@ static void html_destroy(struct content *c)
 	if (c->refresh)
 		nsurl_unref(c->refresh);
 
+	nsurl_join_base_destroy(html->link_base);
+
+	font_measure_cache_destroy(html->measure_cache);
+
+	html_display_list_destroy(html->display_list);
+
 	if (html->base_url)
 		nsurl_unref(html->base_url);
 
@@ -1284,6 +1593,9 @@ static void html_destroy(struct content *c)
 		html->select_ctx = NULL;
 	}
 
+	nscss_style_share_destroy(html->style_share);
+	html->style_share = NULL;
+
 	lwc_string_unref(html->universal);
 	html->universal = NULL;
 
@@ -1467,9 +1779,10 @@ html_get_contextual_content(struct content *c, int x, int y,
 			continue;
 		}
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
-			browser_window_get_features(box->iframe,
+		if (box_get_iframe(box)) {
+			struct browser_window *iframe = box_get_iframe(box);
+			float scale = browser_window_get_scale(iframe);
+			browser_window_get_features(iframe,
 						    (x - box_x) * scale,
 						    (y - box_y) * scale,
 						    data);
@@ -1488,10 +1801,10 @@ html_get_contextual_content(struct content *c, int x, int y,
 			data->link_title_length = box->length;
 		}
 
-		if (box->usemap) {
+		if (box_get_usemap(box)) {
 			const char *target = NULL;
-			nsurl *url = imagemap_get(html, box->usemap, box_x,
-					box_y, x, y, &target);
+			nsurl *url = imagemap_get(html, box_get_usemap(box),
+					box_x, box_y, x, y, &target);
 			/* Box might have imagemap, but no actual link area
 			 * at point */
 			if (url != NULL)
@@ -1550,10 +1863,11 @@ html_scroll_at_point(struct content *c, int x, int y, int scrx, int scry)
 			continue;
 
 		/* Pass into iframe */
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if (box_get_iframe(box)) {
+			struct browser_window *iframe = box_get_iframe(box);
+			float scale = browser_window_get_scale(iframe);
 
-			if (browser_window_scroll_at_point(box->iframe,
+			if (browser_window_scroll_at_point(iframe,
 							   (x - box_x) * scale,
 							   (y - box_y) * scale,
 							   scrx, scry) == true)
@@ -1698,10 +2012,11 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 		    css_computed_visibility(box->style) == CSS_VISIBILITY_HIDDEN)
 			continue;
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if (box_get_iframe(box)) {
+			struct browser_window *iframe = box_get_iframe(box);
+			float scale = browser_window_get_scale(iframe);
 			return browser_window_drop_file_at_point(
-				box->iframe,
+				iframe,
 				(x - box_x) * scale,
 				(y - box_y) * scale,
 				file);
@@ -2080,6 +2395,8 @@ bool html_get_id_offset(hlcache_handle *h, lwc_string *frag_id, int *x, int *y)
 	layout = html_get_box_tree(h);
 
 	if ((pos = box_find_by_id(layout, frag_id)) != 0) {
+		html_layout_lazy_box((html_content *)
+				hlcache_handle_get_content(h), pos);
 		box_coords(pos, x, y);
 		return true;
 	}
@@ -2327,6 +2644,11 @@ html_textsearch_bounds(struct content *c,
 		       struct box *end_box,
 		       struct rect *bounds)
 {
+	html_content *html = (html_content *)c;
+
+	html_layout_lazy_box(html, start_box);
+	html_layout_lazy_box(html, end_box);
+
 	/* get box position and jump to it */
 	box_coords(start_box, &bounds->x0, &bounds->y0);
 	/* \todo: move x0 in by correct idx */
@@ -161,7 +161,8 @@ nserror html_init(void);
 /**
  * redraw a specific box
  *
- * used by core browser
+ * used by core browser. The document's display list is kept if the box
+ * is drawn live from the box tree, as iframes are.
  */
 void html_redraw_a_box(struct hlcache_handle *h, struct box *box);
 
@@ -715,8 +715,8 @@ get_mouse_action_node(html_content *html,
 			}
 		}
 
-		if (box->iframe) {
-			man->iframe = box->iframe;
+		if (box_get_iframe(box)) {
+			man->iframe = box_get_iframe(box);
 		}
 
 		if (box->href) {
@@ -726,9 +726,9 @@ get_mouse_action_node(html_content *html,
 			man->link.is_imagemap = false;
 		}
 
-		if (box->usemap) {
+		if (box_get_usemap(box)) {
 			man->link.url = imagemap_get(html,
-						     box->usemap,
+						     box_get_usemap(box),
 						     box_x,
 						     box_y,
 						     x, y,
@@ -1618,6 +1618,7 @@ void html_overflow_scroll_callback(void *client_data,
 	union content_msg_data msg_data;
 	html_drag_type drag_type;
 	union html_drag_owner drag_owner;
+	int x, y;
 
 	switch(scrollbar_data->msg) {
 	case SCROLLBAR_MSG_MOVED:
@@ -1628,7 +1629,14 @@ void html_overflow_scroll_callback(void *client_data,
 			break;
 		}
 
-		html__redraw_a_box(html, box);
+		/* The box's children and scrollbars are redrawn live from
+		 * the display list, so it remains valid */
+		box_coords(box, &x, &y);
+		content__request_redraw((struct content *)html, x, y,
+				box->padding[LEFT] + box->width +
+				box->padding[RIGHT],
+				box->padding[TOP] + box->height +
+				box->padding[BOTTOM]);
 		break;
 	case SCROLLBAR_MSG_SCROLL_START:
 	{
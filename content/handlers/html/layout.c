@@ -37,6 +37,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -64,6 +65,7 @@
 #include "html/private.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 #include "html/layout.h"
@@ -116,6 +118,149 @@ static void layout_minmax_block(
 		const struct gui_layout_table *font_func,
 		const html_content *content);
 
+
+/**
+ * Check whether a box's previous layout is still valid.
+ *
+ * The previous layout may be kept if the viewport is unchanged, neither
+ * the box nor any descendant has changed since, the box is given the same
+ * width, and no absolutely positioned descendant takes its static
+ * position from it.
+ *
+ * \param  content      The HTML content being laid out.
+ * \param  box          Box to check.
+ * \param  avail_width  Width available to the box in this layout.
+ * \return  true if the previous layout of the box can be kept.
+ */
+static inline bool
+layout_cache_valid(const html_content *content,
+		   const struct box *box,
+		   int avail_width)
+{
+	return content->layout_reuse &&
+			(box->flags & (NEEDS_LAYOUT | ABS_DESCENDANT)) == 0 &&
+			box->layout_cache.avail_width == avail_width;
+}
+
+
+/**
+ * Record the result of laying out a box, for reuse by later layouts.
+ *
+ * \param  box           Box which has been laid out.
+ * \param  avail_width   Width which was available to the box.
+ * \param  avail_height  Height the box was given before layout, or AUTO.
+ */
+static inline void
+layout_cache_store(struct box *box, int avail_width, int avail_height)
+{
+	box->layout_cache.avail_width = avail_width;
+	box->layout_cache.avail_height = avail_height;
+	box->layout_cache.width = box->width;
+	box->layout_cache.height = box->height;
+	box->flags &= ~(NEEDS_LAYOUT | LAYOUT_REUSED);
+}
+
+/**
+ * Check whether a unit is relative to the viewport size.
+ *
+ * \param  unit  Unit to check.
+ * \return  true if the unit is a viewport-percentage unit.
+ */
+static inline bool layout_unit_is_viewport(css_unit unit)
+{
+	return unit == CSS_UNIT_VW || unit == CSS_UNIT_VH ||
+			unit == CSS_UNIT_VMIN || unit == CSS_UNIT_VMAX;
+}
+
+
+/**
+ * Check whether a style gives any length used by the minmax pass in
+ * viewport-percentage units.
+ *
+ * \param  style  Computed style to check.
+ * \return  true if min, max widths computed with style depend on viewport.
+ */
+static bool layout_style_uses_viewport(const css_computed_style *style)
+{
+	static uint8_t (* const getters[])(const css_computed_style *,
+			css_fixed *, css_unit *) = {
+		css_computed_width,
+		css_computed_min_width,
+		css_computed_max_width,
+		css_computed_margin_left,
+		css_computed_margin_right,
+		css_computed_padding_left,
+		css_computed_padding_right,
+		css_computed_border_left_width,
+		css_computed_border_right_width,
+		css_computed_text_indent,
+		css_computed_font_size,
+	};
+	css_fixed value = 0, value2 = 0;
+	css_unit unit, unit2;
+	size_t i;
+
+	for (i = 0; i < sizeof(getters) / sizeof(getters[0]); i++) {
+		unit = CSS_UNIT_PX;
+		getters[i](style, &value, &unit);
+		if (layout_unit_is_viewport(unit))
+			return true;
+	}
+
+	unit = unit2 = CSS_UNIT_PX;
+	css_computed_border_spacing(style, &value, &unit, &value2, &unit2);
+
+	return layout_unit_is_viewport(unit);
+}
+
+
+/**
+ * Note whether a box's min, max widths depend on the viewport size.
+ *
+ * The box and its ancestors are flagged, so a change of viewport size
+ * only needs to recompute the minmax of the flagged part of the tree.
+ *
+ * \param  box  Box whose min, max widths are being computed.
+ */
+static void layout_minmax_note_viewport(struct box *box)
+{
+	if (box->style == NULL || (box->flags & MINMAX_VIEWPORT) ||
+			!layout_style_uses_viewport(box->style))
+		return;
+
+	for (; box != NULL && !(box->flags & MINMAX_VIEWPORT);
+			box = box->parent)
+		box->flags |= MINMAX_VIEWPORT;
+}
+
+
+/**
+ * Discard min, max widths which depend on the viewport size.
+ *
+ * Text measured in a viewport-relative font size is measured again.
+ *
+ * \param  box  Root of the subtree to invalidate.
+ */
+static void layout_minmax_invalidate_viewport(struct box *box)
+{
+	struct box *child;
+
+	if (!(box->flags & MINMAX_VIEWPORT))
+		return;
+
+	box->max_width = UNKNOWN_MAX_WIDTH;
+
+	if (box->text != NULL && box->style != NULL &&
+			layout_style_uses_viewport(box->style)) {
+		box->width = UNKNOWN_WIDTH;
+		box->flags &= ~MEASURED;
+	}
+
+	for (child = box->children; child != NULL; child = child->next)
+		layout_minmax_invalidate_viewport(child);
+}
+
+
 /**
  * Compute the size of replaced boxes with auto dimensions, according to
  * content.
@@ -271,6 +416,8 @@ static void layout_minmax_table(struct box *table,
 	if (table->max_width != UNKNOWN_MAX_WIDTH)
 		return;
 
+	layout_minmax_note_viewport(table);
+
 	if (table_calculate_column_types(&content->unit_len_ctx, table) == false) {
 		NSLOG(netsurf, ERROR,
 				"Could not establish table column types.");
@@ -534,6 +681,7 @@ layout_minmax_line(struct box *first,
 
 		assert(b->style);
 		font_plot_style_from_css(&content->unit_len_ctx, b->style, &fstyle);
+		layout_minmax_note_viewport(b);
 
 		if (b->type == BOX_INLINE && !b->object &&
 				!(b->flags & REPLACE_DIM) &&
@@ -562,8 +710,9 @@ layout_minmax_line(struct box *first,
 
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
-							 &b->space);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle, " ",
+							1, &b->space);
 				}
 				max += b->space;
 			}
@@ -598,7 +747,9 @@ layout_minmax_line(struct box *first,
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						font_measure_width(content->measure_cache,
+								font_func,
+								&fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -612,16 +763,19 @@ layout_minmax_line(struct box *first,
 						b->width += SCROLLBAR_WIDTH;
 
 				} else {
-					font_func->width(&fstyle, b->text,
-						b->length, &b->width);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle,
+							b->text, b->length,
+							&b->width);
 					b->flags |= MEASURED;
 				}
 			}
 			max += b->width;
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
-							 &b->space);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle, " ",
+							1, &b->space);
 				}
 				max += b->space;
 			}
@@ -647,8 +801,10 @@ layout_minmax_line(struct box *first,
 					for (j = i; j != b->length &&
 							b->text[j] != ' '; j++)
 						;
-					font_func->width(&fstyle, b->text + i,
-							 j - i, &width);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle,
+							b->text + i, j - i,
+							&width);
 					if (min < width)
 						min = width;
 					i = j + 1;
@@ -886,6 +1042,8 @@ static void layout_minmax_block(
 	if (block->max_width != UNKNOWN_MAX_WIDTH)
 		return;
 
+	layout_minmax_note_viewport(block);
+
 	if (block->style != NULL) {
 		wtype = css_computed_width(block->style, &width, &wunit);
 		htype = css_computed_height(block->style, &height, &hunit);
@@ -1625,6 +1783,32 @@ bool layout_table(
 	assert(table->children && table->children->children);
 	assert(columns);
 
+	/* Keep the previous layout of an unchanged table.  Tables which are
+	 * absolutely positioned or have a percentage height depend on the
+	 * height of their containing block, so are always laid out. */
+	if (css_computed_position(style) != CSS_POSITION_ABSOLUTE &&
+			css_computed_position(style) != CSS_POSITION_FIXED &&
+			!(css_computed_height(style, &value, &unit) ==
+					CSS_HEIGHT_SET &&
+			  unit == CSS_UNIT_PCT) &&
+			layout_cache_valid(content, table, available_width)) {
+		layout_find_dimensions(&content->unit_len_ctx,
+				available_width, -1, table, style, 0, 0, 0, 0,
+				0, 0, table->margin, table->padding,
+				table->border);
+		if (table->margin[TOP] == AUTO)
+			table->margin[TOP] = 0;
+		if (table->margin[BOTTOM] == AUTO)
+			table->margin[BOTTOM] = 0;
+
+		/* the caller may have reset the size, e.g. for a float */
+		table->width = table->layout_cache.width;
+		table->height = table->layout_cache.height;
+		table->flags |= LAYOUT_REUSED;
+		return true;
+	}
+	table->flags &= ~LAYOUT_REUSED;
+
 	/* allocate working buffers */
 	col = malloc(columns * sizeof col[0]);
 	excess_y = malloc(columns * sizeof excess_y[0]);
@@ -1646,6 +1830,7 @@ bool layout_table(
 	layout_find_dimensions(&content->unit_len_ctx, available_width, -1, table,
 			style, 0, 0, 0, 0, 0, 0, table->margin, table->padding,
 			table->border);
+	table_used_borders(&content->unit_len_ctx, table);
 	for (row_group = table->children; row_group;
 			row_group = row_group->next) {
 		for (row = row_group->children; row; row = row->next) {
@@ -1654,8 +1839,6 @@ bool layout_table(
 				enum css_overflow_e overflow_y;
 
 				assert(c->style);
-				table_used_border_for_cell(
-						&content->unit_len_ctx, c);
 				layout_find_dimensions(&content->unit_len_ctx,
 						available_width, -1, c,
 						c->style, 0, 0, 0, 0, 0, 0,
@@ -2142,6 +2325,8 @@ bool layout_table(
 	table->width = table_width;
 	table->height = table_height;
 
+	layout_cache_store(table, available_width, AUTO);
+
 	return true;
 }
 
@@ -2362,7 +2547,8 @@ layout_text_box_split(html_content *content,
 		/* We're need to add a space, and we don't know how big
 		 * it's to be, OR we have a space of unknown width anyway;
 		 * Calculate space width */
-		font_func->width(fstyle, " ", 1, &space_width);
+		font_measure_width(content->measure_cache, font_func, fstyle,
+				" ", 1, &space_width);
 	}
 
 	if (split_box->space == UNKNOWN_WIDTH)
@@ -2843,7 +3029,9 @@ layout_line(struct box *first,
 		} else if (b->type == BOX_INLINE_END) {
 			b->width = 0;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				font_measure_width(content->measure_cache,
+						font_func, &fstyle, " ", 1,
+						&b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -2882,7 +3070,9 @@ layout_line(struct box *first,
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						font_measure_width(content->measure_cache,
+								font_func,
+								&fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -2894,8 +3084,10 @@ layout_line(struct box *first,
 					if (nsoption_bool(core_select_menu))
 						b->width += SCROLLBAR_WIDTH;
 				} else {
-					font_func->width(&fstyle, b->text,
-							b->length, &b->width);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle,
+							b->text, b->length,
+							&b->width);
 					b->flags |= MEASURED;
 				}
 			}
@@ -2907,14 +3099,17 @@ layout_line(struct box *first,
 			if (b->text && (x + b->width < x1 - x0) &&
 					!(b->flags & MEASURED) &&
 					b->next) {
-				font_func->width(&fstyle, b->text,
-						 b->length, &b->width);
+				font_measure_width(content->measure_cache,
+						font_func, &fstyle, b->text,
+						b->length, &b->width);
 				b->flags |= MEASURED;
 			}
 
 			x += b->width;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				font_measure_width(content->measure_cache,
+						font_func, &fstyle, " ", 1,
+						&b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -3050,8 +3245,9 @@ layout_line(struct box *first,
 							&content->unit_len_ctx,
 							b->style, &fstyle);
 					/** \todo handle errors */
-					font_func->width(&fstyle, " ", 1,
-							 &b->space);
+					font_measure_width(content->measure_cache,
+							font_func, &fstyle, " ",
+							1, &b->space);
 				}
 				space_after = b->space;
 			} else {
@@ -3204,12 +3400,10 @@ layout_line(struct box *first,
 			font_plot_style_from_css(&content->unit_len_ctx,
 					split_box->style, &fstyle);
 			/** \todo handle errors */
-			font_func->split(&fstyle,
-					 split_box->text,
-					 split_box->length,
-					 x1 - x0 - x - space_before,
-					 &split,
-					 &w);
+			font_measure_split(content->measure_cache, font_func,
+					&fstyle, split_box->text,
+					split_box->length,
+					x1 - x0 - x - space_before, &split, &w);
 		}
 
 		/* split == 0 implies that text can't be split */
@@ -3429,6 +3623,107 @@ layout_line(struct box *first,
 }
 
 
+/**
+ * Estimate the height of an inline container without laying it out.
+ *
+ * A previous layout at another width is scaled by the change in width.
+ * Otherwise, glyphs are assumed to advance by half the font size on
+ * average and text to fill each line, with a new line at each break.
+ *
+ * \param  unit_len_ctx     Length conversion context
+ * \param  inline_container  inline container box
+ * \param  width            horizontal space available
+ * \return  estimated height of the inline container
+ */
+static int layout_inline_container_estimate(
+		const css_unit_ctx *unit_len_ctx,
+		const struct box *inline_container,
+		int width)
+{
+	const struct box_layout_cache *cache = &inline_container->layout_cache;
+	const css_computed_style *style = NULL;
+	css_fixed font_size = 0;
+	css_unit font_unit = CSS_UNIT_PT;
+	int64_t line_px = 0;
+	int lines = 1;
+	int advance;
+	struct box *c;
+
+	if (width <= 0)
+		width = 1;
+
+	if (cache->avail_width != UNKNOWN_WIDTH && cache->avail_width > 0)
+		return (int64_t) cache->height * cache->avail_width / width;
+
+	for (c = inline_container->children; c != NULL; c = c->next) {
+		if (c->style != NULL) {
+			style = c->style;
+			break;
+		}
+	}
+	if (style == NULL)
+		return 0;
+
+	css_computed_font_size(style, &font_size, &font_unit);
+	advance = FIXTOINT(css_unit_len2device_px(style, unit_len_ctx,
+			font_size, font_unit)) / 2;
+	if (advance < 1)
+		advance = 1;
+
+	for (c = inline_container->children; c != NULL; c = c->next) {
+		if (c->type == BOX_BR) {
+			lines += line_px / width + 1;
+			line_px = 0;
+		} else if (c->text != NULL) {
+			line_px += (int64_t) c->length * advance;
+		}
+	}
+	lines += line_px / width;
+
+	return lines * line_height(unit_len_ctx, style);
+}
+
+
+/**
+ * Check whether an inline container may be given an estimated height.
+ *
+ * Only containers of text and inline boxes in the root block formatting
+ * context which are clear of any floats are estimated.
+ *
+ * \param  inline_container  inline container box
+ * \param  cont     ancestor box which defines horizontal space
+ * \param  cy       position of inline container relative to cont
+ * \param  content  HTML content being laid out
+ * \return  true if the inline container's layout may be estimated
+ */
+static bool layout_inline_container_lazy(
+		const struct box *inline_container,
+		struct box *cont,
+		int cy,
+		const html_content *content)
+{
+	const struct box *c;
+
+	if (!content->layout_lazy || cont != content->layout ||
+			(inline_container->flags & ABS_DESCENDANT))
+		return false;
+
+	if (layout_clear(cont->float_children, CSS_CLEAR_BOTH) > cy)
+		return false;
+
+	for (c = inline_container->children; c != NULL; c = c->next) {
+		if (c->object != NULL || c->gadget != NULL)
+			return false;
+		if (c->type != BOX_TEXT && c->type != BOX_INLINE &&
+				c->type != BOX_INLINE_END &&
+				c->type != BOX_BR)
+			return false;
+	}
+
+	return true;
+}
+
+
 /**
  * Layout lines of text or inline boxes with floats.
  *
@@ -3445,6 +3740,7 @@ static bool layout_inline_container(struct box *inline_container, int width,
 {
 	bool first_line = true;
 	bool has_text_children;
+	bool has_floats;
 	struct box *c, *next;
 	int y = 0;
 	int curwidth,maxwidth = width;
@@ -3461,9 +3757,13 @@ static bool layout_inline_container(struct box *inline_container, int width,
 
 
 	has_text_children = false;
+	has_floats = false;
 	for (c = inline_container->children; c; c = c->next) {
 		bool is_pre = false;
 
+		if (c->type == BOX_FLOAT_LEFT || c->type == BOX_FLOAT_RIGHT)
+			has_floats = true;
+
 		if (c->style) {
 			enum css_white_space_e whitespace;
 
@@ -3480,6 +3780,39 @@ static bool layout_inline_container(struct box *inline_container, int width,
 			has_text_children = true;
 	}
 
+	/* Without floats, in the container or already placed in the
+	 * formatting context, the lines depend only on the width. */
+	if (!has_floats && cont->float_children == NULL &&
+			layout_cache_valid(content, inline_container, width)) {
+		inline_container->width = inline_container->layout_cache.width;
+		inline_container->height =
+				inline_container->layout_cache.height;
+		inline_container->flags &= ~LAYOUT_ESTIMATED;
+		inline_container->flags |= LAYOUT_REUSED;
+		return true;
+	}
+	inline_container->flags &= ~LAYOUT_REUSED;
+
+	/* Text outside the area of the document shown is only laid out once
+	 * it is shown. Its previous layout, if any, is kept for reuse. */
+	if (!has_floats && layout_inline_container_lazy(inline_container,
+			cont, cy, content)) {
+		int y0 = cont->y + cy;
+		int height = layout_inline_container_estimate(
+				&content->unit_len_ctx, inline_container,
+				width);
+
+		if (y0 + height < content->layout_lazy_y0 ||
+				y0 > content->layout_lazy_y1) {
+			inline_container->width = width;
+			inline_container->height = height;
+			inline_container->flags |= LAYOUT_ESTIMATED;
+			content->layout_estimated++;
+			return true;
+		}
+	}
+	inline_container->flags &= ~LAYOUT_ESTIMATED;
+
 	/** \todo fix wrapping so that a box with horizontal scrollbar will
 	 * shrink back to 'width' if no word is wider than 'width' (Or just set
 	 * curwidth = width and have the multiword lines wrap to the min width)
@@ -3500,10 +3833,45 @@ static bool layout_inline_container(struct box *inline_container, int width,
 	inline_container->width = maxwidth;
 	inline_container->height = y;
 
+	layout_cache_store(inline_container, width, AUTO);
+
 	return true;
 }
 
 
+/**
+ * Check whether a block formatting context may keep a previous layout.
+ *
+ * Table cells are stretched and aligned by their table and flex items are
+ * positioned by their container, while objects, form controls and
+ * scrollbars have effects outside the block's descendants, so all of these
+ * are always laid out.
+ *
+ * \param block  Block which establishes a block formatting context.
+ * \return  true if the block's layout may be reused.
+ */
+static bool layout_block_reusable(const struct box *block)
+{
+	enum css_overflow_e overflow_x;
+
+	if (block->type != BOX_BLOCK && block->type != BOX_INLINE_BLOCK)
+		return false;
+
+	if (block->object != NULL || block->gadget != NULL ||
+			(block->flags & (IFRAME | REPLACE_DIM)) ||
+			lh__box_is_flex_item(block))
+		return false;
+
+	if (block->style == NULL)
+		return true;
+
+	overflow_x = css_computed_overflow_x(block->style);
+
+	return (overflow_x != CSS_OVERFLOW_SCROLL &&
+			overflow_x != CSS_OVERFLOW_AUTO);
+}
+
+
 /* Documented in layout_intertnal.h */
 bool layout_block_context(
 		struct box *block,
@@ -3520,6 +3888,7 @@ bool layout_block_context(
 	bool in_margin = false;
 	css_fixed gadget_size;
 	css_unit gadget_unit; /* Checkbox / radio buttons */
+	int avail_height = block->height;
 
 	assert(block->type == BOX_BLOCK ||
 			block->type == BOX_INLINE_BLOCK ||
@@ -3529,6 +3898,16 @@ bool layout_block_context(
 	assert(block->width != UNKNOWN_WIDTH);
 	assert(block->width != AUTO);
 
+	/* Keep the previous layout of an unchanged formatting context */
+	if (layout_block_reusable(block) &&
+			layout_cache_valid(content, block, block->width) &&
+			block->layout_cache.avail_height == avail_height) {
+		block->height = block->layout_cache.height;
+		block->flags |= LAYOUT_REUSED;
+		return true;
+	}
+	block->flags &= ~LAYOUT_REUSED;
+
 	block->float_children = NULL;
 	block->cached_place_below_level = 0;
 	block->clear_level = 0;
@@ -3848,8 +4227,8 @@ bool layout_block_context(
 		}
 
 		/* Advance to next box. */
-		if (box->type == BOX_BLOCK && !box->object && !(box->iframe) &&
-				box->children) {
+		if (box->type == BOX_BLOCK && !box->object &&
+				!box_get_iframe(box) && box->children) {
 			/* Down into children. */
 
 			if (box == margin_collapse) {
@@ -4004,6 +4383,12 @@ bool layout_block_context(
 				block->padding[BOTTOM], block->padding[LEFT]);
 	}
 
+	layout_cache_store(block, block->width, avail_height);
+
+	/* Estimated layouts must be reconsidered by the next layout */
+	if (block == content->layout && content->layout_estimated != 0)
+		block->flags |= NEEDS_LAYOUT;
+
 	return true;
 }
 
@@ -4426,8 +4811,9 @@ layout_lists(const html_content *content, struct box *box)
 							&content->unit_len_ctx,
 							marker->style,
 							&fstyle);
-					content->font_func->width(&fstyle,
-							marker->text,
+					font_measure_width(content->measure_cache,
+							content->font_func,
+							&fstyle, marker->text,
 							marker->length,
 							&marker->width);
 					marker->flags |= MEASURED;
@@ -4948,6 +5334,9 @@ layout_position_absolute(struct box *box,
 {
 	struct box *c;
 
+	/* Set again below if any descendant is still positioned */
+	box->flags &= ~ABS_DESCENDANT;
+
 	for (c = box->children; c; c = c->next) {
 		if ((c->type == BOX_BLOCK || c->type == BOX_TABLE ||
 				c->type == BOX_INLINE_BLOCK ||
@@ -4957,6 +5346,14 @@ layout_position_absolute(struct box *box,
 						CSS_POSITION_ABSOLUTE ||
 				 css_computed_position(c->style) ==
 						CSS_POSITION_FIXED)) {
+			struct box *p;
+
+			/* The static position of c comes from the layout
+			 * of its ancestors, so they must not reuse it */
+			for (p = box; p != NULL && !(p->flags & ABS_DESCENDANT);
+					p = p->parent)
+				p->flags |= ABS_DESCENDANT;
+
 			if (!layout_absolute(c, containing_block,
 					cx, cy, content))
 				return false;
@@ -5154,8 +5551,11 @@ layout_position_relative(
 			fny = fy + y;
 		}
 
-		/* recurse first */
-		layout_position_relative(unit_len_ctx, box, fn, fnx, fny);
+		/* recurse first, unless the descendants kept their previous
+		 * layout, which already has their offsets applied */
+		if (!(box->flags & (LAYOUT_REUSED | LAYOUT_ESTIMATED)))
+			layout_position_relative(unit_len_ctx, box,
+					fn, fnx, fny);
 
 		/* Ignore things we're not interested in. */
 		if (!box->style || (box->style &&
@@ -5293,6 +5693,99 @@ layout_update_descendant_bbox(
 }
 
 
+/** Number of children in each run of a box's child index */
+#define CHILD_RUN_LENGTH 16
+
+/** Minimum number of children for a box to have a child index */
+#define CHILD_RUN_MIN_CHILDREN (4 * CHILD_RUN_LENGTH)
+
+
+/**
+ * Build the spatial index of a box's children.
+ *
+ * Children are grouped into runs of consecutive boxes, each with the
+ * union of its children's border and descendant boxes.  Boxes with few
+ * children have no index.
+ *
+ * \param  box  Box whose children's descendant bboxes are up to date.
+ */
+static void layout_build_child_runs(struct box *box)
+{
+	struct box_extra *extra = box->extra;
+	struct box_child_run *runs;
+	struct box_child_run *run = NULL;
+	unsigned int count = 0;
+	unsigned int n = 0;
+	struct box *child;
+
+	for (child = box->children; child; child = child->next)
+		count++;
+
+	if (count < CHILD_RUN_MIN_CHILDREN) {
+		if (extra != NULL) {
+			talloc_free(extra->child_runs);
+			extra->child_runs = NULL;
+			extra->child_run_count = 0;
+		}
+		return;
+	}
+
+	extra = box_get_extra(box);
+	if (extra == NULL) {
+		/* Without an index every child is considered */
+		return;
+	}
+
+	count = (count + CHILD_RUN_LENGTH - 1) / CHILD_RUN_LENGTH;
+	runs = talloc_realloc(extra, extra->child_runs,
+			struct box_child_run, count);
+	if (runs == NULL) {
+		talloc_free(extra->child_runs);
+		extra->child_runs = NULL;
+		extra->child_run_count = 0;
+		return;
+	}
+
+	for (child = box->children; child; child = child->next, n++) {
+		int x0, y0, x1, y1;
+
+		if (n % CHILD_RUN_LENGTH == 0) {
+			run = &runs[n / CHILD_RUN_LENGTH];
+			run->first = child;
+			run->last = NULL;
+			run->x0 = run->y0 = INT_MAX;
+			run->x1 = run->y1 = INT_MIN;
+		}
+		child->child_run = n / CHILD_RUN_LENGTH;
+
+		/* Floats are positioned relative to their float container
+		 * and are reached through its float_children */
+		if (child->type == BOX_FLOAT_LEFT ||
+				child->type == BOX_FLOAT_RIGHT)
+			continue;
+
+		run->last = child;
+
+		x0 = min(child->descendant_x0, -child->border[LEFT].width);
+		y0 = min(child->descendant_y0, -child->border[TOP].width);
+		x1 = max(child->descendant_x1, child->padding[LEFT] +
+				child->width + child->padding[RIGHT] +
+				child->border[RIGHT].width);
+		y1 = max(child->descendant_y1, child->padding[TOP] +
+				child->height + child->padding[BOTTOM] +
+				child->border[BOTTOM].width);
+
+		run->x0 = min(run->x0, child->x + x0);
+		run->y0 = min(run->y0, child->y + y0);
+		run->x1 = max(run->x1, child->x + x1);
+		run->y1 = max(run->y1, child->y + y1);
+	}
+
+	extra->child_runs = runs;
+	extra->child_run_count = count;
+}
+
+
 /**
  * Recursively calculate the descendant_[xy][01] values for a laid-out box tree
  * and inform iframe browser windows of their size and position.
@@ -5323,14 +5816,15 @@ static void layout_calculate_descendant_bboxes(
 			box->descendant_y1 = content_get_height(box->object);
 	}
 
-	if (box->iframe != NULL) {
+	if (box_get_iframe(box) != NULL) {
+		struct browser_window *iframe = box_get_iframe(box);
 		int x, y;
 		box_coords(box, &x, &y);
 
-		browser_window_set_position(box->iframe, x, y);
-		browser_window_set_dimensions(box->iframe,
+		browser_window_set_position(iframe, x, y);
+		browser_window_set_dimensions(iframe,
 				box->width, box->height);
-		browser_window_reformat(box->iframe, true,
+		browser_window_reformat(iframe, true,
 				box->width, box->height);
 	}
 
@@ -5358,6 +5852,10 @@ static void layout_calculate_descendant_bboxes(
 		/* Box's children aren't displayed if the box is replaced */
 		return;
 
+	if (box->flags & LAYOUT_ESTIMATED)
+		/* Box's children haven't been laid out */
+		return;
+
 	for (child = box->children; child; child = child->next) {
 		if (child->type == BOX_FLOAT_LEFT ||
 				child->type == BOX_FLOAT_RIGHT)
@@ -5389,6 +5887,8 @@ static void layout_calculate_descendant_bboxes(
 
 		layout_update_descendant_bbox(unit_len_ctx, box, child, 0, 0);
 	}
+
+	layout_build_child_runs(box);
 }
 
 
@@ -5399,10 +5899,23 @@ bool layout_document(html_content *content, int width, int height)
 	struct box *doc = content->layout;
 	const struct gui_layout_table *font_func = content->font_func;
 
-	NSLOG(layout, DEBUG, "Doing layout to %ix%i of %s",
+	/* Boxes may only keep their previous layout for the same viewport */
+	content->layout_reuse = (width == content->layout_viewport_width &&
+			height == content->layout_viewport_height);
+	content->layout_viewport_width = width;
+	content->layout_viewport_height = height;
+	content->layout_estimated = 0;
+
+	NSLOG(layout, DEBUG, "Doing %s layout to %ix%i of %s",
+			content->layout_reuse ? "incremental" : "full",
 			width, height, nsurl_access(content_get_url(
 					&content->base)));
 
+	/* Min, max widths are kept between layouts, as they depend only on
+	 * style and content, except where viewport units are used. */
+	if (!content->layout_reuse)
+		layout_minmax_invalidate_viewport(doc);
+
 	layout_minmax_block(doc, font_func, content);
 
 	layout_block_find_dimensions(&content->unit_len_ctx,
@@ -5418,6 +5931,17 @@ bool layout_document(html_content *content, int width, int height)
 	doc->width = width;
 
 	ret = layout_block_context(doc, height, content);
+	if (ret == false) {
+		/* partial results must not be reused */
+		content->layout_viewport_width = -1;
+	}
+
+	if (content->layout_estimated != 0) {
+		NSLOG(layout, DEBUG, "Estimated %u inline containers outside "
+				"%i to %i", content->layout_estimated,
+				content->layout_lazy_y0,
+				content->layout_lazy_y1);
+	}
 
 	/* make <html> and <body> fill available height */
 	if (doc->y + doc->padding[TOP] + doc->height + doc->padding[BOTTOM] +
@@ -45,6 +45,8 @@
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
+#include "html/display_list.h"
 #include "html/object.h"
 
 /* break reference loop */
@@ -80,8 +82,8 @@ struct content_html_object *html_get_objects(hlcache_handle *h, unsigned int *n)
 static void
 html_object_failed(struct box *box, html_content *content, bool background)
 {
-	/* Nothing to do */
-	return;
+	/* the object may have been recorded while partially fetched */
+	html_display_list_invalidate(content->display_list);
 }
 
 /**
@@ -93,8 +95,6 @@ html_object_done(struct box *box,
 		 hlcache_handle *object,
 		 bool background)
 {
-	struct box *b;
-
 	if (background) {
 		box->background = object;
 		return;
@@ -112,11 +112,11 @@ html_object_done(struct box *box,
 		break;
 	}
 
-	if (!(box->flags & REPLACE_DIM)) {
-		/* invalidate parent min, max widths */
-		for (b = box; b; b = b->parent)
-			b->max_width = UNKNOWN_MAX_WIDTH;
+	/* the box needs laying out with its object, and unless its
+	 * dimensions were given, parent min, max widths are invalid */
+	box_mark_dirty(box, !(box->flags & REPLACE_DIM));
 
+	if (!(box->flags & REPLACE_DIM)) {
 		/* delete any clones of this box */
 		while (box->next && (box->next->flags & CLONE)) {
 			/* box_free_box(box->next); */
@@ -126,6 +126,49 @@ html_object_done(struct box *box,
 }
 
 
+/**
+ * Remove references to an object from the box displaying it.
+ *
+ * An object which redraws while it is still loading may already have
+ * been placed in its box.  The box must stop referring to it before the
+ * handle is released.
+ *
+ * \param htmlc   document containing the box
+ * \param box     box the object was fetched for, or NULL
+ * \param object  object about to be released
+ */
+static void
+html_object_detach(html_content *htmlc,
+		   struct box *box,
+		   hlcache_handle *object)
+{
+	bool detached = false;
+
+	if (box == NULL) {
+		return;
+	}
+
+	if (box->object == object) {
+		box->object = NULL;
+		detached = true;
+	}
+	if (box->background == object) {
+		box->background = NULL;
+		detached = true;
+	}
+
+	if (detached == false) {
+		return;
+	}
+
+	html_display_list_invalidate(htmlc->display_list);
+
+	if (htmlc->had_initial_layout && box_visible(box)) {
+		html__redraw_a_box(htmlc, box);
+	}
+}
+
+
 /**
  * Callback for hlcache_handle_retrieve() for objects with no box.
  */
@@ -171,7 +214,7 @@ html_object_callback(hlcache_handle *object,
 		if (c->base.status != CONTENT_STATUS_LOADING && c->bw != NULL)
 			content_open(object,
 					c->bw, &c->base,
-					box->object_params);
+					box_get_object_params(box));
 		break;
 
 	case CONTENT_MSG_READY:
@@ -185,6 +228,7 @@ html_object_callback(hlcache_handle *object,
 
 			/* Adjust parent content for new object size */
 			html_object_done(box, object, o->background);
+			html_display_list_invalidate(c->display_list);
 			if (c->base.status == CONTENT_STATUS_READY ||
 					c->base.status == CONTENT_STATUS_DONE)
 				content__reformat(&c->base, false,
@@ -198,6 +242,7 @@ html_object_callback(hlcache_handle *object,
 		NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
 
 		html_object_done(box, object, o->background);
+		html_display_list_invalidate(c->display_list);
 
 		if (c->base.status != CONTENT_STATUS_LOADING &&
 				box->flags & REPLACE_DIM) {
@@ -222,6 +267,7 @@ html_object_callback(hlcache_handle *object,
 		break;
 
 	case CONTENT_MSG_ERROR:
+		html_object_detach(c, box, object);
 		hlcache_handle_release(object);
 
 		o->content = NULL;
@@ -234,6 +280,18 @@ html_object_callback(hlcache_handle *object,
 		break;
 
 	case CONTENT_MSG_REDRAW:
+		if ((content_get_status(object) == CONTENT_STATUS_LOADING) &&
+		    (o->background ? box->background : box->object) != object) {
+			/* A partially fetched object is redrawing, so it
+			 * can be shown, as long as that does not need the
+			 * page to be laid out again. */
+			if (!o->background && !(box->flags & REPLACE_DIM)) {
+				break;
+			}
+			html_object_done(box, object, o->background);
+			html_display_list_invalidate(c->display_list);
+		}
+
 		if (c->base.status != CONTENT_STATUS_LOADING) {
 			union content_msg_data data = event->data;
 
@@ -377,13 +435,21 @@ html_object_callback(hlcache_handle *object,
 		break;
 
 	case CONTENT_MSG_SCROLL:
+	{
+		int sx = 0, sy = 0;
+
+		if (event->data.scroll.relative) {
+			sx = scrollbar_get_offset(box->scroll_x);
+			sy = scrollbar_get_offset(box->scroll_y);
+		}
 		if (box->scroll_x != NULL)
-			scrollbar_set(box->scroll_x, event->data.scroll.x0,
-					false);
+			scrollbar_set(box->scroll_x,
+					sx + event->data.scroll.x0, false);
 		if (box->scroll_y != NULL)
-			scrollbar_set(box->scroll_y, event->data.scroll.y0,
-					false);
+			scrollbar_set(box->scroll_y,
+					sy + event->data.scroll.y0, false);
 		break;
+	}
 
 	case CONTENT_MSG_DRAGSAVE:
 	{
@@ -475,6 +541,7 @@ html_object_callback(hlcache_handle *object,
 
 	if (c->base.status == CONTENT_STATUS_READY &&
 	    c->base.active == 0 &&
+	    c->box_conversion_context == NULL &&
 	    (event->type == CONTENT_MSG_LOADING ||
 	     event->type == CONTENT_MSG_DONE ||
 	     event->type == CONTENT_MSG_ERROR)) {
@@ -547,6 +614,7 @@ static bool html_replace_object(struct content_html_object *object, nsurl *url)
 		object->content = NULL;
 
 		object->box->object = NULL;
+		box_mark_dirty(object->box, true);
 	}
 
 	/* initialise fetch */
@@ -611,7 +679,7 @@ nserror html_object_open_objects(html_content *html, struct browser_window *bw)
 		content_open(object->content,
 			     bw,
 			     &html->base,
-			     object->box->object_params);
+			     box_get_object_params(object->box));
 	}
 	return NSERROR_OK;
 }
@@ -643,6 +711,8 @@ nserror html_object_abort_objects(html_content *htmlc)
 
 		default:
 			hlcache_handle_abort(object->content);
+			html_object_detach(htmlc, object->box,
+					object->content);
 			hlcache_handle_release(object->content);
 			object->content = NULL;
 			if (object->box != NULL) {
@@ -718,8 +788,9 @@ html_fetch_object(html_content *c,
 	hlcache_child_context child;
 	nserror error;
 
-	/* If we've already been aborted, don't bother attempting the fetch */
-	if (c->aborted)
+	/* If we've already been aborted or stopped, don't bother attempting
+	 * the fetch */
+	if (c->aborted || c->stopped)
 		return true;
 
 	child.charset = c->encoding;
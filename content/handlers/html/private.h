@@ -35,6 +35,9 @@ struct gui_layout_table;
 struct scrollbar_msg_data;
 struct content_redraw_data;
 struct selection;
+struct arena;
+struct nscss_style_share;
+struct html_display_list;
 
 typedef enum {
 	HTML_DRAG_NONE,			/** No drag */
@@ -109,12 +112,18 @@ typedef struct html_content {
 
 	/** Base URL (may be a copy of content->url). */
 	struct nsurl *base_url;
+	/** Base URL prepared for resolving links, or NULL */
+	struct nsurl_join_base *link_base;
 	/** Base target */
 	char *base_target;
 
 	/** Content has been aborted in the LOADING state */
 	bool aborted;
 
+	/** Content has been stopped in the READY state while its box tree
+	 * is still being built; no further objects are fetched */
+	bool stopped;
+
 	/** Whether a meta refresh has been handled */
 	bool refresh;
 
@@ -124,6 +133,26 @@ typedef struct html_content {
 	/** Whether an initial layout has been done */
 	bool had_initial_layout;
 
+	/** Viewport width of the previous layout, or -1 if none */
+	int layout_viewport_width;
+	/** Viewport height of the previous layout, or -1 if none */
+	int layout_viewport_height;
+	/** Whether unchanged boxes may keep their previous layout */
+	bool layout_reuse;
+
+	/** Whether text far from the viewport may be left unformatted */
+	bool layout_lazy;
+	/** Top of the document area laid out in full by a lazy layout */
+	int layout_lazy_y0;
+	/** Bottom of the document area laid out in full by a lazy layout */
+	int layout_lazy_y1;
+	/** Whether a lazy layout of the area shown is scheduled */
+	bool layout_lazy_scheduled;
+	/** Top of the area shown since the lazy layout was scheduled */
+	int layout_lazy_top;
+	/** Number of boxes given estimated heights by the last layout */
+	unsigned int layout_estimated;
+
 	/** Whether scripts are enabled for this content */
 	bool enable_scripting;
 
@@ -132,6 +161,8 @@ typedef struct html_content {
 
 	/** A talloc context purely for the render box tree */
 	int *bctx;
+	/** Region allocator for box tree text, freed with the box tree */
+	struct arena *box_arena;
 	/** A context pointer for the box conversion, NULL if no conversion
 	 * is in progress.
 	 */
@@ -144,6 +175,12 @@ typedef struct html_content {
 	/** Font callback table */
 	const struct gui_layout_table *font_func;
 
+	/** Text measurements made by layout, kept with the box tree */
+	struct font_measure_cache *measure_cache;
+
+	/** Plot operations recorded from the laid out box tree, or NULL */
+	struct html_display_list *display_list;
+
 	/** Number of entries in scripts */
 	unsigned int scripts_count;
 	/** Scripts */
@@ -157,6 +194,8 @@ typedef struct html_content {
 	struct html_stylesheet *stylesheets;
 	/**< Style selection context */
 	css_select_ctx *select_ctx;
+	/** Style sharing cache for siblings */
+	struct nscss_style_share *style_share;
 	/**< Style selection media specification */
 	css_media media;
 	/** CSS length conversion context for document. */
@@ -223,12 +262,30 @@ extern bool html_redraw_debug;
 /**
  * redraw a box
  *
+ * The display list is discarded unless the box is drawn live from the
+ * box tree, see html_redraw_box_is_live().
+ *
  * \param htmlc HTML content
  * \param box The box to redraw.
  */
 void html__redraw_a_box(html_content *htmlc, struct box *box);
 
 
+/**
+ * Lay out an area of a document whose layout was only estimated
+ *
+ * A reformat is scheduled if the area is not within the part of the
+ * document most recently laid out in full. The first box shown below
+ * the top of the area is kept in place by scrolling the document by
+ * however far the reformat moves it.
+ *
+ * \param htmlc HTML content
+ * \param y0 Top of the area, in document coordinates
+ * \param y1 Bottom of the area, in document coordinates
+ */
+void html_layout_lazy_show(html_content *htmlc, int y0, int y1);
+
+
 /**
  * Complete conversion of an HTML document
  *
@@ -298,6 +355,18 @@ nserror html_proceed_to_done(html_content *html);
 bool html_redraw(struct content *c, struct content_redraw_data *data,
 		const struct rect *clip, const struct redraw_context *ctx);
 
+/**
+ * Determine if a box is drawn from the box tree whenever it is redrawn
+ *
+ * The display list holds live entries for replaced elements, form
+ * controls and the children of scrollable boxes. A change to the
+ * appearance of such a box does not need the display list discarded.
+ *
+ * \param box  The box to check
+ * \return true if the box is drawn live, false if it is recorded
+ */
+bool html_redraw_box_is_live(struct box *box);
+
 
 /* in html/redraw_border.c */
 bool html_redraw_borders(struct box *box, int x_parent, int y_parent,
@@ -59,6 +59,7 @@
 #include "html/box.h"
 #include "html/box_inspect.h"
 #include "html/box_manipulate.h"
+#include "html/display_list.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 #include "html/private.h"
@@ -573,6 +574,32 @@ static bool html_redraw_file(int x, int y, int width, int height,
 }
 
 
+/**
+ * Redraw a background image content.
+ *
+ * When recording a display list the redraw is recorded instead, so that
+ * it reflects the image's state when the list is replayed.
+ *
+ * \param  h     background image content
+ * \param  data  redraw data for the content
+ * \param  clip  clip rectangle for the redraw
+ * \param  ctx   current redraw context
+ * \return true if successful, false otherwise
+ */
+
+static bool html_redraw_content(struct hlcache_handle *h,
+		struct content_redraw_data *data, const struct rect *clip,
+		const struct redraw_context *ctx)
+{
+	if (html_display_list_recording(ctx)) {
+		return html_display_list_content(ctx, h, data, clip) ==
+				NSERROR_OK;
+	}
+
+	return content_redraw(h, data, clip, ctx);
+}
+
+
 /**
  * Plot background images.
  *
@@ -791,7 +818,7 @@ static bool html_redraw_background(int x, int y, struct box *box, float scale,
 				bg_data.repeat_y = repeat_y;
 
 				/* We just continue if redraw fails */
-				content_redraw(background->background,
+				html_redraw_content(background->background,
 						&bg_data, &r, ctx);
 			}
 		}
@@ -951,7 +978,7 @@ static bool html_redraw_inline_background(int x, int y, struct box *box,
 			bg_data.repeat_y = repeat_y;
 
 			/* We just continue if redraw fails */
-			content_redraw(box->background, &bg_data, &r, ctx);
+			html_redraw_content(box->background, &bg_data, &r, ctx);
 		}
 	}
 
@@ -1159,6 +1186,298 @@ static bool html_redraw_text_box(const html_content *html, struct box *box,
 	return true;
 }
 
+/**
+ * Determine if a box is a canvas with a bitmap to draw.
+ *
+ * \param  box  box to consider
+ * \return true if the box is a canvas, false otherwise
+ */
+
+static bool html_redraw_box_is_canvas(struct box *box)
+{
+	dom_html_element_type tag_type;
+	dom_exception exc;
+
+	if (box->node == NULL || (box->flags & REPLACE_DIM) == 0)
+		return false;
+
+	exc = dom_html_element_get_tag_type(box->node, &tag_type);
+
+	return (exc == DOM_NO_ERR && tag_type == DOM_HTML_ELEMENT_TYPE_CANVAS);
+}
+
+
+/**
+ * Determine if the content of a box is a replaced element or form control.
+ *
+ * \param  box     box to consider
+ * \param  width   width of the box content
+ * \param  height  height of the box content
+ * \return true if the content is drawn by html_redraw_box_replaced()
+ */
+
+static bool html_redraw_box_is_replaced(struct box *box,
+		int width, int height)
+{
+	if (box->object && width != 0 && height != 0)
+		return true;
+
+	if (html_redraw_box_is_canvas(box) || box_get_iframe(box))
+		return true;
+
+	return (box->gadget != NULL &&
+			(box->gadget->type == GADGET_CHECKBOX ||
+			box->gadget->type == GADGET_RADIO ||
+			box->gadget->type == GADGET_FILE ||
+			box->gadget->type == GADGET_TEXTAREA ||
+			box->gadget->type == GADGET_PASSWORD ||
+			box->gadget->type == GADGET_TEXTBOX));
+}
+
+
+/**
+ * Draw the content of a replaced element or form control.
+ *
+ * \param  html	     html content
+ * \param  box	     box to draw content of
+ * \param  x_parent  coordinate of parent box
+ * \param  y_parent  coordinate of parent box
+ * \param  clip      clip rectangle
+ * \param  scale     scale for redraw
+ * \param  current_background_color  background colour under this box
+ * \param  ctx	     current redraw context
+ * \return true if successful, false otherwise
+ */
+
+static bool html_redraw_box_replaced(const html_content *html,
+		struct box *box, int x_parent, int y_parent,
+		const struct rect *clip, float scale,
+		colour current_background_color,
+		const struct redraw_context *ctx)
+{
+	int x = (x_parent + box->x) * scale;
+	int y = (y_parent + box->y) * scale;
+	int width = box->width * scale;
+	int height = box->height * scale;
+	int padding_left = box->padding[LEFT] * scale;
+	int padding_top = box->padding[TOP] * scale;
+	int x_scrolled, y_scrolled;
+	struct rect rect;
+	dom_exception exc;
+
+	if (box->object && width != 0 && height != 0) {
+		struct content_redraw_data obj_data;
+
+		x_scrolled = x - scrollbar_get_offset(box->scroll_x) * scale;
+		y_scrolled = y - scrollbar_get_offset(box->scroll_y) * scale;
+
+		obj_data.x = x_scrolled + padding_left;
+		obj_data.y = y_scrolled + padding_top;
+		obj_data.width = width;
+		obj_data.height = height;
+		obj_data.background_colour = current_background_color;
+		obj_data.scale = scale;
+		obj_data.repeat_x = false;
+		obj_data.repeat_y = false;
+
+		if (content_get_type(box->object) == CONTENT_HTML) {
+			obj_data.x /= scale;
+			obj_data.y /= scale;
+		}
+
+		if (!content_redraw(box->object, &obj_data, clip, ctx)) {
+			/* Show image fail */
+			/* Unicode (U+FFFC) 'OBJECT REPLACEMENT CHARACTER' */
+			const char *obj = "\xef\xbf\xbc";
+			int obj_width;
+			int obj_x = x + padding_left;
+			nserror res;
+
+			rect.x0 = x + padding_left;
+			rect.y0 = y + padding_top;
+			rect.x1 = x + padding_left + width - 1;
+			rect.y1 = y + padding_top + height - 1;
+			res = ctx->plot->rectangle(ctx, plot_style_broken_object, &rect);
+			if (res != NSERROR_OK) {
+				return false;
+			}
+
+			res = guit->layout->width(plot_fstyle_broken_object,
+						  obj,
+						  sizeof(obj) - 1,
+						  &obj_width);
+			if (res != NSERROR_OK) {
+				obj_x += 1;
+			} else {
+				obj_x += width / 2 - obj_width / 2;
+			}
+
+			if (ctx->plot->text(ctx,
+					    plot_fstyle_broken_object,
+					    obj_x, y + padding_top + (int)(height * 0.75),
+					    obj, sizeof(obj) - 1) != NSERROR_OK)
+				return false;
+		}
+	} else if (html_redraw_box_is_canvas(box)) {
+		/* Canvas to draw */
+		struct bitmap *bitmap = NULL;
+		exc = dom_node_get_user_data(box->node,
+					     corestring_dom___ns_key_canvas_node_data,
+					     &bitmap);
+		if (exc != DOM_NO_ERR) {
+			bitmap = NULL;
+		}
+		if (bitmap != NULL &&
+		    ctx->plot->bitmap(ctx, bitmap, x + padding_left, y + padding_top,
+				      width, height, current_background_color,
+				      BITMAPF_NONE) != NSERROR_OK)
+			return false;
+	} else if (box_get_iframe(box)) {
+		/* Offset is passed to browser window redraw unscaled */
+		browser_window_redraw(box_get_iframe(box),
+				x + padding_left,
+				y + padding_top, clip, ctx);
+
+	} else if (box->gadget && box->gadget->type == GADGET_CHECKBOX) {
+		if (!html_redraw_checkbox(x + padding_left, y + padding_top,
+				width, height, box->gadget->selected, ctx))
+			return false;
+
+	} else if (box->gadget && box->gadget->type == GADGET_RADIO) {
+		if (!html_redraw_radio(x + padding_left, y + padding_top,
+				width, height, box->gadget->selected, ctx))
+			return false;
+
+	} else if (box->gadget && box->gadget->type == GADGET_FILE) {
+		if (!html_redraw_file(x + padding_left, y + padding_top,
+				width, height, box, scale,
+				current_background_color, &html->unit_len_ctx, ctx))
+			return false;
+
+	} else if (box->gadget &&
+			(box->gadget->type == GADGET_TEXTAREA ||
+			box->gadget->type == GADGET_PASSWORD ||
+			box->gadget->type == GADGET_TEXTBOX)) {
+		textarea_redraw(box->gadget->data.text.ta, x, y,
+				current_background_color, scale, clip, ctx);
+	}
+
+	return true;
+}
+
+
+/**
+ * Determine if a box may have scrollbars.
+ *
+ * \param  box         box to consider
+ * \param  overflow_x  computed overflow-x of the box
+ * \param  overflow_y  computed overflow-y of the box
+ * \return true if the box may have scrollbars, false otherwise
+ */
+
+static bool html_redraw_box_has_scrollbars(struct box *box,
+		enum css_overflow_e overflow_x,
+		enum css_overflow_e overflow_y)
+{
+	return ((box->style && box->type != BOX_BR &&
+	      box->type != BOX_TABLE && box->type != BOX_INLINE &&
+	      (box->gadget == NULL || box->gadget->type != GADGET_TEXTAREA) &&
+	      (overflow_x == CSS_OVERFLOW_SCROLL ||
+	       overflow_x == CSS_OVERFLOW_AUTO ||
+	       overflow_y == CSS_OVERFLOW_SCROLL ||
+	       overflow_y == CSS_OVERFLOW_AUTO)) ||
+	     (box->object && content_get_type(box->object) ==
+	      CONTENT_HTML)) && box->parent != NULL;
+}
+
+
+/* exported interface documented in html/private.h */
+bool html_redraw_box_is_live(struct box *box)
+{
+	struct box *parent;
+
+	if (html_redraw_box_is_replaced(box, box->width, box->height))
+		return true;
+
+	/* the children of a scrollable box are redrawn from the box tree */
+	for (parent = box->parent; parent != NULL; parent = parent->parent) {
+		enum css_overflow_e overflow_x = CSS_OVERFLOW_VISIBLE;
+		enum css_overflow_e overflow_y = CSS_OVERFLOW_VISIBLE;
+
+		if (parent->style != NULL) {
+			overflow_x = css_computed_overflow_x(parent->style);
+			overflow_y = css_computed_overflow_y(parent->style);
+		}
+
+		if (html_redraw_box_has_scrollbars(parent,
+				overflow_x, overflow_y))
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * Draw the scrollbars of a box, creating or removing them as needed.
+ *
+ * \param  html	     html content
+ * \param  box	     box to draw scrollbars of
+ * \param  x_parent  coordinate of parent box
+ * \param  y_parent  coordinate of parent box
+ * \param  clip      clip rectangle
+ * \param  scale     scale for redraw
+ * \param  ctx	     current redraw context
+ * \return true if successful, false otherwise
+ */
+
+static bool html_redraw_box_scrollbars(const html_content *html,
+		struct box *box, int x_parent, int y_parent,
+		const struct rect *clip, float scale,
+		const struct redraw_context *ctx)
+{
+	enum css_overflow_e overflow_x = CSS_OVERFLOW_VISIBLE;
+	enum css_overflow_e overflow_y = CSS_OVERFLOW_VISIBLE;
+	bool has_x_scroll;
+	bool has_y_scroll;
+	nserror res;
+
+	if (box->style != NULL) {
+		overflow_x = css_computed_overflow_x(box->style);
+		overflow_y = css_computed_overflow_y(box->style);
+	}
+
+	has_x_scroll = (overflow_x == CSS_OVERFLOW_SCROLL);
+	has_y_scroll = (overflow_y == CSS_OVERFLOW_SCROLL);
+
+	has_x_scroll |= (overflow_x == CSS_OVERFLOW_AUTO) &&
+			box_hscrollbar_present(box);
+	has_y_scroll |= (overflow_y == CSS_OVERFLOW_AUTO) &&
+			box_vscrollbar_present(box);
+
+	res = box_handle_scrollbars((struct content *)html,
+				    box, has_x_scroll, has_y_scroll);
+	if (res != NSERROR_OK) {
+		NSLOG(netsurf, INFO, "%s", messages_get_errorcode(res));
+		return false;
+	}
+
+	if (box->scroll_x != NULL)
+		scrollbar_redraw(box->scroll_x,
+				x_parent + box->x,
+				y_parent + box->y + box->padding[TOP] +
+				box->height + box->padding[BOTTOM] -
+				SCROLLBAR_WIDTH, clip, scale, ctx);
+	if (box->scroll_y != NULL)
+		scrollbar_redraw(box->scroll_y,
+				x_parent + box->x + box->padding[LEFT] +
+				box->width + box->padding[RIGHT] -
+				SCROLLBAR_WIDTH,
+				y_parent + box->y, clip, scale, ctx);
+
+	return true;
+}
+
 bool html_redraw_box(const html_content *html, struct box *box,
 		int x_parent, int y_parent,
 		const struct rect *clip, float scale,
@@ -1185,26 +1504,49 @@ static bool html_redraw_box_children(const html_content *html, struct box *box,
 		colour current_background_color,
 		const struct redraw_context *ctx)
 {
+	int x = x_parent + box->x - scrollbar_get_offset(box->scroll_x);
+	int y = y_parent + box->y - scrollbar_get_offset(box->scroll_y);
+	const struct box_child_run *runs = NULL;
+	unsigned int run_count = 0;
+	unsigned int run = 0;
 	struct box *c;
 
+	/* Children of a box whose layout was estimated have no position */
+	if (box->flags & LAYOUT_ESTIMATED)
+		return true;
+
+	if (box->extra != NULL) {
+		runs = box->extra->child_runs;
+		run_count = box->extra->child_run_count;
+	}
+
 	for (c = box->children; c; c = c->next) {
+		if (runs != NULL && run < run_count && c == runs[run].first) {
+			const struct box_child_run *r = &runs[run++];
+
+			/* skip runs of children with nothing to draw inside
+			 * the clip rectangle, allowing for rounding when
+			 * scaled */
+			if (r->last == NULL ||
+					clip->y1 < (y + r->y0) * scale - 1 ||
+					(y + r->y1) * scale + 1 < clip->y0 ||
+					clip->x1 < (x + r->x0) * scale - 1 ||
+					(x + r->x1) * scale + 1 < clip->x0) {
+				if (run == run_count)
+					break;
+				c = runs[run].first->prev;
+				continue;
+			}
+		}
 
 		if (c->type != BOX_FLOAT_LEFT && c->type != BOX_FLOAT_RIGHT)
-			if (!html_redraw_box(html, c,
-					x_parent + box->x -
-					scrollbar_get_offset(box->scroll_x),
-					y_parent + box->y -
-					scrollbar_get_offset(box->scroll_y),
+			if (!html_redraw_box(html, c, x, y,
 					clip, scale, current_background_color,
 					ctx))
 				return false;
 	}
 	for (c = box->float_children; c; c = c->next_float)
-		if (!html_redraw_box(html, c,
-				x_parent + box->x -
-				scrollbar_get_offset(box->scroll_x),
-				y_parent + box->y -
-				scrollbar_get_offset(box->scroll_y),
+		if (!html_redraw_box(html, c, x, y,
 				clip, scale, current_background_color,
 				ctx))
 			return false;
@@ -1241,13 +1583,10 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	int border_left, border_top, border_right, border_bottom;
 	struct rect r;
 	struct rect rect;
-	int x_scrolled, y_scrolled;
 	struct box *bg_box = NULL;
 	css_computed_clip_rect css_rect;
 	enum css_overflow_e overflow_x = CSS_OVERFLOW_VISIBLE;
 	enum css_overflow_e overflow_y = CSS_OVERFLOW_VISIBLE;
-	dom_exception exc;
-	dom_html_element_type tag_type;
 
 
 	if (html_redraw_printing && (box->flags & PRINTED))
@@ -1746,117 +2085,39 @@ bool html_redraw_box(const html_content *html, struct box *box,
 			return false;
 	}
 
-	if (box->node != NULL) {
-		exc = dom_html_element_get_tag_type(box->node, &tag_type);
-		if (exc != DOM_NO_ERR) {
-			tag_type = DOM_HTML_ELEMENT_TYPE__UNKNOWN;
-		}
-	} else {
-		tag_type = DOM_HTML_ELEMENT_TYPE__UNKNOWN;
-	}
-
-	if (box->object && width != 0 && height != 0) {
-		struct content_redraw_data obj_data;
-
-		x_scrolled = x - scrollbar_get_offset(box->scroll_x) * scale;
-		y_scrolled = y - scrollbar_get_offset(box->scroll_y) * scale;
-
-		obj_data.x = x_scrolled + padding_left;
-		obj_data.y = y_scrolled + padding_top;
-		obj_data.width = width;
-		obj_data.height = height;
-		obj_data.background_colour = current_background_color;
-		obj_data.scale = scale;
-		obj_data.repeat_x = false;
-		obj_data.repeat_y = false;
-
-		if (content_get_type(box->object) == CONTENT_HTML) {
-			obj_data.x /= scale;
-			obj_data.y /= scale;
-		}
-
-		if (!content_redraw(box->object, &obj_data, &r, ctx)) {
-			/* Show image fail */
-			/* Unicode (U+FFFC) 'OBJECT REPLACEMENT CHARACTER' */
-			const char *obj = "\xef\xbf\xbc";
-			int obj_width;
-			int obj_x = x + padding_left;
-			nserror res;
-
-			rect.x0 = x + padding_left;
-			rect.y0 = y + padding_top;
-			rect.x1 = x + padding_left + width - 1;
-			rect.y1 = y + padding_top + height - 1;
-			res = ctx->plot->rectangle(ctx, plot_style_broken_object, &rect);
-			if (res != NSERROR_OK) {
+	if (html_redraw_box_is_replaced(box, width, height)) {
+		if (html_display_list_recording(ctx)) {
+			if (html_display_list_live(ctx,
+					HTML_DISPLAY_LIST_LIVE_REPLACED, box,
+					x_parent, y_parent, &r, &r,
+					current_background_color) != NSERROR_OK)
 				return false;
-			}
-
-			res = guit->layout->width(plot_fstyle_broken_object,
-						  obj,
-						  sizeof(obj) - 1,
-						  &obj_width);
-			if (res != NSERROR_OK) {
-				obj_x += 1;
-			} else {
-				obj_x += width / 2 - obj_width / 2;
-			}
-
-			if (ctx->plot->text(ctx,
-					    plot_fstyle_broken_object,
-					    obj_x, y + padding_top + (int)(height * 0.75),
-					    obj, sizeof(obj) - 1) != NSERROR_OK)
-				return false;
-		}
-	} else if (tag_type == DOM_HTML_ELEMENT_TYPE_CANVAS &&
-		   box->node != NULL &&
-		   box->flags & REPLACE_DIM) {
-		/* Canvas to draw */
-		struct bitmap *bitmap = NULL;
-		exc = dom_node_get_user_data(box->node,
-					     corestring_dom___ns_key_canvas_node_data,
-					     &bitmap);
-		if (exc != DOM_NO_ERR) {
-			bitmap = NULL;
-		}
-		if (bitmap != NULL &&
-		    ctx->plot->bitmap(ctx, bitmap, x + padding_left, y + padding_top,
-				      width, height, current_background_color,
-				      BITMAPF_NONE) != NSERROR_OK)
-			return false;
-	} else if (box->iframe) {
-		/* Offset is passed to browser window redraw unscaled */
-		browser_window_redraw(box->iframe,
-				x + padding_left,
-				y + padding_top, &r, ctx);
-
-	} else if (box->gadget && box->gadget->type == GADGET_CHECKBOX) {
-		if (!html_redraw_checkbox(x + padding_left, y + padding_top,
-				width, height, box->gadget->selected, ctx))
+		} else if (!html_redraw_box_replaced(html, box,
+				x_parent, y_parent, &r, scale,
+				current_background_color, ctx)) {
 			return false;
-
-	} else if (box->gadget && box->gadget->type == GADGET_RADIO) {
-		if (!html_redraw_radio(x + padding_left, y + padding_top,
-				width, height, box->gadget->selected, ctx))
-			return false;
-
-	} else if (box->gadget && box->gadget->type == GADGET_FILE) {
-		if (!html_redraw_file(x + padding_left, y + padding_top,
-				width, height, box, scale,
-				current_background_color, &html->unit_len_ctx, ctx))
-			return false;
-
-	} else if (box->gadget &&
-			(box->gadget->type == GADGET_TEXTAREA ||
-			box->gadget->type == GADGET_PASSWORD ||
-			box->gadget->type == GADGET_TEXTBOX)) {
-		textarea_redraw(box->gadget->data.text.ta, x, y,
-				current_background_color, scale, &r, ctx);
+		}
 
 	} else if (box->text) {
+		if (html_display_list_recording(ctx))
+			html_display_list_text_box(ctx, box, x, y,
+					current_background_color);
 		if (!html_redraw_text_box(html, box, x, y, &r, scale,
 				current_background_color, ctx))
 			return false;
+		if (html_display_list_recording(ctx))
+			html_display_list_text_box(ctx, NULL, 0, 0,
+					current_background_color);
+
+	} else if (html_display_list_recording(ctx) &&
+			html_redraw_box_has_scrollbars(box,
+					overflow_x, overflow_y)) {
+		/* scrolling moves the children without a layout */
+		if (html_display_list_live(ctx,
+				HTML_DISPLAY_LIST_LIVE_CHILDREN, box,
+				x_parent, y_parent, &r, &r,
+				current_background_color) != NSERROR_OK)
+			return false;
 
 	} else {
 		if (!html_redraw_box_children(html, box, x_parent, y_parent, &r,
@@ -1881,43 +2142,21 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	}
 
 	/* scrollbars */
-	if (((box->style && box->type != BOX_BR &&
-	      box->type != BOX_TABLE && box->type != BOX_INLINE &&
-	      (box->gadget == NULL || box->gadget->type != GADGET_TEXTAREA) &&
-	      (overflow_x == CSS_OVERFLOW_SCROLL ||
-	       overflow_x == CSS_OVERFLOW_AUTO ||
-	       overflow_y == CSS_OVERFLOW_SCROLL ||
-	       overflow_y == CSS_OVERFLOW_AUTO)) ||
-	     (box->object && content_get_type(box->object) ==
-	      CONTENT_HTML)) && box->parent != NULL) {
-		nserror res;
-		bool has_x_scroll = (overflow_x == CSS_OVERFLOW_SCROLL);
-		bool has_y_scroll = (overflow_y == CSS_OVERFLOW_SCROLL);
-
-		has_x_scroll |= (overflow_x == CSS_OVERFLOW_AUTO) &&
-				box_hscrollbar_present(box);
-		has_y_scroll |= (overflow_y == CSS_OVERFLOW_AUTO) &&
-				box_vscrollbar_present(box);
-
-		res = box_handle_scrollbars((struct content *)html,
-					    box, has_x_scroll, has_y_scroll);
-		if (res != NSERROR_OK) {
-			NSLOG(netsurf, INFO, "%s", messages_get_errorcode(res));
+	if (html_redraw_box_has_scrollbars(box, overflow_x, overflow_y)) {
+		if (html_display_list_recording(ctx)) {
+			rect.x0 = x - border_left;
+			rect.y0 = y - border_top;
+			rect.x1 = x + padding_width + border_right;
+			rect.y1 = y + padding_height + border_bottom;
+			if (html_display_list_live(ctx,
+					HTML_DISPLAY_LIST_LIVE_SCROLLBARS, box,
+					x_parent, y_parent, &rect, clip,
+					current_background_color) != NSERROR_OK)
+				return false;
+		} else if (!html_redraw_box_scrollbars(html, box,
+				x_parent, y_parent, clip, scale, ctx)) {
 			return false;
 		}
-
-		if (box->scroll_x != NULL)
-			scrollbar_redraw(box->scroll_x,
-					x_parent + box->x,
-					y_parent + box->y + box->padding[TOP] +
-					box->height + box->padding[BOTTOM] -
-					SCROLLBAR_WIDTH, clip, scale, ctx);
-		if (box->scroll_y != NULL)
-			scrollbar_redraw(box->scroll_y,
-					x_parent + box->x + box->padding[LEFT] +
-					box->width + box->padding[RIGHT] -
-					SCROLLBAR_WIDTH,
-					y_parent + box->y, clip, scale, ctx);
 	}
 
 	if (box->type == BOX_BLOCK || box->type == BOX_INLINE_BLOCK ||
@@ -1929,6 +2168,112 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	return ((!plot->group_end) || (ctx->plot->group_end(ctx) == NSERROR_OK));
 }
 
+/**
+ * Redraw a live display list entry from the box tree.
+ *
+ * \param  html  html content
+ * \param  live  live entry to redraw
+ * \param  clip  clip rectangle
+ * \param  ctx   current redraw context
+ * \return true if successful, false otherwise
+ */
+
+static bool html_redraw_live(const struct html_content *html,
+		const struct html_display_list_box *live,
+		const struct rect *clip,
+		const struct redraw_context *ctx)
+{
+	switch (live->kind) {
+	case HTML_DISPLAY_LIST_LIVE_REPLACED:
+		return html_redraw_box_replaced(html, live->box,
+				live->x, live->y, clip, 1.0,
+				live->background, ctx);
+
+	case HTML_DISPLAY_LIST_LIVE_CHILDREN:
+		return html_redraw_box_children(html, live->box,
+				live->x, live->y, clip, 1.0,
+				live->background, ctx);
+
+	case HTML_DISPLAY_LIST_LIVE_SCROLLBARS:
+		return html_redraw_box_scrollbars(html, live->box,
+				live->x, live->y, clip, 1.0, ctx);
+
+	case HTML_DISPLAY_LIST_LIVE_TEXT:
+		return html_redraw_text_box(html, live->box,
+				live->x, live->y, clip, 1.0,
+				live->background, ctx);
+	}
+
+	return true;
+}
+
+
+/**
+ * Draw a CONTENT_HTML from its display list, recording it if needed.
+ *
+ * The display list is only used for interactive redraws at 100% scale,
+ * which covers scrolling and other repeated redraws of the same layout.
+ *
+ * \param  html        html content
+ * \param  data        redraw data for this content redraw
+ * \param  clip        current clip region
+ * \param  background  background colour the document is drawn on
+ * \param  ctx         current redraw context
+ * \param  result      updated to the result of the redraw if one was made
+ * \return true if the display list was used, false if the box tree must
+ *         be redrawn directly
+ */
+
+static bool html_redraw_display_list(html_content *html,
+		const struct content_redraw_data *data,
+		const struct rect *clip, colour background,
+		const struct redraw_context *ctx, bool *result)
+{
+	struct redraw_context record_ctx = *ctx;
+	struct rect record_clip;
+	bool live_text;
+	bool ok;
+
+	if (!ctx->interactive || !ctx->background_images ||
+			data->scale != 1.0 || html_redraw_debug ||
+			html_redraw_printing || html->reflowing) {
+		return false;
+	}
+
+	if (html->display_list == NULL &&
+			html_display_list_create(&html->display_list) !=
+			NSERROR_OK) {
+		return false;
+	}
+
+	if (!html_display_list_valid(html->display_list, background)) {
+		if (html_display_list_record_start(html->display_list,
+				background, &record_ctx, &record_clip) !=
+				NSERROR_OK) {
+			return false;
+		}
+
+		ok = html_redraw_box(html, html->layout, 0, 0, &record_clip,
+				1.0, background, &record_ctx);
+
+		if (html_display_list_record_end(html->display_list, ok) !=
+				NSERROR_OK) {
+			return false;
+		}
+	}
+
+	/* selected and found text is highlighted by redrawing it live */
+	live_text = selection_active(html->sel) ||
+			(html->base.textsearch.context != NULL);
+
+	*result = html_display_list_replay(html->display_list, html,
+			data->x, data->y, clip, live_text,
+			html_redraw_live, ctx);
+
+	return true;
+}
+
+
 /**
  * Draw a CONTENT_HTML using the current set of plotters (plot).
  *
@@ -1947,6 +2292,7 @@ bool html_redraw(struct content *c, struct content_redraw_data *data,
 	html_content *html = (html_content *) c;
 	struct box *box;
 	bool result = true;
+	bool ok;
 	bool select, select_only;
 	plot_style_t pstyle_fill_bg = {
 		.fill_type = PLOT_OP_TYPE_SOLID,
@@ -1979,8 +2325,20 @@ bool html_redraw(struct content *c, struct content_redraw_data *data,
 
 		result &= (ctx->plot->rectangle(ctx, &pstyle_fill_bg, clip) == NSERROR_OK);
 
-		result &= html_redraw_box(html, box, data->x, data->y, clip,
-				data->scale, pstyle_fill_bg.fill_colour, ctx);
+		if (!html_redraw_display_list(html, data, clip,
+				pstyle_fill_bg.fill_colour, ctx, &ok)) {
+			ok = html_redraw_box(html, box, data->x, data->y, clip,
+					data->scale, pstyle_fill_bg.fill_colour,
+					ctx);
+		}
+		result &= ok;
+
+		/* Lay out any of the area drawn which was only estimated */
+		if (ctx->interactive && html->layout_estimated != 0) {
+			html_layout_lazy_show(html,
+					(int)(clip->y0 / data->scale) - data->y,
+					(int)(clip->y1 / data->scale) - data->y);
+		}
 	}
 
 	if (select) {
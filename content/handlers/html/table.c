@@ -47,6 +47,18 @@ struct border {
 	css_unit unit;			/**< border-width units */
 };
 
+/**
+ * Position reached in a row while finding the cells above a cell
+ *
+ * Cells within a row are in column order and the cells of a table are
+ * processed from left to right, so each search of the row above can
+ * resume from the first cell the previous search found.
+ */
+struct table_row_cursor {
+	const struct box *row;	/**< Row searched, or NULL */
+	struct box *cell;	/**< First cell above the previous cell */
+};
+
 
 /**
  * Determine if a border style is more eyecatching than another
@@ -202,6 +214,7 @@ table_cell_top_process_table(const css_unit_ctx *unit_len_ctx,
  * \param row      Row to process
  * \param a        Current border style for cell
  * \param a_src    Source of \a a
+ * \param cursor   Position of previous search of rows, or NULL
  * \return true if row has cells, false otherwise
  *
  * \post \a a will be updated with most eyecatching style
@@ -212,7 +225,8 @@ table_cell_top_process_row(const css_unit_ctx *unit_len_ctx,
 			   struct box *cell,
 			   struct box *row,
 			   struct border *a,
-			   box_type *a_src)
+			   box_type *a_src,
+			   struct table_row_cursor *cursor)
 {
 	struct border b;
 	box_type b_src;
@@ -256,15 +270,28 @@ table_cell_top_process_row(const css_unit_ctx *unit_len_ctx,
 		bool processed = false;
 
 		while (processed == false) {
-			for (c = row->children; c != NULL; c = c->next) {
+			c = row->children;
+			if (cursor != NULL && cursor->row == row &&
+			    cursor->cell->start_column <= cell->start_column) {
+				/* Cells before the cursor end further left */
+				c = cursor->cell;
+			}
+
+			for (; c != NULL; c = c->next) {
 				/* Ignore cells to the left */
 				if (c->start_column + c->columns - 1 <
 				    cell->start_column)
 					continue;
-				/* Ignore cells to the right */
+				/* Cells are in column order, so the remaining
+				 * cells are all to the right */
 				if (c->start_column > cell->start_column +
 				    cell->columns - 1)
-					continue;
+					break;
+
+				if (processed == false && cursor != NULL) {
+					cursor->row = row;
+					cursor->cell = c;
+				}
 
 				/* Flag that we've processed a cell */
 				processed = true;
@@ -313,6 +340,7 @@ table_cell_top_process_row(const css_unit_ctx *unit_len_ctx,
  * \param group    Group to process
  * \param a        Current border style for cell
  * \param a_src    Source of \a a
+ * \param cursor   Position of previous search of rows, or NULL
  * \return true if group has non-empty rows, false otherwise
  *
  * \post \a a will be updated with most eyecatching style
@@ -323,7 +351,8 @@ table_cell_top_process_group(const css_unit_ctx *unit_len_ctx,
 			     struct box *cell,
 			     struct box *group,
 			     struct border *a,
-			     box_type *a_src)
+			     box_type *a_src,
+			     struct table_row_cursor *cursor)
 {
 	struct border b;
 	box_type b_src;
@@ -347,7 +376,7 @@ table_cell_top_process_group(const css_unit_ctx *unit_len_ctx,
 		struct box *row = group->last;
 
 		while (table_cell_top_process_row(unit_len_ctx, cell, row,
-						  a, a_src) == false) {
+						  a, a_src, cursor) == false) {
 			if (row->prev == NULL) {
 				return false;
 			} else {
@@ -514,9 +543,12 @@ table_used_left_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *ce
  *
  * \param unit_len_ctx  Length conversion context
  * \param cell     Table cell to consider
+ * \param cursor   Position of previous search of rows, or NULL
  */
 static void
-table_used_top_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *cell)
+table_used_top_border_for_cell(const css_unit_ctx *unit_len_ctx,
+			       struct box *cell,
+			       struct table_row_cursor *cursor)
 {
 	struct border a, b;
 	box_type a_src, b_src;
@@ -549,7 +581,7 @@ table_used_top_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *cel
 	if (row->prev != NULL) {
 		/* Consider row(s) above */
 		while (table_cell_top_process_row(unit_len_ctx, cell, row->prev,
-						  &a, &a_src) == false) {
+						  &a, &a_src, cursor) == false) {
 			if (row->prev->prev == NULL) {
 				/* Consider row group */
 				process_group = true;
@@ -588,7 +620,8 @@ table_used_top_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *cel
 			/* Process previous group(s) */
 			while (table_cell_top_process_group(unit_len_ctx,
 							    cell, group->prev,
-							    &a, &a_src) == false) {
+							    &a, &a_src,
+							    cursor) == false) {
 				if (group->prev->prev == NULL) {
 					/* Top border of table */
 					table_cell_top_process_table(unit_len_ctx,
@@ -984,8 +1017,17 @@ table_calculate_column_types(const css_unit_ctx *unit_len_ctx, struct box *table
 }
 
 
-/* exported interface documented in html/table.h */
-void table_used_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *cell)
+/**
+ * Calculate used values of border-{trbl}-{style,color,width} for a cell
+ *
+ * \param unit_len_ctx  Length conversion context
+ * \param cell     Table cell to consider
+ * \param cursor   Position of previous search of rows, or NULL
+ */
+static void
+table_used_border_for_cell(const css_unit_ctx *unit_len_ctx,
+			   struct box *cell,
+			   struct table_row_cursor *cursor)
 {
 	int side;
 
@@ -1044,7 +1086,7 @@ void table_used_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *ce
 		table_used_left_border_for_cell(unit_len_ctx, cell);
 
 		/* Top border */
-		table_used_top_border_for_cell(unit_len_ctx, cell);
+		table_used_top_border_for_cell(unit_len_ctx, cell, cursor);
 
 		/* Right border */
 		table_used_right_border_for_cell(unit_len_ctx, cell);
@@ -1062,3 +1104,24 @@ void table_used_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *ce
 			cell->border[side].width = 0;
 	}
 }
+
+
+/* exported interface documented in html/table.h */
+void table_used_borders(const css_unit_ctx *unit_len_ctx, struct box *table)
+{
+	struct table_row_cursor cursor = { NULL, NULL };
+	struct box *row_group, *row, *cell;
+
+	assert(table->type == BOX_TABLE);
+
+	for (row_group = table->children; row_group != NULL;
+	     row_group = row_group->next) {
+		for (row = row_group->children; row != NULL; row = row->next) {
+			for (cell = row->children; cell != NULL;
+			     cell = cell->next) {
+				table_used_border_for_cell(unit_len_ctx,
+							   cell, &cursor);
+			}
+		}
+	}
+}
@@ -46,11 +46,14 @@ bool table_calculate_column_types(const css_unit_ctx *unit_len_ctx,	struct box *
 /**
  * Calculate used values of border-{trbl}-{style,color,width} for table cells.
  *
+ * The cells are processed in document order, which lets the collapsing
+ * border model find the cells above each cell without rescanning rows.
+ *
  * \param unit_len_ctx Length conversion context
- * \param cell Table cell to consider
+ * \param table box of type BOX_TABLE
  *
- * \post \a cell's border array is populated
+ * \post the border array of every cell in \a table is populated
  */
-void table_used_border_for_cell(const css_unit_ctx *unit_len_ctx, struct box *cell);
+void table_used_borders(const css_unit_ctx *unit_len_ctx, struct box *table);
 
 #endif
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 
 #include <nsutils/assert.h>
+#include <nsutils/time.h>
 
 #include <nsgif.h>
 
@@ -56,13 +57,45 @@
 #include "image/image.h"
 #include "image/gif.h"
 
+/**
+ * Frames of animations due within this many ms of each other are
+ * advanced by the same tick of the animation clock.
+ */
+#define GIF_CLOCK_COALESCE_MS 10
+
+/**
+ * An animation which has not been plotted for this many ms, nor since
+ * its frame was last advanced, is assumed to be out of view and is
+ * paused until it is next plotted.
+ */
+#define GIF_PAUSE_MS 1000
+
+/** Largest size of the decoded frames an animation may keep */
+#define GIF_FRAME_CACHE_SIZE (512 * 1024)
+
 typedef struct gif_content {
 	struct content base;
 
 	nsgif_t *gif; /**< GIF animation data */
 	uint32_t current_frame;   /**< current frame to display [0...(max-1)] */
+
+	struct gif_content *anim_next; /**< next animating GIF */
+	bool animating; /**< on the animation clock */
+	bool paused; /**< animation is paused until next plotted */
+	uint64_t frame_due_ms; /**< time the next frame is due */
+	uint64_t advance_ms; /**< time the frame was last advanced */
+	uint64_t plot_ms; /**< time the animation was last plotted */
+
+	nsgif_bitmap_t **frames; /**< decoded frames, if kept */
+	uint32_t frame_count; /**< number of entries in frames */
 } gif_content;
 
+/** GIFs whose animation is driven by the animation clock */
+static gif_content *gif_animating = NULL;
+
+/** The animation clock is advancing animations */
+static bool gif_clock_ticking = false;
+
 static inline nserror gif__nsgif_error_to_ns(nsgif_error gif_res)
 {
 	nserror err;
@@ -162,16 +195,88 @@ static nserror gif_create(const content_handler *handler,
 }
 
 /**
- * Scheduler callback. Performs any necessary animation.
+ * Scheduler callback. Advances all animations which are due.
  *
- * \param p  The content to animate
+ * \param p  Unused
 */
-static void gif_animate_cb(void *p);
+static void gif__clock_cb(void *p);
+
+/**
+ * Schedule the animation clock for the next frame due.
+ */
+static void gif__clock_schedule(void)
+{
+	gif_content *gif;
+	uint64_t due_ms = UINT64_MAX;
+	uint64_t now_ms;
+
+	if (gif_clock_ticking) {
+		/* rescheduled at the end of the tick */
+		return;
+	}
+
+	for (gif = gif_animating; gif != NULL; gif = gif->anim_next) {
+		if (!gif->paused && gif->frame_due_ms < due_ms) {
+			due_ms = gif->frame_due_ms;
+		}
+	}
+
+	if (due_ms == UINT64_MAX) {
+		guit->misc->schedule(-1, gif__clock_cb, NULL);
+		return;
+	}
+
+	nsu_getmonotonic_ms(&now_ms);
+	guit->misc->schedule((due_ms > now_ms) ? (int)(due_ms - now_ms) : 0,
+			gif__clock_cb, NULL);
+}
+
+/**
+ * Put an animation on the animation clock.
+ *
+ * \param gif The gif content to animate.
+ */
+static void gif__clock_add(gif_content *gif)
+{
+	if (!gif->animating) {
+		gif->anim_next = gif_animating;
+		gif_animating = gif;
+		gif->animating = true;
+	}
+
+	gif__clock_schedule();
+}
+
+/**
+ * Take an animation off the animation clock.
+ *
+ * \param gif The gif content to stop animating.
+ */
+static void gif__clock_remove(gif_content *gif)
+{
+	gif_content **link;
+
+	if (!gif->animating) {
+		return;
+	}
+
+	for (link = &gif_animating; *link != gif; link = &(*link)->anim_next) {
+		assert(*link != NULL);
+	}
+	*link = gif->anim_next;
+
+	gif->anim_next = NULL;
+	gif->animating = false;
+	gif->paused = false;
+
+	gif__clock_schedule();
+}
 
 /**
  * Performs any necessary animation.
  *
- * \param p  The content to animate
+ * \param gif The content to animate
+ * \param redraw Whether to request a redraw of the changed area
 */
 static nserror gif__animate(gif_content *gif, bool redraw)
 {
@@ -179,6 +284,7 @@ static nserror gif__animate(gif_content *gif, bool redraw)
 	nsgif_rect_t rect;
 	uint32_t delay;
 	uint32_t f;
+	uint64_t now_ms;
 
 	gif_res = nsgif_frame_prepare(gif->gif, &rect, &delay, &f);
 	if (gif_res != NSGIF_OK) {
@@ -189,7 +295,16 @@ static nserror gif__animate(gif_content *gif, bool redraw)
 
 	/* Continue animating if we should */
 	if (nsoption_bool(animate_images) && delay != NSGIF_INFINITE) {
-		guit->misc->schedule(delay * 10, gif_animate_cb, gif);
+		nsu_getmonotonic_ms(&now_ms);
+		if (!gif->animating) {
+			/* allow time for the animation to be shown */
+			gif->plot_ms = now_ms;
+		}
+		gif->advance_ms = now_ms;
+		gif->frame_due_ms = now_ms + delay * 10;
+		gif__clock_add(gif);
+	} else {
+		gif__clock_remove(gif);
 	}
 
 	if (redraw) {
@@ -207,11 +322,97 @@ static nserror gif__animate(gif_content *gif, bool redraw)
 	return NSERROR_OK;
 }
 
-static void gif_animate_cb(void *p)
+static void gif__clock_cb(void *p)
 {
-	gif_content *gif = p;
+	gif_content *gif, *next;
+	uint64_t now_ms;
 
-	gif__animate(gif, true);
+	nsu_getmonotonic_ms(&now_ms);
+
+	gif_clock_ticking = true;
+
+	for (gif = gif_animating; gif != NULL; gif = next) {
+		next = gif->anim_next;
+
+		if (gif->paused ||
+		    gif->frame_due_ms > now_ms + GIF_CLOCK_COALESCE_MS) {
+			continue;
+		}
+
+		if ((gif->plot_ms < gif->advance_ms) &&
+		    (now_ms - gif->plot_ms > GIF_PAUSE_MS)) {
+			/* Not plotted since the last frame; resumed when
+			 * it next is */
+			gif->paused = true;
+			continue;
+		}
+
+		gif__animate(gif, true);
+	}
+
+	gif_clock_ticking = false;
+
+	gif__clock_schedule();
+}
+
+/**
+ * Destroy the decoded frames kept by an animation.
+ *
+ * \param gif The gif content.
+ */
+static void gif__frames_destroy(gif_content *gif)
+{
+	if (gif->frames != NULL) {
+		for (uint32_t f = 0; f < gif->frame_count; f++) {
+			if (gif->frames[f] != NULL) {
+				guit->bitmap->destroy(gif->frames[f]);
+			}
+		}
+		free(gif->frames);
+		gif->frames = NULL;
+		gif->frame_count = 0;
+	}
+}
+
+/**
+ * Copy a decoded frame.
+ *
+ * \param frame The frame bitmap to copy.
+ * \return The copy or NULL on error.
+ */
+static nsgif_bitmap_t *gif__frame_copy(nsgif_bitmap_t *frame)
+{
+	nsgif_bitmap_t *copy;
+	const uint8_t *src;
+	uint8_t *dst;
+	size_t src_stride, dst_stride;
+	int width, height;
+
+	width = guit->bitmap->get_width(frame);
+	height = guit->bitmap->get_height(frame);
+
+	copy = guit->bitmap->create(width, height, BITMAP_NONE);
+	if (copy == NULL) {
+		return NULL;
+	}
+
+	src = guit->bitmap->get_buffer(frame);
+	dst = guit->bitmap->get_buffer(copy);
+	if (src == NULL || dst == NULL) {
+		guit->bitmap->destroy(copy);
+		return NULL;
+	}
+	src_stride = guit->bitmap->get_rowstride(frame);
+	dst_stride = guit->bitmap->get_rowstride(copy);
+
+	for (int y = 0; y < height; y++) {
+		memcpy(dst + y * dst_stride, src + y * src_stride, width * 4);
+	}
+
+	guit->bitmap->set_opaque(copy, guit->bitmap->get_opaque(frame));
+	guit->bitmap->modified(copy);
+
+	return copy;
 }
 
 static bool gif_convert(struct content *c)
@@ -255,6 +456,20 @@ static bool gif_convert(struct content *c)
 	c->height = gif_info->height;
 	c->size += (gif_info->width * gif_info->height * 4) + 16 + 44;
 
+	/* Keep the decoded frames of small animations, so that they are
+	 * not decoded again each time the animation loops */
+	if (gif_info->frame_count > 1 && nsoption_bool(animate_images) &&
+	    (uint64_t)gif_info->width * gif_info->height * 4 *
+	    gif_info->frame_count <= GIF_FRAME_CACHE_SIZE) {
+		gif->frames = calloc(gif_info->frame_count,
+				sizeof(nsgif_bitmap_t *));
+		if (gif->frames != NULL) {
+			gif->frame_count = gif_info->frame_count;
+			c->size += gif_info->width * gif_info->height * 4 *
+					gif_info->frame_count;
+		}
+	}
+
 	/* set title text */
 	title = messages_get_buff("GIFTitle",
 			nsurl_access_leaf(llcache_handle_get_url(c->llcache)),
@@ -289,11 +504,24 @@ static nsgif_error gif_get_frame(gif_content *gif,
 		nsgif_bitmap_t **bitmap)
 {
 	uint32_t current_frame = gif->current_frame;
+	nsgif_error res;
+
 	if (!nsoption_bool(animate_images)) {
 		current_frame = 0;
 	}
 
-	return nsgif_frame_decode(gif->gif, current_frame, bitmap);
+	if (current_frame < gif->frame_count &&
+	    gif->frames[current_frame] != NULL) {
+		*bitmap = gif->frames[current_frame];
+		return NSGIF_OK;
+	}
+
+	res = nsgif_frame_decode(gif->gif, current_frame, bitmap);
+	if (res == NSGIF_OK && current_frame < gif->frame_count) {
+		gif->frames[current_frame] = gif__frame_copy(*bitmap);
+	}
+
+	return res;
 }
 
 static bool gif_redraw(struct content *c, struct content_redraw_data *data,
@@ -302,6 +530,14 @@ static bool gif_redraw(struct content *c, struct content_redraw_data *data,
 	gif_content *gif = (gif_content *) c;
 	nsgif_bitmap_t *bitmap;
 
+	nsu_getmonotonic_ms(&gif->plot_ms);
+	if (gif->paused) {
+		/* back in view, so continue the animation */
+		gif->paused = false;
+		gif->frame_due_ms = gif->plot_ms;
+		gif__clock_schedule();
+	}
+
 	if (gif_get_frame(gif, &bitmap) != NSGIF_OK) {
 		return false;
 	}
@@ -314,7 +550,8 @@ static void gif_destroy(struct content *c)
 	gif_content *gif = (gif_content *) c;
 
 	/* Free all the associated memory buffers */
-	guit->misc->schedule(-1, gif_animate_cb, c);
+	gif__clock_remove(gif);
+	gif__frames_destroy(gif);
 	nsgif_destroy(gif->gif);
 }
 
@@ -373,7 +610,7 @@ static void gif_remove_user(struct content *c)
 {
 	if (content_count_users(c) == 1) {
 		/* Last user is about to be removed from this content, so stop the animation. */
-		guit->misc->schedule(-1, gif_animate_cb, c);
+		gif__clock_remove((gif_content *) c);
 	}
 }
 
@@ -26,19 +26,32 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <nsutils/time.h>
 
 #include "netsurf/inttypes.h"
 #include "utils/utils.h"
 #include "utils/log.h"
+#include "utils/hashmap.h"
 #include "netsurf/misc.h"
 #include "netsurf/bitmap.h"
+#include "netsurf/content.h"
+#include "netsurf/plotters.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "desktop/gui_internal.h"
+#include "desktop/bitmap.h"
 
 #include "image/image_cache.h"
 #include "image/image.h"
 
+/**
+ * Time, in ms, spent converting queued images before yielding
+ *
+ * At least one image is converted each time the queue is run.
+ */
+#define IMAGE_CACHE_CONVERT_SLICE_MS 10
+
 /**
  * Age of an entry within the cache
  *
@@ -51,8 +64,8 @@ typedef unsigned int cache_age;
  * Image cache entry
  */
 struct image_cache_entry_s {
-	struct image_cache_entry_s *next; /**< next cache entry in list */
-	struct image_cache_entry_s *prev; /**< previous cache entry in list */
+	struct image_cache_entry_s *next; /**< next less recently used entry */
+	struct image_cache_entry_s *prev; /**< next more recently used entry */
 
 	/** content is used as a key */
 	struct content *content;
@@ -60,11 +73,31 @@ struct image_cache_entry_s {
 	struct bitmap *bitmap;
 	/** routine to convert content into bitmap */
 	image_cache_convert_fn *convert;
+	/** routine to convert content into a reduced size bitmap */
+	image_cache_convert_scaled_fn *convert_scaled;
+
+	/** factor the bitmap is reduced from the content size by */
+	unsigned int scale;
+	/** reduction factor plots require, zero if no plot is known */
+	unsigned int want_scale;
+
+	/** source data of the content, if its entry is in a source group */
+	const uint8_t *source;
+	/** next entry with the same source */
+	struct image_cache_entry_s *source_next;
+
+	/** next entry waiting for conversion, if queued */
+	struct image_cache_entry_s *convert_next;
+	/** entry is waiting for conversion */
+	bool convert_queued;
+	/** content must be redrawn when the conversion completes */
+	bool redraw_pending;
 
 	/* Statistics for replacement algorithm */
 
 	unsigned int redraw_count; /**< number of times object has been drawn */
 	cache_age redraw_age; /**< Age of last redraw */
+	cache_age use_age; /**< Age of last addition or redraw */
 	size_t bitmap_size; /**< size if storage occupied by bitmap */
 	cache_age bitmap_age; /**< Age of last conversion to a bitmap by cache*/
 
@@ -86,8 +119,24 @@ struct image_cache_s {
 	/** The "age" of the current operation */
 	cache_age current_age;
 
-	/* The objects the cache holds */
+	/** The objects the cache holds, most recently used first */
 	struct image_cache_entry_s *entries;
+	/** The least recently used object */
+	struct image_cache_entry_s *entries_tail;
+
+	/** The objects the cache holds, indexed by content */
+	hashmap_t *index;
+
+	/** Groups of entries whose contents share source data */
+	hashmap_t *sources;
+
+	/** Entry most recently found by its position in the entries list */
+	struct image_cache_entry_s *findn_entry;
+	/** Position of findn_entry */
+	int findn_index;
+
+	/** Entries waiting for conversion, in order of conversion */
+	struct image_cache_entry_s *convert_queue;
 
 
 	/* Statistics for management algorithm */
@@ -125,6 +174,9 @@ struct image_cache_s {
 	/** Bitmap was available but never required - wasted conversions */
 	int specultive_miss_count;
 
+	/** Bitmap was taken from another content with the same source */
+	int shared_count;
+
 	/** Total number of additional (after the first) conversions */
 	int total_extra_conversions;
 	/** counts total number of images with more than one conversion */
@@ -140,6 +192,196 @@ struct image_cache_s {
 static struct image_cache_s *image_cache = NULL;
 
 
+/* Index hashmap parameters
+ *
+ * The index has content pointer keys, which it does not own, and cache
+ * entry values
+ */
+
+static void *image_cache__index_key_clone(void *key)
+{
+	return key;
+}
+
+static void image_cache__index_key_destroy(void *key)
+{
+}
+
+static uint32_t image_cache__index_key_hash(void *key)
+{
+	/* the hashmap mixes the hash, allocations are aligned */
+	return (uint32_t)((uintptr_t)key >> 3);
+}
+
+static bool image_cache__index_key_eq(void *key1, void *key2)
+{
+	return key1 == key2;
+}
+
+static void *image_cache__index_value_alloc(void *key)
+{
+	struct image_cache_entry_s *centry;
+
+	centry = calloc(1, sizeof(struct image_cache_entry_s));
+	if (centry != NULL) {
+		centry->content = key;
+		centry->scale = 1;
+	}
+	return centry;
+}
+
+static hashmap_parameters_t image_cache__index_parameters = {
+	.key_clone = image_cache__index_key_clone,
+	.key_destroy = image_cache__index_key_destroy,
+	.key_hash = image_cache__index_key_hash,
+	.key_eq = image_cache__index_key_eq,
+	.value_alloc = image_cache__index_value_alloc,
+	.value_destroy = free,
+};
+
+
+/**
+ * Group of cache entries whose contents share source data
+ *
+ * Contents cloned from one another, for example when the same image is
+ * shown in several windows, share their low level cache object and
+ * hence its source data. Their bitmaps are identical so may be shared.
+ */
+struct image_cache_source_s {
+	/** entries with this source */
+	struct image_cache_entry_s *entries;
+};
+
+/* Sources hashmap parameters
+ *
+ * The sources have source data pointer keys, which are not owned, and
+ * source group values
+ */
+
+static void *image_cache__source_value_alloc(void *key)
+{
+	return calloc(1, sizeof(struct image_cache_source_s));
+}
+
+static hashmap_parameters_t image_cache__source_parameters = {
+	.key_clone = image_cache__index_key_clone,
+	.key_destroy = image_cache__index_key_destroy,
+	.key_hash = image_cache__index_key_hash,
+	.key_eq = image_cache__index_key_eq,
+	.value_alloc = image_cache__source_value_alloc,
+	.value_destroy = free,
+};
+
+
+/**
+ * Add an entry to the group for its content's source data
+ *
+ * \param centry The image cache entry, whose content's data is complete.
+ */
+static void image_cache__source_add(struct image_cache_entry_s *centry)
+{
+	struct image_cache_source_s *group;
+	const uint8_t *source;
+	size_t size;
+
+	if (centry->source != NULL) {
+		return;
+	}
+
+	source = content__get_source_data(centry->content, &size);
+	if (source == NULL) {
+		return;
+	}
+
+	group = hashmap_lookup(image_cache->sources, (void *)source);
+	if (group == NULL) {
+		group = hashmap_insert(image_cache->sources, (void *)source);
+		if (group == NULL) {
+			/* the entry simply does not share bitmaps */
+			return;
+		}
+	}
+
+	centry->source = source;
+	centry->source_next = group->entries;
+	group->entries = centry;
+}
+
+/**
+ * Remove an entry from the group for its content's source data
+ *
+ * \param centry The image cache entry.
+ */
+static void image_cache__source_remove(struct image_cache_entry_s *centry)
+{
+	struct image_cache_source_s *group;
+	struct image_cache_entry_s **link;
+
+	if (centry->source == NULL) {
+		return;
+	}
+
+	group = hashmap_lookup(image_cache->sources, (void *)centry->source);
+	assert(group != NULL);
+
+	for (link = &group->entries;
+	     *link != centry;
+	     link = &(*link)->source_next) {
+		assert(*link != NULL);
+	}
+	*link = centry->source_next;
+
+	if (group->entries == NULL) {
+		hashmap_remove(image_cache->sources, (void *)centry->source);
+	}
+
+	centry->source = NULL;
+	centry->source_next = NULL;
+}
+
+/**
+ * Find another entry with the same source data holding a bitmap
+ *
+ * \param centry The image cache entry.
+ * \param scale The largest reduction of the bitmap acceptable, or zero
+ *              for another entry holding the same bitmap as centry.
+ * \return The entry with the smallest suitable bitmap or NULL.
+ */
+static struct image_cache_entry_s *
+image_cache__source_find(struct image_cache_entry_s *centry,
+			 unsigned int scale)
+{
+	struct image_cache_source_s *group;
+	struct image_cache_entry_s *twin;
+	struct image_cache_entry_s *found = NULL;
+
+	if (centry->source == NULL) {
+		return NULL;
+	}
+
+	group = hashmap_lookup(image_cache->sources, (void *)centry->source);
+	assert(group != NULL);
+
+	for (twin = group->entries; twin != NULL; twin = twin->source_next) {
+		if ((twin == centry) || (twin->bitmap == NULL)) {
+			continue;
+		}
+
+		if (scale == 0) {
+			if (twin->bitmap == centry->bitmap) {
+				return twin;
+			}
+		} else if ((twin->convert == centry->convert) &&
+			   (twin->scale <= scale) &&
+			   ((found == NULL) || (twin->scale > found->scale))) {
+			found = twin;
+		}
+	}
+
+	return found;
+}
+
+
 /**
  * Find a cache entry by index.
  *
@@ -149,12 +391,26 @@ static struct image_cache_s *image_cache = NULL;
 static struct image_cache_entry_s *image_cache__findn(int entryn)
 {
 	struct image_cache_entry_s *found;
+	int index = 0;
 
 	found = image_cache->entries;
-	while ((found != NULL) && (entryn > 0)) {
-		entryn--;
+
+	/* entries are usually enumerated in order, so continue from
+	 * the previous position if possible */
+	if (image_cache->findn_entry != NULL &&
+	    image_cache->findn_index <= entryn) {
+		found = image_cache->findn_entry;
+		index = image_cache->findn_index;
+	}
+
+	while ((found != NULL) && (index < entryn)) {
+		index++;
 		found = found->next;
 	}
+
+	image_cache->findn_entry = found;
+	image_cache->findn_index = index;
+
 	return found;
 }
 
@@ -167,13 +423,7 @@ static struct image_cache_entry_s *image_cache__findn(int entryn)
  */
 static struct image_cache_entry_s *image_cache__find(const struct content *c)
 {
-	struct image_cache_entry_s *found;
-
-	found = image_cache->entries;
-	while ((found != NULL) && (found->content != c)) {
-		found = found->next;
-	}
-	return found;
+	return hashmap_lookup(image_cache->index, (void *)c);
 }
 
 /**
@@ -216,35 +466,86 @@ static void image_cache_stats_bitmap_add(struct image_cache_entry_s *centry)
 	}
 }
 
+/**
+ * Link an entry at the most recently used end of the entries list
+ *
+ * \param centry The image cache entry to link.
+ */
 static void image_cache__link(struct image_cache_entry_s *centry)
 {
+	centry->use_age = image_cache->current_age;
 	centry->next = image_cache->entries;
 	centry->prev = NULL;
 	if (centry->next != NULL) {
 		centry->next->prev = centry;
+	} else {
+		image_cache->entries_tail = centry;
 	}
 	image_cache->entries = centry;
+	image_cache->findn_entry = NULL;
 }
 
+/**
+ * Unlink an entry from the entries list
+ *
+ * \param centry The image cache entry to unlink.
+ */
 static void image_cache__unlink(struct image_cache_entry_s *centry)
 {
-	/* unlink entry */
 	if (centry->prev == NULL) {
-		/* first in list */
-		if (centry->next != NULL) {
-			centry->next->prev = centry->prev;
-			image_cache->entries = centry->next;
-		} else {
-			/* empty list */
-			image_cache->entries = NULL;
-		}
+		image_cache->entries = centry->next;
 	} else {
 		centry->prev->next = centry->next;
+	}
 
-		if (centry->next != NULL) {
-			centry->next->prev = centry->prev;
-		}
+	if (centry->next == NULL) {
+		image_cache->entries_tail = centry->prev;
+	} else {
+		centry->next->prev = centry->prev;
+	}
+
+	centry->next = NULL;
+	centry->prev = NULL;
+	image_cache->findn_entry = NULL;
+}
+
+/**
+ * Mark an entry as the most recently used
+ *
+ * \param centry The image cache entry which has been used.
+ */
+static void image_cache__touch(struct image_cache_entry_s *centry)
+{
+	if (image_cache->entries != centry) {
+		image_cache__unlink(centry);
+		image_cache__link(centry);
+	} else {
+		centry->use_age = image_cache->current_age;
+	}
+}
+
+/**
+ * Remove an entry from the conversion queue
+ *
+ * \param centry The image cache entry to remove.
+ */
+static void image_cache__dequeue(struct image_cache_entry_s *centry)
+{
+	struct image_cache_entry_s **link;
+
+	if (!centry->convert_queued) {
+		return;
+	}
+
+	for (link = &image_cache->convert_queue;
+	     *link != centry;
+	     link = &(*link)->convert_next) {
+		assert(*link != NULL);
 	}
+	*link = centry->convert_next;
+
+	centry->convert_next = NULL;
+	centry->convert_queued = false;
 }
 
 /**
@@ -263,15 +564,323 @@ static void image_cache__free_bitmap(struct image_cache_entry_s *centry)
 		      image_cache->current_age - centry->bitmap_age,
 		      centry->redraw_count);
 #endif
-		guit->bitmap->destroy(centry->bitmap);
+		if (image_cache__source_find(centry, 0) == NULL) {
+			guit->bitmap->destroy(centry->bitmap);
+			image_cache->total_bitmap_size -= centry->bitmap_size;
+			image_cache->bitmap_count--;
+		}
 		centry->bitmap = NULL;
-		image_cache->total_bitmap_size -= centry->bitmap_size;
-		image_cache->bitmap_count--;
 		if (centry->redraw_count == 0) {
 			image_cache->specultive_miss_count++;
 		}
 	}
 
+	/* plots made while the bitmap was held are no longer relevant */
+	centry->want_scale = 0;
+
+}
+
+/**
+ * Find the factor an image may be reduced by for a plot
+ *
+ * \param c The image content.
+ * \param data The redraw data of the plot.
+ * \return The largest power of two reduction which is no smaller than
+ *         the plot.
+ */
+static unsigned int
+image_cache__plot_scale(const struct content *c,
+			const struct content_redraw_data *data)
+{
+	unsigned int scale = 1;
+
+	if ((data->width <= 0) || (data->height <= 0)) {
+		return scale;
+	}
+
+	while ((scale < IMAGE_CACHE_SCALE_MAX) &&
+	       (((c->width + scale * 2 - 1) / (scale * 2)) >=
+		(unsigned int)data->width) &&
+	       (((c->height + scale * 2 - 1) / (scale * 2)) >=
+		(unsigned int)data->height)) {
+		scale *= 2;
+	}
+
+	return scale;
+}
+
+/**
+ * Reduce a bitmap in size by averaging blocks of pixels
+ *
+ * \param src The bitmap to reduce.
+ * \param scale The factor to reduce the bitmap by.
+ * \return The reduced bitmap or NULL on error.
+ */
+static struct bitmap *
+image_cache__downsample(struct bitmap *src, unsigned int scale)
+{
+	struct bitmap *dst;
+	const uint8_t *src_pixels;
+	uint8_t *dst_pixels;
+	size_t src_stride, dst_stride;
+	int src_width, src_height;
+	int width, height;
+	bool opaque, weight;
+	int x, y, sx, sy;
+
+	src_width = guit->bitmap->get_width(src);
+	src_height = guit->bitmap->get_height(src);
+	width = (src_width + scale - 1) / scale;
+	height = (src_height + scale - 1) / scale;
+	opaque = guit->bitmap->get_opaque(src);
+
+	dst = guit->bitmap->create(width, height,
+			opaque ? BITMAP_OPAQUE : BITMAP_NONE);
+	if (dst == NULL) {
+		return NULL;
+	}
+
+	src_pixels = guit->bitmap->get_buffer(src);
+	dst_pixels = guit->bitmap->get_buffer(dst);
+	if ((src_pixels == NULL) || (dst_pixels == NULL)) {
+		guit->bitmap->destroy(dst);
+		return NULL;
+	}
+	src_stride = guit->bitmap->get_rowstride(src);
+	dst_stride = guit->bitmap->get_rowstride(dst);
+
+	/* colours which are not premultiplied must be weighted by alpha
+	 * or transparent pixels bleed into their neighbours */
+	weight = !opaque && !bitmap_fmt.pma;
+
+	for (y = 0; y < height; y++) {
+		int y0 = y * scale;
+		int y1 = min(y0 + (int)scale, src_height);
+		uint8_t *dst_row = dst_pixels + y * dst_stride;
+
+		for (x = 0; x < width; x++) {
+			int x0 = x * scale;
+			int x1 = min(x0 + (int)scale, src_width);
+			uint32_t sum[4] = { 0, 0, 0, 0 };
+			uint32_t count = (x1 - x0) * (y1 - y0);
+			uint8_t *out = dst_row + x * 4;
+			int c;
+
+			for (sy = y0; sy < y1; sy++) {
+				const uint8_t *in = src_pixels +
+					sy * src_stride + x0 * 4;
+
+				for (sx = x0; sx < x1; sx++, in += 4) {
+					for (c = 0; c < 4; c++) {
+						if (weight &&
+						    c != bitmap_layout.a) {
+							sum[c] += in[c] *
+								in[bitmap_layout.a];
+						} else {
+							sum[c] += in[c];
+						}
+					}
+				}
+			}
+
+			if (weight) {
+				uint32_t alpha = sum[bitmap_layout.a];
+
+				for (c = 0; c < 4; c++) {
+					if (c == bitmap_layout.a) {
+						out[c] = alpha / count;
+					} else if (alpha == 0) {
+						out[c] = 0;
+					} else {
+						out[c] = sum[c] / alpha;
+					}
+				}
+			} else {
+				for (c = 0; c < 4; c++) {
+					out[c] = sum[c] / count;
+				}
+			}
+		}
+	}
+
+	guit->bitmap->modified(dst);
+
+	return dst;
+}
+
+/**
+ * Check if a cache entry must be converted
+ *
+ * \param centry The image cache entry to check.
+ * \return true if the entry has no bitmap or its bitmap is too small.
+ */
+static bool image_cache__convert_needed(struct image_cache_entry_s *centry)
+{
+	return (centry->bitmap == NULL) ||
+		(centry->scale > max(centry->want_scale, 1u));
+}
+
+/**
+ * Convert a cache entry's content into a bitmap
+ *
+ * The bitmap is reduced in size as far as the entry's plots allow. Any
+ * existing bitmap is replaced.
+ *
+ * \param centry The image cache entry to convert.
+ * \return true if the entry has a bitmap, false if conversion failed.
+ */
+static bool image_cache__convert(struct image_cache_entry_s *centry)
+{
+	struct image_cache_entry_s *twin;
+	struct bitmap *bitmap = NULL;
+	unsigned int scale = max(centry->want_scale, 1u);
+
+	/* share the bitmap of a content with the same source */
+	twin = image_cache__source_find(centry, scale);
+	if (twin != NULL) {
+		image_cache__free_bitmap(centry);
+
+		centry->bitmap = twin->bitmap;
+		centry->scale = twin->scale;
+		centry->want_scale = scale;
+		centry->bitmap_size = twin->bitmap_size;
+		centry->bitmap_age = image_cache->current_age;
+
+		image_cache->shared_count++;
+		return true;
+	}
+
+	if (centry->convert_scaled != NULL) {
+		bitmap = centry->convert_scaled(centry->content, scale);
+	} else if (centry->convert != NULL) {
+		bitmap = centry->convert(centry->content);
+		if ((bitmap != NULL) && (scale > 1)) {
+			struct bitmap *reduced;
+
+			reduced = image_cache__downsample(bitmap, scale);
+			if (reduced != NULL) {
+				guit->bitmap->destroy(bitmap);
+				bitmap = reduced;
+			} else {
+				scale = 1;
+			}
+		}
+	}
+
+	if (bitmap == NULL) {
+		image_cache->fail_count++;
+		image_cache->fail_size += centry->bitmap_size;
+		return (centry->bitmap != NULL);
+	}
+
+	image_cache__free_bitmap(centry);
+
+	centry->bitmap = bitmap;
+	centry->scale = scale;
+	centry->want_scale = scale;
+	centry->bitmap_size = guit->bitmap->get_width(bitmap) *
+		guit->bitmap->get_height(bitmap) * 4llu;
+
+	image_cache_stats_bitmap_add(centry);
+	return true;
+}
+
+/**
+ * Conversion queue scheduled callback.
+ *
+ * Converts queued entries until the time slice is used, redrawing the
+ * contents of those which were waiting to be drawn.
+ *
+ * \param p The image cache context.
+ */
+static void image_cache__convert_queued(void *p)
+{
+	struct image_cache_s *icache = p;
+	struct image_cache_entry_s *centry;
+	uint64_t start_ms, now_ms;
+
+	nsu_getmonotonic_ms(&start_ms);
+
+	while ((centry = icache->convert_queue) != NULL) {
+		bool converted = (centry->bitmap != NULL);
+
+		image_cache__dequeue(centry);
+
+		if (image_cache__convert_needed(centry) &&
+		    image_cache__convert(centry)) {
+			if (centry->redraw_pending && !converted) {
+				image_cache->miss_count++;
+				image_cache->miss_size += centry->bitmap_size;
+			}
+		}
+
+		if (centry->redraw_pending && centry->bitmap != NULL) {
+			union content_msg_data data;
+
+			data.redraw.x = 0;
+			data.redraw.y = 0;
+			data.redraw.width = centry->content->width;
+			data.redraw.height = centry->content->height;
+
+			content_broadcast(centry->content,
+					CONTENT_MSG_REDRAW, &data);
+		}
+		centry->redraw_pending = false;
+
+		nsu_getmonotonic_ms(&now_ms);
+		if (now_ms - start_ms >= IMAGE_CACHE_CONVERT_SLICE_MS) {
+			break;
+		}
+	}
+
+	if (icache->convert_queue != NULL) {
+		guit->misc->schedule(0, image_cache__convert_queued, icache);
+	}
+}
+
+/**
+ * Queue an entry for conversion in the background
+ *
+ * Entries which are to be drawn are converted before those which are
+ * converted speculatively.
+ *
+ * \param centry The image cache entry to convert.
+ * \param redraw Whether the entry's content is waiting to be drawn.
+ */
+static void image_cache__queue(struct image_cache_entry_s *centry,
+			       bool redraw)
+{
+	struct image_cache_entry_s **link;
+
+	if (centry->convert_queued) {
+		if (!redraw || centry->redraw_pending) {
+			return;
+		}
+		/* promote speculative conversion */
+		image_cache__dequeue(centry);
+	}
+
+	if (image_cache->convert_queue == NULL) {
+		guit->misc->schedule(0, image_cache__convert_queued,
+				image_cache);
+	}
+
+	link = &image_cache->convert_queue;
+	if (redraw) {
+		/* after any other entries being drawn */
+		while (*link != NULL && (*link)->redraw_pending) {
+			link = &(*link)->convert_next;
+		}
+	} else {
+		while (*link != NULL) {
+			link = &(*link)->convert_next;
+		}
+	}
+
+	centry->convert_next = *link;
+	*link = centry;
+	centry->convert_queued = true;
+	centry->redraw_pending = redraw;
 }
 
 /**
@@ -291,31 +900,43 @@ static void image_cache__free_entry(struct image_cache_entry_s *centry)
 
 	image_cache__free_bitmap(centry);
 
+	image_cache__dequeue(centry);
+
+	image_cache__source_remove(centry);
+
 	image_cache__unlink(centry);
 
-	free(centry);
+	/* frees the entry */
+	hashmap_remove(image_cache->index, centry->content);
 }
 
 /**
  * Image cache cleaner
  *
+ * Frees the bitmaps of the least recently used entries until the cache
+ * is within its limit, only considering entries which have not been
+ * used for a whole clean period. Bitmaps which cannot be converted
+ * again, such as those of images still being fetched, are kept.
+ *
  * \param icache The image cache context.
  */
 static void image_cache__clean(struct image_cache_s *icache)
 {
-	struct image_cache_entry_s *centry = icache->entries;
+	struct image_cache_entry_s *centry = icache->entries_tail;
 
-	while (centry != NULL) {
-		if ((icache->current_age - centry->redraw_age) >
+	while ((centry != NULL) &&
+	       (icache->total_bitmap_size >
+		(icache->params.limit - icache->params.hysteresis))) {
+		if ((icache->current_age - centry->use_age) <=
 		    icache->params.bg_clean_time) {
-			/* only consider older entries, avoids active entries */
-			if ((icache->total_bitmap_size >
-			     (icache->params.limit - icache->params.hysteresis)) &&
-			    (rand() > (RAND_MAX / 2))) {
-				image_cache__free_bitmap(centry);
-			}
+			/* this and all later entries are active */
+			break;
+		}
+		if ((centry->convert != NULL) ||
+		    (centry->convert_scaled != NULL)) {
+			image_cache__free_bitmap(centry);
 		}
-		centry=centry->next;
+		centry = centry->prev;
 	}
 }
 
@@ -352,18 +973,12 @@ struct bitmap *image_cache_get_bitmap(const struct content *c)
 		return NULL;
 	}
 
-	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
-		}
-
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
+	if ((centry->bitmap == NULL) || (centry->scale > 1)) {
+		/* callers of this require the full size image */
+		centry->want_scale = 1;
+		if (image_cache__convert(centry) && (centry->scale == 1)) {
 			image_cache->miss_count++;
 			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
 		}
 	} else {
 		image_cache->hit_count++;
@@ -398,6 +1013,15 @@ bool image_cache_speculate(struct content *c)
 	return decision;
 }
 
+/* exported interface documented in image_cache.h */
+bool image_cache_progressive(const struct content *c)
+{
+	size_t size = c->width * c->height * 4llu;
+
+	return (image_cache->total_bitmap_size + size <=
+		image_cache->params.limit);
+}
+
 /* exported interface documented in image_cache.h */
 struct bitmap *image_cache_find_bitmap(struct content *c)
 {
@@ -422,6 +1046,21 @@ image_cache_init(const struct image_cache_parameters *image_cache_parameters)
 
 	image_cache->params = *image_cache_parameters;
 
+	image_cache->index = hashmap_create(&image_cache__index_parameters);
+	if (image_cache->index == NULL) {
+		free(image_cache);
+		image_cache = NULL;
+		return NSERROR_NOMEM;
+	}
+
+	image_cache->sources = hashmap_create(&image_cache__source_parameters);
+	if (image_cache->sources == NULL) {
+		hashmap_destroy(image_cache->index);
+		free(image_cache);
+		image_cache = NULL;
+		return NSERROR_NOMEM;
+	}
+
 	guit->misc->schedule(image_cache->params.bg_clean_time,
 				image_cache__background_update,
 				image_cache);
@@ -441,6 +1080,7 @@ nserror image_cache_fini(void)
 	uint64_t op_size;
 
 	guit->misc->schedule(-1, image_cache__background_update, image_cache);
+	guit->misc->schedule(-1, image_cache__convert_queued, image_cache);
 
 	NSLOG(netsurf, INFO, "Size at finish %"PRIsizet" (in %d)",
 	      image_cache->total_bitmap_size, image_cache->bitmap_count);
@@ -448,6 +1088,8 @@ nserror image_cache_fini(void)
 	while (image_cache->entries != NULL) {
 		image_cache__free_entry(image_cache->entries);
 	}
+	hashmap_destroy(image_cache->index);
+	hashmap_destroy(image_cache->sources);
 
 	op_count = image_cache->hit_count +
 		image_cache->miss_count +
@@ -501,6 +1143,10 @@ nserror image_cache_fini(void)
 	      image_cache->peak_conversions_size,
 	      image_cache->peak_conversions);
 
+	NSLOG(netsurf, INFO,
+	      "Total bitmaps shared between contents with the same source: %d",
+	      image_cache->shared_count);
+
 	free(image_cache);
 
 	return NSERROR_OK;
@@ -521,12 +1167,11 @@ nserror image_cache_add(struct content *content,
 	centry = image_cache__find(content);
 	if (centry == NULL) {
 		/* new cache entry, content not previously added */
-		centry = calloc(1, sizeof(struct image_cache_entry_s));
+		centry = hashmap_insert(image_cache->index, content);
 		if (centry == NULL) {
 			return NSERROR_NOMEM;
 		}
 		image_cache__link(centry);
-		centry->content = content;
 
 		centry->bitmap_size = content->width * content->height * 4llu;
 	}
@@ -536,25 +1181,27 @@ nserror image_cache_add(struct content *content,
 
 	centry->convert = convert;
 
+	/* once the source is complete the bitmap may be shared */
+	if (convert != NULL) {
+		image_cache__source_add(centry);
+	}
+
 	/* set bitmap entry if one is passed, free extant one if present */
-	if (bitmap != NULL) {
-		if (centry->bitmap != NULL) {
-			guit->bitmap->destroy(centry->bitmap);
-		} else {
-			image_cache_stats_bitmap_add(centry);
-		}
+	if ((bitmap != NULL) && (bitmap == centry->bitmap)) {
+		/* already holding this bitmap, e.g. completing a
+		 * progressively decoded image */
+	} else if (bitmap != NULL) {
+		image_cache__free_bitmap(centry);
 		centry->bitmap = bitmap;
+		centry->scale = 1;
+		centry->bitmap_size = content->width * content->height * 4llu;
+		image_cache_stats_bitmap_add(centry);
 	} else {
-		/* no bitmap, check to see if we should speculatively convert */
+		/* no bitmap, check to see if we should speculatively
+		 * convert, which is done in the background */
 		if ((centry->convert != NULL) &&
 		    (image_cache_speculate(content) == true)) {
-			centry->bitmap = centry->convert(centry->content);
-
-			if (centry->bitmap != NULL) {
-				image_cache_stats_bitmap_add(centry);
-			} else {
-				image_cache->fail_count++;
-			}
+			image_cache__queue(centry, false);
 		}
 	}
 
@@ -581,6 +1228,22 @@ nserror image_cache_remove(struct content *content)
 	return NSERROR_OK;
 }
 
+/* exported interface documented in image_cache.h */
+nserror image_cache_set_convert_scaled(struct content *content,
+		image_cache_convert_scaled_fn *convert_scaled)
+{
+	struct image_cache_entry_s *centry;
+
+	centry = image_cache__find(content);
+	if (centry == NULL) {
+		return NSERROR_NOT_FOUND;
+	}
+
+	centry->convert_scaled = convert_scaled;
+
+	return NSERROR_OK;
+}
+
 /* exported interface documented in image_cache.h */
 int image_cache_snsummaryf(char *string, size_t size, const char *fmt)
 {
@@ -801,6 +1464,7 @@ bool image_cache_redraw(struct content *c,
 			const struct redraw_context *ctx)
 {
 	struct image_cache_entry_s *centry;
+	unsigned int scale = 1;
 
 	/* get the cache entry */
 	centry = image_cache__find(c);
@@ -810,20 +1474,45 @@ bool image_cache_redraw(struct content *c,
 		return false;
 	}
 
+	/* Interactive plots much smaller than the image only need a
+	 * reduced bitmap. Other plots, such as printing, may be at a
+	 * higher resolution than their dimensions suggest. */
+	if (ctx->interactive &&
+	    ((centry->convert != NULL) || (centry->convert_scaled != NULL))) {
+		scale = image_cache__plot_scale(c, data);
+	}
+	if ((centry->want_scale == 0) || (scale < centry->want_scale)) {
+		centry->want_scale = scale;
+	}
+
 	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
+		if (ctx->interactive &&
+		    ((centry->convert != NULL) ||
+		     (centry->convert_scaled != NULL))) {
+			/* Draw nothing until the image has been converted
+			 * in the background, so that a page with many images
+			 * is not held up for all of them */
+			centry->redraw_age = image_cache->current_age;
+			image_cache__touch(centry);
+			image_cache__queue(centry, true);
+			return true;
 		}
 
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
-			image_cache->miss_count++;
-			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
+		if (!image_cache__convert(centry)) {
 			return false;
 		}
+		image_cache->miss_count++;
+		image_cache->miss_size += centry->bitmap_size;
+	} else if (image_cache__convert_needed(centry)) {
+		if (ctx->interactive) {
+			/* plot the reduced bitmap until a larger one has
+			 * been converted in the background */
+			image_cache__queue(centry, true);
+		} else {
+			image_cache__convert(centry);
+		}
+		image_cache->hit_count++;
+		image_cache->hit_size += centry->bitmap_size;
 	} else {
 		image_cache->hit_count++;
 		image_cache->hit_size += centry->bitmap_size;
@@ -833,6 +1522,7 @@ bool image_cache_redraw(struct content *c,
 	/* update statistics */
 	centry->redraw_count++;
 	centry->redraw_age = image_cache->current_age;
+	image_cache__touch(centry);
 
 	return image_bitmap_plot(centry->bitmap, data, clip, ctx);
 }
@@ -861,8 +1551,16 @@ void *image_cache_get_internal(const struct content *c, void *context)
 /* exported interface documented in image_cache.h */
 bool image_cache_is_opaque(struct content *c)
 {
+	struct image_cache_entry_s *centry;
 	struct bitmap *bmp;
-	bmp = image_cache_get_bitmap(c);
+
+	/* a reduced bitmap has the same opacity as the full image */
+	centry = image_cache__find(c);
+	if ((centry != NULL) && (centry->bitmap != NULL)) {
+		bmp = centry->bitmap;
+	} else {
+		bmp = image_cache_get_bitmap(c);
+	}
 	if (bmp != NULL) {
 		return guit->bitmap->get_opaque(bmp);
 	}
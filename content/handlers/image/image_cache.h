@@ -46,6 +46,17 @@ struct redraw_context;
 
 typedef struct bitmap * (image_cache_convert_fn) (struct content *content);
 
+/** Largest factor the cache reduces images by when plotted small */
+#define IMAGE_CACHE_SCALE_MAX 8
+
+/**
+ * Convert a content into a bitmap reduced in size.
+ *
+ * The bitmap is the content's dimensions divided by scale, rounded
+ * up. The scale is a power of two no greater than IMAGE_CACHE_SCALE_MAX.
+ */
+typedef struct bitmap * (image_cache_convert_scaled_fn) (struct content *content, unsigned int scale);
+
 struct image_cache_parameters {
 	/** How frequently the background cache clean process is run (ms) */
 	unsigned int bg_clean_time;
@@ -78,6 +89,21 @@ nserror image_cache_add(struct content *content,
 			struct bitmap *bitmap, 
 			image_cache_convert_fn *convert);
 
+/**
+ * Set a routine to convert a cached content directly at a reduced size.
+ *
+ * Images plotted much smaller than their intrinsic size are held by
+ * the cache at a reduced size. Without this routine the reduced bitmap
+ * is produced by downsampling a full size conversion.
+ *
+ * @param content The content handle used as a key
+ * @param convert_scaled The scaled conversion routine.
+ * @return NSERROR_OK on success or NSERROR_NOT_FOUND if the content has
+ *         not been added to the cache.
+ */
+nserror image_cache_set_convert_scaled(struct content *content,
+		image_cache_convert_scaled_fn *convert_scaled);
+
 nserror image_cache_remove(struct content *content);
 
 
@@ -99,6 +125,16 @@ struct bitmap *image_cache_find_bitmap(struct content *c);
  */
 bool image_cache_speculate(struct content *c);
 
+/** Decide if a content should be decoded as its data arrives.
+ *
+ * Decoding as data arrives allows a partially fetched image to be
+ * shown. This is done while the cache has room for the image's bitmap.
+ *
+ * @param c The content to be considered, with its dimensions known.
+ * @return true if the content should be decoded progressively.
+ */
+bool image_cache_progressive(const struct content *c);
+
 /**
  * Fill a buffer with information about a cache entry using a format.
  *
@@ -251,10 +251,18 @@ static inline void nsjpeg__decode_client_fmt(
 }
 
 /**
- * create a bitmap from jpeg content.
+ * create a bitmap from jpeg content reduced in size.
+ *
+ * The reduction is performed by the JPEG library as part of the
+ * inverse DCT, which is considerably cheaper than decoding at full
+ * size.
+ *
+ * \param c The jpeg content.
+ * \param scale Factor to reduce the image by, 1, 2, 4 or 8.
+ * \return The bitmap or NULL on error.
  */
 static struct bitmap *
-jpeg_cache_convert(struct content *c)
+jpeg_cache_convert_scaled(struct content *c, unsigned int scale)
 {
 	const uint8_t *source_data; /* Jpeg source data */
 	size_t source_size; /* length of Jpeg source data */
@@ -333,6 +341,8 @@ jpeg_cache_convert(struct content *c)
 #endif
 	}
 	cinfo.dct_method = JDCT_ISLOW;
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale;
 
 	/* commence the decompression, output parameters now valid */
 	jpeg_start_decompress(&cinfo);
@@ -380,6 +390,15 @@ jpeg_cache_convert(struct content *c)
 	return bitmap;
 }
 
+/**
+ * create a bitmap from jpeg content.
+ */
+static struct bitmap *
+jpeg_cache_convert(struct content *c)
+{
+	return jpeg_cache_convert_scaled(c, 1);
+}
+
 /**
  * Convert a CONTENT_JPEG for display.
  */
@@ -431,6 +450,7 @@ static bool nsjpeg_convert(struct content *c)
 	jpeg_destroy_decompress(&cinfo);
 
 	image_cache_add(c, NULL, jpeg_cache_convert);
+	image_cache_set_convert_scaled(c, jpeg_cache_convert_scaled);
 
 	/* set title text */
 	title = messages_get_buff("JPEGTitle",
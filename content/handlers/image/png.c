@@ -28,7 +28,9 @@
 #include "utils/log.h"
 #include "utils/messages.h"
 #include "netsurf/bitmap.h"
+#include "netsurf/misc.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "content/content_factory.h"
 #include "desktop/gui_internal.h"
@@ -48,6 +50,9 @@
 #define png_set_expand_gray_1_2_4_to_8(png) png_set_gray_1_2_4_to_8(png)
 #endif
 
+/** Minimum time, in ms, between redraws of a partially decoded image */
+#define NSPNG_REDRAW_INTERVAL_MS 200
+
 typedef struct nspng_content {
 	struct content base; /**< base content type */
 
@@ -58,6 +63,11 @@ typedef struct nspng_content {
 	struct bitmap *bitmap;	/**< Created NetSurf bitmap */
 	size_t rowstride, bpp; /**< Bitmap rowstride and bpp */
 	size_t rowbytes; /**< Number of bytes per row */
+
+	bool progressive; /**< Partially decoded bitmap may be plotted */
+	bool redraw_scheduled; /**< Redraw of decoded rows is scheduled */
+	png_uint_32 rows; /**< Number of rows decoded */
+	png_uint_32 rows_redrawn; /**< Number of decoded rows redrawn */
 } nspng_content;
 
 static unsigned int interlace_start[8] = {0, 16, 0, 8, 0, 4, 0};
@@ -169,33 +179,77 @@ static void nspng_setup_transforms(png_structp png_ptr, png_infop info_ptr)
 	png_read_update_info(png_ptr, info_ptr);
 }
 
+/**
+ * Scheduled callback to redraw the rows of a partially decoded image
+ *
+ * \param p The png content.
+ */
+static void nspng_redraw_rows(void *p)
+{
+	nspng_content *png_c = p;
+	union content_msg_data data;
+
+	png_c->redraw_scheduled = false;
+
+	if ((png_c->bitmap == NULL) ||
+	    (png_c->rows <= png_c->rows_redrawn)) {
+		return;
+	}
+
+	guit->bitmap->modified(png_c->bitmap);
+
+	data.redraw.x = 0;
+	data.redraw.y = png_c->rows_redrawn;
+	data.redraw.width = png_c->base.width;
+	data.redraw.height = png_c->rows - png_c->rows_redrawn;
+
+	png_c->rows_redrawn = png_c->rows;
+
+	content_broadcast(&png_c->base, CONTENT_MSG_REDRAW, &data);
+}
+
 /**
  * info_callback -- PNG header has been completely received, prepare to process
  * image data
  */
 static void info_callback(png_structp png_s, png_infop info)
 {
-	int interlace;
+	int interlace, color_type;
+	bool alpha;
 	png_uint_32 width, height;
 	nspng_content *png_c = png_get_progressive_ptr(png_s);
 
 	width = png_get_image_width(png_s, info);
 	height = png_get_image_height(png_s, info);
 	interlace = png_get_interlace_type(png_s, info);
+	color_type = png_get_color_type(png_s, info);
+	alpha = (color_type & PNG_COLOR_MASK_ALPHA) ||
+		png_get_valid(png_s, info, PNG_INFO_tRNS);
 
 	png_c->base.width = width;
 	png_c->base.height = height;
 	png_c->base.size += width * height * 4;
 
 	/* see if progressive-conversion should continue */
-	if (image_cache_speculate((struct content *)png_c) == false) {
+	if ((image_cache_speculate((struct content *)png_c) == false) &&
+	    (image_cache_progressive((struct content *)png_c) == false)) {
 		longjmp(png_jmpbuf(png_s), CBERR_NOPRE);
 	}
 
-	/* Claim the required memory for the converted PNG */
-	png_c->bitmap = guit->bitmap->create(width, height, BITMAP_NONE);
+	png_c->interlace = (interlace == PNG_INTERLACE_ADAM7);
+
+	/* The partially decoded bitmap may be shown if rows are complete
+	 * as they arrive and already in the client format. Images with
+	 * alpha are premultiplied, if required, only once complete. */
+	png_c->progressive = !png_c->interlace && (!alpha || !bitmap_fmt.pma);
+
+	/* Claim the required memory for the converted PNG. Rows not yet
+	 * decoded are shown while progressive, so they must start clear. */
+	png_c->bitmap = guit->bitmap->create(width, height,
+			png_c->progressive ? BITMAP_CLEAR : BITMAP_NONE);
 	if (png_c->bitmap == NULL) {
 		/* Failed to create bitmap skip pre-conversion */
+		png_c->progressive = false;
 		longjmp(png_jmpbuf(png_s), CBERR_NOPRE);
 	}
 
@@ -205,7 +259,11 @@ static void info_callback(png_structp png_s, png_infop info)
 	nspng_setup_transforms(png_s, info);
 
 	png_c->rowbytes = png_get_rowbytes(png_s, info);
-	png_c->interlace = (interlace == PNG_INTERLACE_ADAM7);
+
+	if (png_c->progressive &&
+	    image_cache_add(&png_c->base, png_c->bitmap, NULL) != NSERROR_OK) {
+		png_c->progressive = false;
+	}
 
 	NSLOG(netsurf, INFO, "size %li * %li, rowbytes %"PRIsizet,
 	      (unsigned long)width, (unsigned long)height, png_c->rowbytes);
@@ -261,6 +319,17 @@ static void row_callback(png_structp png_s, png_bytep new_row,
 		/* Do a fast memcpy of the row data */
 		memcpy(row, new_row, rowbytes);
 	}
+
+	if (png_c->progressive) {
+		if (row_num >= png_c->rows) {
+			png_c->rows = row_num + 1;
+		}
+		if (!png_c->redraw_scheduled) {
+			png_c->redraw_scheduled = true;
+			guit->misc->schedule(NSPNG_REDRAW_INTERVAL_MS,
+					nspng_redraw_rows, png_c);
+		}
+	}
 }
 
 
@@ -561,6 +630,12 @@ static bool nspng_convert(struct content *c)
 	/* clean up png structures */
 	png_destroy_read_struct(&png_c->png, &png_c->info, 0);
 
+	/* the complete image is redrawn when done */
+	if (png_c->redraw_scheduled) {
+		guit->misc->schedule(-1, nspng_redraw_rows, png_c);
+		png_c->redraw_scheduled = false;
+	}
+
 	/* set title text */
 	title = messages_get_buff("PNGTitle",
 			nsurl_access_leaf(llcache_handle_get_url(c->llcache)),
@@ -590,6 +665,24 @@ static bool nspng_convert(struct content *c)
 }
 
 
+/**
+ * Destroy a png content, which may still be decoding.
+ */
+static void nspng_destroy(struct content *c)
+{
+	nspng_content *png_c = (nspng_content *) c;
+
+	if (png_c->redraw_scheduled) {
+		guit->misc->schedule(-1, nspng_redraw_rows, png_c);
+	}
+
+	if (png_c->png != NULL) {
+		png_destroy_read_struct(&png_c->png, &png_c->info, 0);
+	}
+
+	image_cache_destroy(c);
+}
+
 static nserror nspng_clone(const struct content *old_c, struct content **new_c)
 {
 	nspng_content *clone_png_c;
@@ -640,7 +733,7 @@ static const content_handler nspng_content_handler = {
 	.process_data = nspng_process_data,
 	.data_complete = nspng_convert,
 	.clone = nspng_clone,
-	.destroy = image_cache_destroy,
+	.destroy = nspng_destroy,
 	.redraw = image_cache_redraw,
 	.get_internal = image_cache_get_internal,
 	.type = image_cache_content_type,
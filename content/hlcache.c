@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <nsutils/time.h>
 
 #include "utils/http.h"
 #include "utils/log.h"
@@ -38,9 +39,17 @@
 #include "content/mimesniff.h"
 #include "content/hlcache.h"
 // Note, this is *ONLY* so that we can abort cleanly during shutdown of the cache
+// and size retained contents
 #include "content/content_protected.h"
 #include "content/content_factory.h"
 
+/** Time, in ms, an unused stylesheet is kept for reuse */
+#define HLCACHE_RETAIN_TIME (60 * 1000)
+
+/** Divisor of the low level cache limit giving the size of unused
+ * stylesheets kept for reuse */
+#define HLCACHE_RETAIN_FRACTION 16
+
 typedef struct hlcache_entry hlcache_entry;
 typedef struct hlcache_retrieval_ctx hlcache_retrieval_ctx;
 
@@ -76,6 +85,8 @@ struct hlcache_entry {
 
 	hlcache_entry *next;		/**< Next sibling */
 	hlcache_entry *prev;		/**< Previous sibling */
+
+	uint64_t unused_ms;		/**< Time content was found unused, 0 if in use */
 };
 
 /** Current state of the cache.
@@ -105,6 +116,44 @@ static struct hlcache_s *hlcache = NULL;
  ******************************************************************************/
 
 
+/**
+ * Determine if an unused content should be kept for reuse
+ *
+ * Stylesheets are costly to parse and are usually shared by all the
+ * pages of a site, so unused ones are kept in memory for a while in
+ * case the next page needs them. A kept content is only reused by a
+ * retrieval which references the same low level cache object.
+ *
+ * \param entry          The cache entry with an unused content
+ * \param now_ms         The current time
+ * \param retained_size  Size of the contents already kept, updated
+ * \return true if the content should be kept, false to destroy it
+ */
+static bool hlcache_retain(hlcache_entry *entry, uint64_t now_ms,
+		size_t *retained_size)
+{
+	hlcache_handle entry_handle = { entry, NULL, NULL };
+
+	if (content_get_type(&entry_handle) != CONTENT_CSS ||
+			content__get_status(entry->content) !=
+					CONTENT_STATUS_DONE)
+		return false;
+
+	if (entry->unused_ms == 0) {
+		entry->unused_ms = now_ms;
+	} else if (now_ms - entry->unused_ms > HLCACHE_RETAIN_TIME) {
+		return false;
+	}
+
+	if (*retained_size + entry->content->size >
+			hlcache->params.llcache.limit / HLCACHE_RETAIN_FRACTION)
+		return false;
+
+	*retained_size += entry->content->size;
+
+	return true;
+}
+
 /**
  * Attempt to clean the cache
  */
@@ -112,6 +161,11 @@ static void hlcache_clean(void *force_clean_flag)
 {
 	hlcache_entry *entry, *next;
 	bool force_clean = (force_clean_flag != NULL);
+	size_t retained_size = 0;
+	unsigned int retained_count = 0;
+	uint64_t now_ms;
+
+	nsu_getmonotonic_ms(&now_ms);
 
 	for (entry = hlcache->content_list; entry != NULL; entry = next) {
 		next = entry->next;
@@ -119,8 +173,10 @@ static void hlcache_clean(void *force_clean_flag)
 		if (entry->content == NULL)
 			continue;
 
-		if (content_count_users(entry->content) != 0)
+		if (content_count_users(entry->content) != 0) {
+			entry->unused_ms = 0;
 			continue;
+		}
 
 		if (content__get_status(entry->content) == CONTENT_STATUS_LOADING) {
 			if (force_clean == false)
@@ -130,6 +186,12 @@ static void hlcache_clean(void *force_clean_flag)
 			content_set_error(entry->content);
 		}
 
+		if (force_clean == false &&
+				hlcache_retain(entry, now_ms, &retained_size)) {
+			retained_count++;
+			continue;
+		}
+
 		/** \todo This is over-zealous: all unused contents
 		 * will be immediately destroyed. Ideally, we want to
 		 * purge all unused contents that are using stale
@@ -153,6 +215,12 @@ static void hlcache_clean(void *force_clean_flag)
 		free(entry);
 	}
 
+	if (retained_count > 0) {
+		NSLOG(netsurf, DEBUG,
+		      "Keeping %u unused stylesheets (%"PRIsizet" bytes)",
+		      retained_count, retained_size);
+	}
+
 	/* Attempt to clean the llcache */
 	llcache_clean(false);
 
@@ -266,6 +334,8 @@ static nserror hlcache_find_content(hlcache_retrieval_ctx *ctx,
 			return NSERROR_NOMEM;
 
 		/* Create content using llhandle */
+		entry->unused_ms = 0;
+
 		entry->content = content_factory_create_content(ctx->llcache,
 				ctx->child.charset, ctx->child.quirks,
 				effective_type);
@@ -288,6 +358,7 @@ static nserror hlcache_find_content(hlcache_retrieval_ctx *ctx,
 	} else {
 		/* Found a suitable content: no longer need low-level handle */
 		llcache_handle_release(ctx->llcache);
+		entry->unused_ms = 0;
 		hlcache->hit_count++;
 	}
 
@@ -310,6 +310,7 @@ search_text(struct textsearch_context *context,
 					&bounds);
 	if (res == NSERROR_OK) {
 		msg_data.scroll.area = true;
+		msg_data.scroll.relative = false;
 		msg_data.scroll.x0 = bounds.x0;
 		msg_data.scroll.y0 = bounds.y0;
 		msg_data.scroll.x1 = bounds.x1;
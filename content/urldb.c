@@ -311,6 +311,19 @@ static int loaded_cookie_file_version;
  * shockingly wasteful on memory.
  */
 static struct bloom_filter *url_bloom;
+
+/**
+ * filter for visited url presence in database
+ *
+ * Bloom filter holding the hashes of URLs with a non-zero visit
+ * count. Style selection asks whether every link on a page has been
+ * visited and the answer is almost always no; this filter lets that
+ * case be answered without searching the database. Entries are never
+ * removed when visit data is reset, which merely results in a false
+ * positive that the full search then resolves.
+ */
+static struct bloom_filter *visited_bloom;
+
 /**
  * Size of url filter
  */
@@ -2862,11 +2875,15 @@ void urldb_destroy(void)
 	}
 	memset(&db_root, 0, sizeof(db_root));
 
-	/* And the bloom filter */
+	/* And the bloom filters */
 	if (url_bloom != NULL) {
 		bloom_destroy(url_bloom);
 		url_bloom = NULL;
 	}
+	if (visited_bloom != NULL) {
+		bloom_destroy(visited_bloom);
+		visited_bloom = NULL;
+	}
 }
 
 
@@ -2889,6 +2906,8 @@ nserror urldb_load(const char *filename)
 
 	if (url_bloom == NULL)
 		url_bloom = bloom_create(BLOOM_SIZE);
+	if (visited_bloom == NULL)
+		visited_bloom = bloom_create(BLOOM_SIZE);
 
 	fp = fopen(filename, "r");
 	if (!fp) {
@@ -3048,8 +3067,14 @@ nserror urldb_load(const char *filename)
 
 			if (!fgets(s, MAXIMUM_URL_LENGTH, fp))
 				break;
-			if (p)
+			if (p) {
 				p->urld.visits = (unsigned int)atoi(s);
+				if (p->urld.visits > 0 &&
+				    visited_bloom != NULL) {
+					bloom_insert_hash(visited_bloom,
+							nsurl_hash(p->url));
+				}
+			}
 
 			/* entry last use time */
 			if (!fgets(s, MAXIMUM_URL_LENGTH, fp)) {
@@ -3152,6 +3177,8 @@ bool urldb_add_url(nsurl *url)
 
 	if (url_bloom == NULL)
 		url_bloom = bloom_create(BLOOM_SIZE);
+	if (visited_bloom == NULL)
+		visited_bloom = bloom_create(BLOOM_SIZE);
 
 	if (url_bloom != NULL) {
 		uint32_t hash = nsurl_hash(url);
@@ -3281,6 +3308,10 @@ nserror urldb_update_url_visit_data(nsurl *url)
 	p->urld.last_visit = time(NULL);
 	p->urld.visits++;
 
+	if (visited_bloom != NULL) {
+		bloom_insert_hash(visited_bloom, nsurl_hash(url));
+	}
+
 	return NSERROR_OK;
 }
 
@@ -3319,6 +3350,28 @@ const struct url_data *urldb_get_url_data(nsurl *url)
 }
 
 
+/* exported interface documented in content/urldb.h */
+bool urldb_get_url_visited(nsurl *url)
+{
+	struct path_data *p;
+
+	assert(url);
+
+	if (visited_bloom != NULL) {
+		if (bloom_search_hash(visited_bloom, nsurl_hash(url)) == false) {
+			return false;
+		}
+	}
+
+	p = urldb_find_url(url);
+	if (p == NULL) {
+		return false;
+	}
+
+	return (p->urld.visits > 0);
+}
+
+
 /* exported interface documented in content/urldb.h */
 nsurl *urldb_get_url(nsurl *url)
 {
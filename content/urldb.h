@@ -112,6 +112,18 @@ nserror urldb_update_url_visit_data(struct nsurl *url);
 void urldb_reset_url_visit_data(struct nsurl *url);
 
 
+/**
+ * Determine whether an URL has been visited
+ *
+ * Unvisited URLs are usually rejected by a filter without searching
+ * the database.
+ *
+ * \param url Absolute URL to check
+ * \return true if the URL is in the database with a non-zero visit count
+ */
+bool urldb_get_url_visited(struct nsurl *url);
+
+
 /**
  * Extract an URL from the db
  *
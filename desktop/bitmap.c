@@ -134,53 +134,125 @@ void bitmap_set_format(const bitmap_fmt_t *bitmap_format)
 }
 
 /**
- * Swap colour component order.
+ * Bit shifts of the colour components of a pixel loaded as a word.
+ */
+struct bitmap_colour_shift {
+	uint8_t r; /**< Shift of red component. */
+	uint8_t g; /**< Shift of green component. */
+	uint8_t b; /**< Shift of blue component. */
+	uint8_t a; /**< Shift of alpha component. */
+};
+
+/**
+ * Get the component shifts within a host word for a channel layout.
  *
- * \param[in] width      Bitmap width in pixels.
- * \param[in] height     Bitmap height in pixels.
- * \param[in] buffer     Pixel buffer.
- * \param[in] rowstride  Pixel buffer row stride in bytes.
- * \param[in] to         Pixel layout to convert to.
- * \param[in] from       Pixel layout to convert from.
+ * \param[in] layout  Channel layout to get shifts for.
+ * \return colour shift structure.
  */
-static inline void bitmap__format_convert(
-		int width,
-		int height,
-		uint8_t *buffer,
-		size_t rowstride,
-		struct bitmap_colour_layout to,
-		struct bitmap_colour_layout from)
+static inline struct bitmap_colour_shift bitmap__get_colour_shift(
+		struct bitmap_colour_layout layout)
 {
-	/* Just swapping the components around */
-	for (int y = 0; y < height; y++) {
-		uint8_t *row = buffer;
+	if (endian_host_is_le()) {
+		return (struct bitmap_colour_shift) {
+			.r = layout.r * 8,
+			.g = layout.g * 8,
+			.b = layout.b * 8,
+			.a = layout.a * 8,
+		};
+	}
 
-		for (int x = 0; x < width; x++) {
-			const uint32_t px = *((uint32_t *)(void *) row);
+	return (struct bitmap_colour_shift) {
+		.r = (3 - layout.r) * 8,
+		.g = (3 - layout.g) * 8,
+		.b = (3 - layout.b) * 8,
+		.a = (3 - layout.a) * 8,
+	};
+}
 
-			row[to.r] = ((const uint8_t *) &px)[from.r];
-			row[to.g] = ((const uint8_t *) &px)[from.g];
-			row[to.b] = ((const uint8_t *) &px)[from.b];
-			row[to.a] = ((const uint8_t *) &px)[from.a];
+/**
+ * Component reordering of a pixel loaded as a word.
+ *
+ * In every byte-wise layout green is opposite alpha, so rotating the
+ * pixel to move alpha into place also places green. Red and blue are
+ * then either in place or need exchanging.
+ */
+struct bitmap_colour_swizzle {
+	unsigned int rotate; /**< Bits to rotate the pixel left by. */
+	uint32_t swap; /**< Mask of lower of red and blue, if exchanged. */
+};
 
-			row += sizeof(uint32_t);
-		}
+/**
+ * Get the component reordering between two channel layouts.
+ *
+ * \param[in] to    Component shifts to convert to.
+ * \param[in] from  Component shifts to convert from.
+ * \return colour swizzle structure.
+ */
+static inline struct bitmap_colour_swizzle bitmap__get_colour_swizzle(
+		struct bitmap_colour_shift to,
+		struct bitmap_colour_shift from)
+{
+	unsigned int rotate = (to.a - from.a) & 31;
+	unsigned int lower = (to.r < to.b) ? to.r : to.b;
 
-		buffer += rowstride;
-	}
+	return (struct bitmap_colour_swizzle) {
+		.rotate = rotate,
+		.swap = (((from.r + rotate) & 31) == to.r) ? 0 : 0xffu << lower,
+	};
+}
+
+/**
+ * Swap colour component order of a pixel.
+ *
+ * \param[in] px       Pixel to convert.
+ * \param[in] swizzle  Component reordering to apply.
+ * \return the converted pixel.
+ */
+static inline uint32_t bitmap__swizzle(
+		uint32_t px,
+		struct bitmap_colour_swizzle swizzle)
+{
+	uint32_t t;
+
+	px = (px << swizzle.rotate) | (px >> ((32 - swizzle.rotate) & 31));
+
+	t = (px ^ (px >> 16)) & swizzle.swap;
+
+	return px ^ t ^ (t << 16);
 }
 
 /**
- * Convert plain alpha to premultiplied alpha.
+ * Pixel row conversion function.
+ *
+ * \param[in] row      Row of pixels to convert.
+ * \param[in] width    Row width in pixels.
+ * \param[in] swizzle  Component reordering to apply.
+ * \param[in] alpha    Shift of the alpha component after reordering.
+ */
+typedef void (*bitmap__convert_row_fn)(
+		uint32_t *row,
+		int width,
+		struct bitmap_colour_swizzle swizzle,
+		unsigned int alpha);
+
+/**
+ * Convert the rows of a bitmap.
  *
- * \param[in] width      Bitmap width in pixels.
- * \param[in] height     Bitmap height in pixels.
- * \param[in] buffer     Pixel buffer.
- * \param[in] rowstride  Pixel buffer row stride in bytes.
- * \param[in] to         Pixel layout to convert to.
- * \param[in] from       Pixel layout to convert from.
+ * Alpha is always in the top or bottom byte of a word, and often no
+ * reordering is needed. The row conversion is called with these as
+ * constants, so once inlined the compiler can drop the reordering and
+ * use fixed shifts and masks in the inner loop.
+ *
+ * \param[in] convert_row  Row conversion function.
+ * \param[in] width        Bitmap width in pixels.
+ * \param[in] height       Bitmap height in pixels.
+ * \param[in] buffer       Pixel buffer.
+ * \param[in] rowstride    Pixel buffer row stride in bytes.
+ * \param[in] to           Pixel layout to convert to.
+ * \param[in] from         Pixel layout to convert from.
  */
-static inline void bitmap__format_convert_to_pma(
+static inline void bitmap__format_convert_rows(
+		bitmap__convert_row_fn convert_row,
 		int width,
 		int height,
 		uint8_t *buffer,
@@ -188,32 +260,27 @@ static inline void bitmap__format_convert_to_pma(
 		struct bitmap_colour_layout to,
 		struct bitmap_colour_layout from)
 {
+	const struct bitmap_colour_swizzle none = { 0, 0 };
+	struct bitmap_colour_shift to_shift = bitmap__get_colour_shift(to);
+	struct bitmap_colour_swizzle swizzle = bitmap__get_colour_swizzle(
+			to_shift, bitmap__get_colour_shift(from));
+	bool reorder = (swizzle.rotate != 0 || swizzle.swap != 0);
+
 	for (int y = 0; y < height; y++) {
-		uint8_t *row = buffer;
+		uint32_t *row = (uint32_t *)(void *) buffer;
 
-		for (int x = 0; x < width; x++) {
-			const uint32_t px = *((uint32_t *)(void *) row);
-			uint32_t a, r, g, b;
-
-			r = ((const uint8_t *) &px)[from.r];
-			g = ((const uint8_t *) &px)[from.g];
-			b = ((const uint8_t *) &px)[from.b];
-			a = ((const uint8_t *) &px)[from.a];
-
-			if (a != 0) {
-				r = ((r * (a + 1)) >> 8) & 0xff;
-				g = ((g * (a + 1)) >> 8) & 0xff;
-				b = ((b * (a + 1)) >> 8) & 0xff;
+		if (to_shift.a == 0) {
+			if (reorder) {
+				convert_row(row, width, swizzle, 0);
 			} else {
-				r = g = b = 0;
+				convert_row(row, width, none, 0);
+			}
+		} else {
+			if (reorder) {
+				convert_row(row, width, swizzle, 24);
+			} else {
+				convert_row(row, width, none, 24);
 			}
-
-			row[to.r] = r;
-			row[to.g] = g;
-			row[to.b] = b;
-			row[to.a] = a;
-
-			row += sizeof(uint32_t);
 		}
 
 		buffer += rowstride;
@@ -221,56 +288,110 @@ static inline void bitmap__format_convert_to_pma(
 }
 
 /**
- * Convert from premultiplied alpha to plain alpha.
+ * Swap colour component order of a row.
+ *
+ * Pixels are handled a word at a time, with no branches in the inner
+ * loop, so compilers are able to vectorise it.
  *
- * \param[in] width      Bitmap width in pixels.
- * \param[in] height     Bitmap height in pixels.
- * \param[in] buffer     Pixel buffer.
- * \param[in] rowstride  Pixel buffer row stride in bytes.
- * \param[in] to         Pixel layout to convert to.
- * \param[in] from       Pixel layout to convert from.
+ * \param[in] row      Row of pixels to convert.
+ * \param[in] width    Row width in pixels.
+ * \param[in] swizzle  Component reordering to apply.
+ * \param[in] alpha    Shift of the alpha component after reordering.
  */
-static inline void bitmap__format_convert_from_pma(
+static inline void bitmap__format_convert_row(
+		uint32_t *row,
 		int width,
-		int height,
-		uint8_t *buffer,
-		size_t rowstride,
-		struct bitmap_colour_layout to,
-		struct bitmap_colour_layout from)
+		struct bitmap_colour_swizzle swizzle,
+		unsigned int alpha)
 {
-	for (int y = 0; y < height; y++) {
-		uint8_t *row = buffer;
+	for (int x = 0; x < width; x++) {
+		row[x] = bitmap__swizzle(row[x], swizzle);
+	}
+}
 
-		for (int x = 0; x < width; x++) {
-			const uint32_t px = *((uint32_t *)(void *) row);
-			uint32_t a, r, g, b;
-
-			r = ((const uint8_t *) &px)[from.r];
-			g = ((const uint8_t *) &px)[from.g];
-			b = ((const uint8_t *) &px)[from.b];
-			a = ((const uint8_t *) &px)[from.a];
-
-			if (a != 0) {
-				r = (r << 8) / a;
-				g = (g << 8) / a;
-				b = (b << 8) / a;
-
-				r = (r > 255) ? 255 : r;
-				g = (g > 255) ? 255 : g;
-				b = (b > 255) ? 255 : b;
-			} else {
-				r = g = b = 0;
-			}
+/**
+ * Convert a row from plain alpha to premultiplied alpha.
+ *
+ * The colour components are multiplied two at a time, each in its own
+ * 16 bit lane of a word. A zero alpha multiplies colour to zero, so no
+ * branches are needed.
+ *
+ * \param[in] row      Row of pixels to convert.
+ * \param[in] width    Row width in pixels.
+ * \param[in] swizzle  Component reordering to apply.
+ * \param[in] alpha    Shift of the alpha component after reordering.
+ */
+static inline void bitmap__format_convert_row_to_pma(
+		uint32_t *row,
+		int width,
+		struct bitmap_colour_swizzle swizzle,
+		unsigned int alpha)
+{
+	const uint32_t alpha_mask = 0xffu << alpha;
 
-			row[to.r] = r;
-			row[to.g] = g;
-			row[to.b] = b;
-			row[to.a] = a;
+	for (int x = 0; x < width; x++) {
+		uint32_t px, m, lo, hi;
 
-			row += sizeof(uint32_t);
-		}
+		px = bitmap__swizzle(row[x], swizzle);
+		m = ((px >> alpha) & 0xff) + 1;
 
-		buffer += rowstride;
+		lo = (((px & 0x00ff00ff) * m) >> 8) & 0x00ff00ff;
+		hi = (((px >> 8) & 0x00ff00ff) * m) & 0xff00ff00;
+
+		row[x] = ((lo | hi) & ~alpha_mask) | (px & alpha_mask);
+	}
+}
+
+/**
+ * Reciprocals of alpha values, scaled by 2^24 and rounded up.
+ *
+ * For a dividend below 2^16 and a divisor below 256, multiplying by
+ * the reciprocal and shifting down by 24 gives the exact quotient.
+ * The dividend is a component shifted up by 8, so the component is
+ * multiplied and shifted down by 16 instead, which fits in 32 bits.
+ * Zero alpha has a zero reciprocal, giving zero colour.
+ */
+static uint32_t bitmap__alpha_reciprocal[256];
+
+/**
+ * Convert a row from premultiplied alpha to plain alpha.
+ *
+ * Divisions are replaced by multiplication with a table of alpha
+ * reciprocals. Every byte is divided, so the shifts are constant, and
+ * the alpha byte is then restored.
+ *
+ * \param[in] row      Row of pixels to convert.
+ * \param[in] width    Row width in pixels.
+ * \param[in] swizzle  Component reordering to apply.
+ * \param[in] alpha    Shift of the alpha component after reordering.
+ */
+static inline void bitmap__format_convert_row_from_pma(
+		uint32_t *row,
+		int width,
+		struct bitmap_colour_swizzle swizzle,
+		unsigned int alpha)
+{
+	const uint32_t alpha_mask = 0xffu << alpha;
+	const uint32_t *reciprocal = bitmap__alpha_reciprocal;
+
+	for (int x = 0; x < width; x++) {
+		uint32_t px, m, c0, c1, c2, c3;
+
+		px = bitmap__swizzle(row[x], swizzle);
+		m = reciprocal[(px >> alpha) & 0xff];
+
+		c0 = ((px & 0xff) * m) >> 16;
+		c1 = (((px >> 8) & 0xff) * m) >> 16;
+		c2 = (((px >> 16) & 0xff) * m) >> 16;
+		c3 = ((px >> 24) * m) >> 16;
+
+		c0 = (c0 > 255) ? 255 : c0;
+		c1 = (c1 > 255) ? 255 : c1;
+		c2 = (c2 > 255) ? 255 : c2;
+		c3 = (c3 > 255) ? 255 : c3;
+
+		row[x] = ((c0 | (c1 << 8) | (c2 << 16) | (c3 << 24)) &
+				~alpha_mask) | (px & alpha_mask);
 	}
 }
 
@@ -294,18 +415,31 @@ void bitmap_format_convert(void *bitmap,
 
 	if (fmt_from->pma == fmt_to->pma) {
 		/* Just component order to switch. */
-		bitmap__format_convert(
+		if (to.r == from.r && to.g == from.g &&
+		    to.b == from.b && to.a == from.a) {
+			return;
+		}
+		bitmap__format_convert_rows(
+				bitmap__format_convert_row,
 				width, height, buffer,
 				rowstride, to, from);
 
 	} else if (opaque == false) {
 		/* Need to do conversion to/from premultiplied alpha. */
 		if (fmt_to->pma) {
-			bitmap__format_convert_to_pma(
+			bitmap__format_convert_rows(
+					bitmap__format_convert_row_to_pma,
 					width, height, buffer,
 					rowstride, to, from);
 		} else {
-			bitmap__format_convert_from_pma(
+			if (bitmap__alpha_reciprocal[1] == 0) {
+				for (uint32_t a = 1; a < 256; a++) {
+					bitmap__alpha_reciprocal[a] =
+						((1u << 24) + a - 1) / a;
+				}
+			}
+			bitmap__format_convert_rows(
+					bitmap__format_convert_row_from_pma,
 					width, height, buffer,
 					rowstride, to, from);
 		}
@@ -319,16 +453,20 @@ bool bitmap_test_opaque(void *bitmap)
 	int height = guit->bitmap->get_height(bitmap);
 	size_t rowstride = guit->bitmap->get_rowstride(bitmap);
 	const uint8_t *buffer = guit->bitmap->get_buffer(bitmap);
-
-	width *= sizeof(uint32_t);
+	const uint32_t alpha_mask = 0xffu <<
+			bitmap__get_colour_shift(bitmap_layout).a;
 
 	for (int y = 0; y < height; y++) {
-		const uint8_t *row = buffer;
+		const uint32_t *row = (const uint32_t *)(const void *) buffer;
+		uint32_t alpha = alpha_mask;
 
-		for (int x = bitmap_layout.a; x < width; x += 4) {
-			if (row[x] != 0xff) {
-				return false;
-			}
+		/* Only check once per row, keeping the loop branch free */
+		for (int x = 0; x < width; x++) {
+			alpha &= row[x];
+		}
+
+		if (alpha != alpha_mask) {
+			return false;
 		}
 
 		buffer += rowstride;
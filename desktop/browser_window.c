@@ -255,6 +255,28 @@ browser_window_set_scroll(struct browser_window *bw, const struct rect *rect)
 }
 
 
+/**
+ * Get the scroll position of a browser window.
+ *
+ * \param bw window to get the scroll position of
+ * \param sx updated to the x ordinate of the point at the top left
+ * \param sy updated to the y ordinate of the point at the top left
+ */
+static void
+browser_window_get_scroll(struct browser_window *bw, int *sx, int *sy)
+{
+	if (bw->window != NULL) {
+		if (!guit->window->get_scroll(bw->window, sx, sy)) {
+			*sx = *sy = 0;
+		}
+		return;
+	}
+
+	*sx = scrollbar_get_offset(bw->scroll_x);
+	*sy = scrollbar_get_offset(bw->scroll_y);
+}
+
+
 /**
  * Internal helper for getting the positional features
  *
@@ -1641,7 +1663,15 @@ browser_window_callback(hlcache_handle *c, const hlcache_event *event, void *pw)
 				break;
 			}
 
-			if (event->data.scroll.area) {
+			if (event->data.scroll.relative) {
+				int sx, sy;
+
+				browser_window_get_scroll(bw, &sx, &sy);
+				rect.x0 = rect.x1 = sx +
+					event->data.scroll.x0 * bw->scale;
+				rect.y0 = rect.y1 = sy +
+					event->data.scroll.y0 * bw->scale;
+			} else if (event->data.scroll.area) {
 				rect.x1 = event->data.scroll.x1;
 				rect.y1 = event->data.scroll.y1;
 			} else {
@@ -36,6 +36,7 @@
 #include "html/html.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
 
 #include "desktop/browser_private.h"
 #include "desktop/frames.h"
@@ -254,7 +255,17 @@ nserror browser_window_create_iframes(struct browser_window *bw)
 		/* linking */
 		window->box = cur->box;
 		window->parent = bw;
-		window->box->iframe = window;
+		if (box_set_iframe(window->box, window) != NSERROR_OK) {
+			/* unlink the boxes of windows already linked */
+			while (--index > 0) {
+				box_set_iframe(bw->iframes[index - 1].box,
+						NULL);
+			}
+			free(bw->iframes);
+			bw->iframes = 0;
+			bw->iframe_count = 0;
+			return NSERROR_NOMEM;
+		}
 
 		/* iframe dimensions */
 		box_bounds(window->box, &rect);
@@ -311,7 +322,7 @@ nserror browser_window_destroy_iframes(struct browser_window *bw)
 	if (bw->iframes != NULL) {
 		for (i = 0; i < bw->iframe_count; i++) {
 			if (bw->iframes[i].box != NULL) {
-				bw->iframes[i].box->iframe = NULL;
+				box_set_iframe(bw->iframes[i].box, NULL);
 				bw->iframes[i].box = NULL;
 			}
 			browser_window_destroy_internal(&bw->iframes[i]);
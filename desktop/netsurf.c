@@ -33,6 +33,7 @@
 #include "utils/nsoption.h"
 #include "utils/corestrings.h"
 #include "utils/log.h"
+#include "utils/nsurl.h"
 #include "utils/string.h"
 #include "utils/utf8.h"
 #include "utils/messages.h"
@@ -132,6 +133,11 @@ nserror netsurf_init(const char *store_path)
 	signal(SIGPIPE, SIG_IGN);
 #endif
 
+	/* share URL objects between identical URLs */
+	ret = nsurl_intern_init();
+	if (ret != NSERROR_OK)
+		return ret;
+
 	/* corestrings init */
 	ret = corestrings_init();
 	if (ret != NSERROR_OK)
@@ -272,6 +278,7 @@ void netsurf_exit(void)
 	messages_destroy();
 
 	corestrings_fini();
+	nsurl_intern_fini();
 	if (dom_namespace_finalise() != DOM_NO_ERR) {
 		NSLOG(netsurf, WARNING, "Unable to finalise DOM namespace strings");
 	}
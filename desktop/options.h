@@ -186,6 +186,13 @@ NSOPTION_BOOL(incremental_reflow, true)
 /* Minimum time (in cs) between HTML reflows while objects are fetching */
 NSOPTION_UINT(min_reflow_period, DEFAULT_REFLOW_PERIOD)
 
+/* Time (in cs) after which a page still being converted is first
+ * displayed, doubling between later updates; 0 disables */
+NSOPTION_UINT(progressive_render_period, 50)
+
+/* lay out text far from the viewport only when it is scrolled into view */
+NSOPTION_BOOL(lazy_layout, false)
+
 /* use core selection menu */
 NSOPTION_BOOL(core_select_menu, false)
 
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test region allocator operations.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <check.h>
+
+#include "utils/arena.h"
+#include "utils/talloc.h"
+
+#define SMALL_BLOCK_SIZE 64
+
+/* Tests */
+
+/**
+ * Test arena creation and destruction
+ */
+START_TEST(arena_create_test)
+{
+	struct arena *a;
+	size_t used, allocated;
+
+	ck_assert(arena_create(0, &a) == NSERROR_OK);
+	ck_assert(a != NULL);
+
+	arena_stats(a, &used, &allocated);
+	ck_assert_uint_eq(used, 0);
+
+	arena_destroy(a);
+}
+END_TEST
+
+/**
+ * Destroying a NULL arena is permitted
+ */
+START_TEST(arena_destroy_null_test)
+{
+	arena_destroy(NULL);
+}
+END_TEST
+
+/**
+ * Allocations are aligned and do not overlap
+ */
+START_TEST(arena_alloc_test)
+{
+	struct arena *a;
+	unsigned char *p[32];
+	int i, j;
+
+	ck_assert(arena_create(SMALL_BLOCK_SIZE, &a) == NSERROR_OK);
+
+	for (i = 0; i < 32; i++) {
+		p[i] = arena_alloc(a, i + 1);
+		ck_assert(p[i] != NULL);
+		ck_assert_uint_eq((uintptr_t)p[i] % sizeof(void *), 0);
+		memset(p[i], i, i + 1);
+	}
+
+	for (i = 0; i < 32; i++) {
+		for (j = 0; j <= i; j++) {
+			ck_assert_int_eq(p[i][j], i);
+		}
+	}
+
+	arena_destroy(a);
+}
+END_TEST
+
+/**
+ * Allocations larger than the block size succeed and do not discard
+ * the space left in the current block
+ */
+START_TEST(arena_alloc_oversize_test)
+{
+	struct arena *a;
+	char *small, *big, *after;
+
+	ck_assert(arena_create(SMALL_BLOCK_SIZE, &a) == NSERROR_OK);
+
+	small = arena_alloc(a, 8);
+	ck_assert(small != NULL);
+
+	big = arena_alloc(a, SMALL_BLOCK_SIZE * 4);
+	ck_assert(big != NULL);
+	memset(big, 'x', SMALL_BLOCK_SIZE * 4);
+
+	after = arena_alloc(a, 8);
+	ck_assert(after == small + 8);
+
+	arena_destroy(a);
+}
+END_TEST
+
+/**
+ * String duplication
+ */
+START_TEST(arena_strdup_test)
+{
+	struct arena *a;
+	char *s;
+
+	ck_assert(arena_create(0, &a) == NSERROR_OK);
+
+	s = arena_strdup(a, "NetSurf");
+	ck_assert_str_eq(s, "NetSurf");
+
+	s = arena_strndup(a, "NetSurf", 3);
+	ck_assert_str_eq(s, "Net");
+
+	s = arena_strndup(a, "Net\0Surf", 8);
+	ck_assert_str_eq(s, "Net");
+
+	s = arena_strdup(a, "");
+	ck_assert_str_eq(s, "");
+
+	arena_destroy(a);
+}
+END_TEST
+
+/**
+ * Usage statistics account for every allocation
+ */
+START_TEST(arena_stats_test)
+{
+	struct arena *a;
+	size_t used, allocated;
+
+	ck_assert(arena_create(SMALL_BLOCK_SIZE, &a) == NSERROR_OK);
+
+	arena_alloc(a, 1);
+	arena_alloc(a, SMALL_BLOCK_SIZE * 2);
+
+	arena_stats(a, &used, &allocated);
+	ck_assert(used >= SMALL_BLOCK_SIZE * 2 + 1);
+	ck_assert(allocated >= used);
+
+	arena_destroy(a);
+}
+END_TEST
+
+
+/* Throughput benchmark */
+
+/* The number of rounds each benchmark phase performs */
+#define BENCHMARK_ROUNDS 10
+
+/* The number of strings allocated per round, a large document's text */
+#define BENCHMARK_STRING_COUNT 200000
+
+/* The longest string allocated, a run of text between elements */
+#define BENCHMARK_STRING_MAX 96
+
+/**
+ * Report the rate of a benchmark phase
+ */
+static void
+benchmark_report(const char *phase, clock_t arena_time, clock_t talloc_time)
+{
+	double ops = (double)BENCHMARK_STRING_COUNT * BENCHMARK_ROUNDS;
+	double arena_secs = (double)arena_time / CLOCKS_PER_SEC;
+	double talloc_secs = (double)talloc_time / CLOCKS_PER_SEC;
+
+	fprintf(stderr,
+		"arena %-7s %11.0f strings/s talloc %11.0f strings/s\n",
+		phase,
+		(arena_secs > 0) ? ops / arena_secs : 0,
+		(talloc_secs > 0) ? ops / talloc_secs : 0);
+}
+
+/**
+ * Duplicating and releasing box text compared with talloc
+ *
+ * Strings are copied from a buffer at pseudo random offsets and
+ * lengths, as box construction copies text out of the DOM.
+ */
+START_TEST(benchmark_throughput)
+{
+	char text[BENCHMARK_STRING_MAX * 2];
+	clock_t start, arena_dup, arena_free, talloc_dup, talloc_free_time;
+	size_t used = 0, allocated = 0;
+	struct arena *a;
+	void *ctx;
+	int round;
+	int idx;
+
+	for (idx = 0; idx < (int)sizeof(text); idx++) {
+		text[idx] = 'a' + (idx % 26);
+	}
+
+	arena_dup = arena_free = talloc_dup = talloc_free_time = 0;
+
+	for (round = 0; round < BENCHMARK_ROUNDS; round++) {
+		srand(round);
+		start = clock();
+		ck_assert(arena_create(0, &a) == NSERROR_OK);
+		for (idx = 0; idx < BENCHMARK_STRING_COUNT; idx++) {
+			int r = rand();
+			ck_assert(arena_strndup(a,
+					text + (r % BENCHMARK_STRING_MAX),
+					1 + (r >> 8) % BENCHMARK_STRING_MAX)
+					!= NULL);
+		}
+		arena_dup += clock() - start;
+
+		arena_stats(a, &used, &allocated);
+
+		start = clock();
+		arena_destroy(a);
+		arena_free += clock() - start;
+
+		srand(round);
+		start = clock();
+		ctx = talloc_new(NULL);
+		ck_assert(ctx != NULL);
+		for (idx = 0; idx < BENCHMARK_STRING_COUNT; idx++) {
+			int r = rand();
+			ck_assert(talloc_strndup(ctx,
+					text + (r % BENCHMARK_STRING_MAX),
+					1 + (r >> 8) % BENCHMARK_STRING_MAX)
+					!= NULL);
+		}
+		talloc_dup += clock() - start;
+
+		start = clock();
+		talloc_free(ctx);
+		talloc_free_time += clock() - start;
+	}
+
+	benchmark_report("strdup", arena_dup, talloc_dup);
+	benchmark_report("release", arena_free, talloc_free_time);
+
+	fprintf(stderr, "arena %zu of %zu bytes used for %d strings\n",
+		used, allocated, BENCHMARK_STRING_COUNT);
+}
+END_TEST
+
+
+/**
+ * Basic API test case
+ */
+static TCase *arena_api_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("API");
+
+	tcase_add_test(tc, arena_create_test);
+	tcase_add_test(tc, arena_destroy_null_test);
+	tcase_add_test(tc, arena_alloc_test);
+	tcase_add_test(tc, arena_alloc_oversize_test);
+	tcase_add_test(tc, arena_strdup_test);
+	tcase_add_test(tc, arena_stats_test);
+
+	return tc;
+}
+
+/**
+ * Benchmark test case
+ */
+static TCase *arena_benchmark_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Benchmark");
+
+	tcase_add_test(tc, benchmark_throughput);
+
+	return tc;
+}
+
+
+static Suite *arena_suite(void)
+{
+	Suite *s;
+	s = suite_create("Region allocator");
+
+	suite_add_tcase(s, arena_api_case_create());
+	suite_add_tcase(s, arena_benchmark_case_create());
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = arena_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
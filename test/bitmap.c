@@ -0,0 +1,483 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test core bitmap pixel format conversion.
+ *
+ * Conversions are compared against straightforward per component
+ * implementations for every combination of byte-wise layouts.
+ *
+ * A benchmark reports the throughput of the conversions against those
+ * per component implementations.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <check.h>
+
+#include "utils/errors.h"
+#include "netsurf/bitmap.h"
+#include "desktop/gui_table.h"
+#include "desktop/gui_internal.h"
+#include "desktop/bitmap.h"
+
+#define TEST_WIDTH 37
+#define TEST_HEIGHT 11
+#define TEST_ROWSTRIDE ((TEST_WIDTH + 3) * 4)
+
+struct netsurf_table *guit = NULL;
+
+/** Mock bitmap */
+struct tst_bitmap {
+	bool opaque;
+	uint32_t buffer[TEST_HEIGHT * TEST_ROWSTRIDE / 4];
+};
+
+static const enum bitmap_layout layouts[] = {
+	BITMAP_LAYOUT_R8G8B8A8,
+	BITMAP_LAYOUT_B8G8R8A8,
+	BITMAP_LAYOUT_A8R8G8B8,
+	BITMAP_LAYOUT_A8B8G8R8,
+};
+
+#define NUM_LAYOUTS (sizeof(layouts) / sizeof(layouts[0]))
+
+
+/* mock table callbacks */
+static bool tst_get_opaque(void *b)
+{
+	return ((struct tst_bitmap *)b)->opaque;
+}
+
+static unsigned char *tst_get_buffer(void *b)
+{
+	return (unsigned char *)((struct tst_bitmap *)b)->buffer;
+}
+
+static size_t tst_get_rowstride(void *b)
+{
+	return TEST_ROWSTRIDE;
+}
+
+static int tst_get_width(void *b)
+{
+	return TEST_WIDTH;
+}
+
+static int tst_get_height(void *b)
+{
+	return TEST_HEIGHT;
+}
+
+static struct gui_bitmap_table tst_bitmap_table = {
+	.get_opaque = tst_get_opaque,
+	.get_buffer = tst_get_buffer,
+	.get_rowstride = tst_get_rowstride,
+	.get_width = tst_get_width,
+	.get_height = tst_get_height,
+};
+
+static struct netsurf_table tst_table = {
+	.bitmap = &tst_bitmap_table,
+};
+
+
+/**
+ * Byte offsets of the components of a byte-wise layout.
+ */
+static void layout_offsets(enum bitmap_layout layout, int *r, int *g,
+		int *b, int *a)
+{
+	switch (layout) {
+	case BITMAP_LAYOUT_B8G8R8A8:
+		*b = 0; *g = 1; *r = 2; *a = 3;
+		break;
+	case BITMAP_LAYOUT_A8R8G8B8:
+		*a = 0; *r = 1; *g = 2; *b = 3;
+		break;
+	case BITMAP_LAYOUT_A8B8G8R8:
+		*a = 0; *b = 1; *g = 2; *r = 3;
+		break;
+	default:
+		*r = 0; *g = 1; *b = 2; *a = 3;
+		break;
+	}
+}
+
+/**
+ * Reference conversion, one component at a time.
+ */
+static void reference_convert(struct tst_bitmap *bmp,
+		const bitmap_fmt_t *from, const bitmap_fmt_t *to)
+{
+	int fr, fg, fb, fa, tr, tg, tb, ta;
+	uint8_t *buffer = tst_get_buffer(bmp);
+
+	layout_offsets(from->layout, &fr, &fg, &fb, &fa);
+	layout_offsets(to->layout, &tr, &tg, &tb, &ta);
+
+	if (from->pma != to->pma && bmp->opaque) {
+		return;
+	}
+
+	for (int y = 0; y < TEST_HEIGHT; y++) {
+		uint8_t *px = buffer + y * TEST_ROWSTRIDE;
+
+		for (int x = 0; x < TEST_WIDTH; x++, px += 4) {
+			uint32_t r = px[fr], g = px[fg], b = px[fb], a = px[fa];
+
+			if (from->pma == to->pma) {
+				/* swap only */
+			} else if (to->pma) {
+				if (a != 0) {
+					r = ((r * (a + 1)) >> 8) & 0xff;
+					g = ((g * (a + 1)) >> 8) & 0xff;
+					b = ((b * (a + 1)) >> 8) & 0xff;
+				} else {
+					r = g = b = 0;
+				}
+			} else {
+				if (a != 0) {
+					r = (r << 8) / a;
+					g = (g << 8) / a;
+					b = (b << 8) / a;
+					r = (r > 255) ? 255 : r;
+					g = (g > 255) ? 255 : g;
+					b = (b > 255) ? 255 : b;
+				} else {
+					r = g = b = 0;
+				}
+			}
+
+			px[tr] = r;
+			px[tg] = g;
+			px[tb] = b;
+			px[ta] = a;
+		}
+	}
+}
+
+/**
+ * Fill a bitmap with pseudo random pixels covering all alpha values.
+ */
+static void fill_bitmap(struct tst_bitmap *bmp, unsigned int seed)
+{
+	uint8_t *buffer = tst_get_buffer(bmp);
+
+	srand(seed);
+	for (size_t i = 0; i < sizeof(bmp->buffer); i++) {
+		buffer[i] = rand();
+	}
+	/* ensure the extremes of alpha and colour are present */
+	buffer[0] = buffer[1] = buffer[2] = buffer[3] = 0;
+	buffer[4] = buffer[5] = buffer[6] = buffer[7] = 0xff;
+}
+
+
+/* Tests */
+
+/**
+ * Conversion between every pair of layouts and alpha types
+ */
+START_TEST(bitmap_format_convert_test)
+{
+	unsigned int from = _i / (NUM_LAYOUTS * 4);
+	unsigned int to = (_i / 4) % NUM_LAYOUTS;
+	bitmap_fmt_t fmt_from = {
+		.layout = layouts[from],
+		.pma = (_i & 1),
+	};
+	bitmap_fmt_t fmt_to = {
+		.layout = layouts[to],
+		.pma = (_i & 2),
+	};
+	struct tst_bitmap *bmp, *ref;
+
+	bmp = calloc(1, sizeof(*bmp));
+	ref = calloc(1, sizeof(*ref));
+	ck_assert(bmp != NULL && ref != NULL);
+
+	for (unsigned int opaque = 0; opaque < 2; opaque++) {
+		fill_bitmap(bmp, _i);
+		fill_bitmap(ref, _i);
+		bmp->opaque = ref->opaque = opaque;
+
+		bitmap_format_convert(bmp, &fmt_from, &fmt_to);
+		reference_convert(ref, &fmt_from, &fmt_to);
+
+		ck_assert(memcmp(bmp->buffer, ref->buffer,
+				sizeof(bmp->buffer)) == 0);
+	}
+
+	free(bmp);
+	free(ref);
+}
+END_TEST
+
+/**
+ * Conversion from premultiplied alpha for every colour and alpha value
+ */
+START_TEST(bitmap_format_convert_from_pma_test)
+{
+	bitmap_fmt_t fmt_from = {
+		.layout = BITMAP_LAYOUT_R8G8B8A8,
+		.pma = true,
+	};
+	bitmap_fmt_t fmt_to = {
+		.layout = BITMAP_LAYOUT_R8G8B8A8,
+		.pma = false,
+	};
+	struct tst_bitmap *bmp, *ref;
+	uint8_t *buffer;
+
+	bmp = calloc(1, sizeof(*bmp));
+	ref = calloc(1, sizeof(*ref));
+	ck_assert(bmp != NULL && ref != NULL);
+
+	for (unsigned int a = 0; a < 256; a++) {
+		buffer = tst_get_buffer(bmp);
+		for (size_t i = 0; i < sizeof(bmp->buffer); i += 4) {
+			unsigned int c = (i / 4) % 256;
+			buffer[i + 0] = c;
+			buffer[i + 1] = 255 - c;
+			buffer[i + 2] = c ^ a;
+			buffer[i + 3] = a;
+		}
+		memcpy(ref->buffer, bmp->buffer, sizeof(bmp->buffer));
+
+		bitmap_format_convert(bmp, &fmt_from, &fmt_to);
+		reference_convert(ref, &fmt_from, &fmt_to);
+
+		ck_assert(memcmp(bmp->buffer, ref->buffer,
+				sizeof(bmp->buffer)) == 0);
+	}
+
+	free(bmp);
+	free(ref);
+}
+END_TEST
+
+/**
+ * Opacity test for every layout
+ */
+START_TEST(bitmap_test_opaque_test)
+{
+	bitmap_fmt_t fmt = {
+		.layout = layouts[_i],
+		.pma = false,
+	};
+	struct tst_bitmap *bmp;
+	int r, g, b, a;
+	uint8_t *buffer;
+
+	bitmap_set_format(&fmt);
+	layout_offsets(layouts[_i], &r, &g, &b, &a);
+
+	bmp = calloc(1, sizeof(*bmp));
+	ck_assert(bmp != NULL);
+	buffer = tst_get_buffer(bmp);
+
+	/* opaque everywhere except the unused end of rows */
+	for (int y = 0; y < TEST_HEIGHT; y++) {
+		for (int x = 0; x < TEST_WIDTH; x++) {
+			buffer[y * TEST_ROWSTRIDE + x * 4 + a] = 0xff;
+		}
+	}
+	ck_assert(bitmap_test_opaque(bmp) == true);
+
+	/* any other component being transparent is irrelevant */
+	buffer[(TEST_HEIGHT / 2) * TEST_ROWSTRIDE + r] = 0;
+	ck_assert(bitmap_test_opaque(bmp) == true);
+
+	/* a single translucent pixel in the last row and column */
+	buffer[(TEST_HEIGHT - 1) * TEST_ROWSTRIDE +
+			(TEST_WIDTH - 1) * 4 + a] = 0xfe;
+	ck_assert(bitmap_test_opaque(bmp) == false);
+
+	free(bmp);
+}
+END_TEST
+
+
+/* Throughput benchmark */
+
+/* The number of conversions each benchmark phase performs */
+#define BENCHMARK_ROUNDS 20000
+
+/**
+ * Report the pixel rate of a benchmark phase
+ */
+static void
+benchmark_report(const char *phase, clock_t conv_time, clock_t ref_time)
+{
+	double pixels = (double)TEST_WIDTH * TEST_HEIGHT * BENCHMARK_ROUNDS;
+	double conv_secs = (double)conv_time / CLOCKS_PER_SEC;
+	double ref_secs = (double)ref_time / CLOCKS_PER_SEC;
+
+	fprintf(stderr,
+		"bitmap %-8s %12.0f px/s reference %12.0f px/s\n",
+		phase,
+		(conv_secs > 0) ? pixels / conv_secs : 0,
+		(ref_secs > 0) ? pixels / ref_secs : 0);
+}
+
+/**
+ * Throughput of layout swaps and alpha conversions
+ *
+ * Each phase converts back and forth, so the alpha conversion phases
+ * time conversions both to and from premultiplied alpha.
+ */
+START_TEST(benchmark_throughput)
+{
+	static const struct {
+		const char *phase;
+		bitmap_fmt_t from;
+		bitmap_fmt_t to;
+	} phases[] = {
+		{
+			"swap",
+			{ .layout = BITMAP_LAYOUT_R8G8B8A8, .pma = false },
+			{ .layout = BITMAP_LAYOUT_B8G8R8A8, .pma = false },
+		},
+		{
+			"pma",
+			{ .layout = BITMAP_LAYOUT_R8G8B8A8, .pma = false },
+			{ .layout = BITMAP_LAYOUT_R8G8B8A8, .pma = true },
+		},
+		{
+			"swap-pma",
+			{ .layout = BITMAP_LAYOUT_R8G8B8A8, .pma = false },
+			{ .layout = BITMAP_LAYOUT_A8B8G8R8, .pma = true },
+		},
+	};
+	struct tst_bitmap *bmp, *ref;
+	clock_t start, conv_time, ref_time;
+	unsigned int phase;
+	int round;
+
+	bmp = calloc(1, sizeof(*bmp));
+	ref = calloc(1, sizeof(*ref));
+	ck_assert(bmp != NULL && ref != NULL);
+
+	for (phase = 0; phase < sizeof(phases) / sizeof(phases[0]); phase++) {
+		fill_bitmap(bmp, phase);
+		fill_bitmap(ref, phase);
+
+		start = clock();
+		for (round = 0; round < BENCHMARK_ROUNDS; round++) {
+			if (round & 1) {
+				bitmap_format_convert(bmp, &phases[phase].to,
+						&phases[phase].from);
+			} else {
+				bitmap_format_convert(bmp, &phases[phase].from,
+						&phases[phase].to);
+			}
+		}
+		conv_time = clock() - start;
+
+		start = clock();
+		for (round = 0; round < BENCHMARK_ROUNDS; round++) {
+			if (round & 1) {
+				reference_convert(ref, &phases[phase].to,
+						&phases[phase].from);
+			} else {
+				reference_convert(ref, &phases[phase].from,
+						&phases[phase].to);
+			}
+		}
+		ref_time = clock() - start;
+
+		benchmark_report(phases[phase].phase, conv_time, ref_time);
+
+		ck_assert(memcmp(bmp->buffer, ref->buffer,
+				sizeof(bmp->buffer)) == 0);
+	}
+
+	free(bmp);
+	free(ref);
+}
+END_TEST
+
+
+/**
+ * Conversion test case
+ */
+static TCase *bitmap_convert_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Conversion");
+
+	tcase_add_loop_test(tc, bitmap_format_convert_test,
+			0, NUM_LAYOUTS * NUM_LAYOUTS * 4);
+	tcase_add_test(tc, bitmap_format_convert_from_pma_test);
+	tcase_add_loop_test(tc, bitmap_test_opaque_test,
+			0, NUM_LAYOUTS);
+
+	return tc;
+}
+
+/**
+ * Benchmark test case
+ */
+static TCase *bitmap_benchmark_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Benchmark");
+
+	tcase_add_test(tc, benchmark_throughput);
+
+	return tc;
+}
+
+
+static Suite *bitmap_suite(void)
+{
+	Suite *s;
+	s = suite_create("Bitmap");
+
+	suite_add_tcase(s, bitmap_convert_case_create());
+	suite_add_tcase(s, bitmap_benchmark_case_create());
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	guit = &tst_table;
+
+	s = bitmap_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
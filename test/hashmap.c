@@ -33,6 +33,7 @@
 #include <string.h>
 #include <check.h>
 #include <limits.h>
+#include <time.h>
 
 #include <libwapcaplet/libwapcaplet.h>
 
@@ -477,7 +478,7 @@ START_TEST(chain_add_all_twice_remove_all_iterate)
 }
 END_TEST
 
-#define CHAIN_TEST_MALLOC_COUNT_MAX 60
+#define CHAIN_TEST_MALLOC_COUNT_MAX 48
 
 START_TEST(chain_add_all_remove_all_alloc)
 {
@@ -541,6 +542,468 @@ static TCase *chain_case_create(void)
 	return tc;
 }
 
+/* Growth and iteration test suite */
+
+/* The number of keys used to force several table growths */
+#define GROWTH_KEY_COUNT 5000
+
+static nsurl *growth_keys[GROWTH_KEY_COUNT];
+
+static uint32_t
+growth_key_hash(void *key)
+{
+	return nsurl_hash((nsurl *)key);
+}
+
+static hashmap_parameters_t growth_params = {
+	.key_clone = key_clone,
+	.key_hash = growth_key_hash,
+	.key_eq = key_eq,
+	.key_destroy = key_destroy,
+	.value_alloc = value_alloc,
+	.value_destroy = value_destroy,
+};
+
+static void
+growth_fixture_create(void)
+{
+	char url[64];
+	int idx;
+
+	corestring_create();
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		snprintf(url, sizeof(url),
+			 "http://host%d.example.com/path/%d.html",
+			 idx % 97, idx);
+		ck_assert(nsurl_create(url, &growth_keys[idx]) == NSERROR_OK);
+	}
+
+	test_hashmap = hashmap_create(&growth_params);
+
+	ck_assert(test_hashmap != NULL);
+	ck_assert_int_eq(keys, 0);
+	ck_assert_int_eq(values, 0);
+}
+
+static void
+growth_fixture_teardown(void)
+{
+	int idx;
+
+	hashmap_destroy(test_hashmap);
+	test_hashmap = NULL;
+
+	ck_assert_int_eq(keys, 0);
+	ck_assert_int_eq(values, 0);
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		nsurl_unref(growth_keys[idx]);
+		growth_keys[idx] = NULL;
+	}
+
+	corestring_teardown();
+}
+
+START_TEST(growth_insert_lookup_all)
+{
+	hashmap_test_value_t *value;
+	int idx;
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		value = hashmap_insert(test_hashmap, growth_keys[idx]);
+		ck_assert(value != NULL);
+		ck_assert(value->key == growth_keys[idx]);
+	}
+
+	ck_assert_int_eq(hashmap_count(test_hashmap), GROWTH_KEY_COUNT);
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		value = hashmap_lookup(test_hashmap, growth_keys[idx]);
+		ck_assert(value != NULL);
+		ck_assert(value->key == growth_keys[idx]);
+	}
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx += 2) {
+		ck_assert(hashmap_remove(test_hashmap, growth_keys[idx]) == true);
+	}
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		value = hashmap_lookup(test_hashmap, growth_keys[idx]);
+		ck_assert((value == NULL) == ((idx & 1) == 0));
+	}
+
+	iteration_counter = 0;
+	iteration_stop = 0;
+	ck_assert(hashmap_iterate(test_hashmap, hashmap_test_iterator_cb, &iteration_ctx) == false);
+	ck_assert_int_eq(iteration_counter, GROWTH_KEY_COUNT / 2);
+
+	for (idx = 1; idx < GROWTH_KEY_COUNT; idx += 2) {
+		ck_assert(hashmap_remove(test_hashmap, growth_keys[idx]) == true);
+	}
+
+	ck_assert_int_eq(hashmap_count(test_hashmap), 0);
+	ck_assert_int_eq(keys, 0);
+	ck_assert_int_eq(values, 0);
+}
+END_TEST
+
+/**
+ * Iterator which removes every entry it is passed
+ */
+static bool
+hashmap_test_remove_iterator_cb(void *key, void *value, void *ctx)
+{
+	hashmap_t *hashmap = ctx;
+	iteration_counter++;
+	ck_assert(hashmap_remove(hashmap, key) == true);
+	return false;
+}
+
+/* The number of times each growth key has been iterated over */
+static int growth_visits[GROWTH_KEY_COUNT];
+
+/**
+ * Iterator which removes the entry for the next key
+ */
+static bool
+hashmap_test_remove_other_iterator_cb(void *key, void *value, void *ctx)
+{
+	hashmap_t *hashmap = ctx;
+	int idx;
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		if (growth_keys[idx] == key) {
+			growth_visits[idx]++;
+			hashmap_remove(hashmap,
+				growth_keys[(idx + 1) % GROWTH_KEY_COUNT]);
+			break;
+		}
+	}
+	return false;
+}
+
+START_TEST(growth_iterate_remove)
+{
+	int idx;
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		ck_assert(hashmap_insert(test_hashmap, growth_keys[idx]) != NULL);
+	}
+
+	iteration_counter = 0;
+	ck_assert(hashmap_iterate(test_hashmap,
+				  hashmap_test_remove_iterator_cb,
+				  test_hashmap) == false);
+	ck_assert_int_eq(iteration_counter, GROWTH_KEY_COUNT);
+	ck_assert_int_eq(hashmap_count(test_hashmap), 0);
+	ck_assert_int_eq(keys, 0);
+	ck_assert_int_eq(values, 0);
+
+	/* map must remain usable once the removals are cleared up */
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		ck_assert(hashmap_insert(test_hashmap, growth_keys[idx]) != NULL);
+	}
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		ck_assert(hashmap_lookup(test_hashmap, growth_keys[idx]) != NULL);
+	}
+
+	/* removing entries other than the current one never causes a
+	 * remaining entry to be skipped or visited twice
+	 */
+	memset(growth_visits, 0, sizeof(growth_visits));
+	ck_assert(hashmap_iterate(test_hashmap,
+				  hashmap_test_remove_other_iterator_cb,
+				  test_hashmap) == false);
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		ck_assert(growth_visits[idx] <= 1);
+		if (hashmap_lookup(test_hashmap, growth_keys[idx]) != NULL) {
+			ck_assert_int_eq(growth_visits[idx], 1);
+		}
+	}
+	ck_assert(hashmap_count(test_hashmap) > 0);
+	ck_assert_int_eq(hashmap_count(test_hashmap), keys);
+	ck_assert_int_eq(hashmap_count(test_hashmap), values);
+
+	iteration_counter = 0;
+	iteration_stop = 0;
+	ck_assert(hashmap_iterate(test_hashmap, hashmap_test_iterator_cb, &iteration_ctx) == false);
+	ck_assert_int_eq(iteration_counter, hashmap_count(test_hashmap));
+}
+END_TEST
+
+#define GROWTH_TEST_MALLOC_COUNT_MAX 40
+
+START_TEST(growth_insert_alloc)
+{
+	int idx;
+	size_t inserted = 0;
+
+	malloc_limit(_i);
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		if (hashmap_insert(test_hashmap, growth_keys[idx]) != NULL) {
+			inserted++;
+		}
+	}
+
+	malloc_limit(UINT_MAX);
+
+	ck_assert_int_eq(hashmap_count(test_hashmap), inserted);
+	ck_assert_int_eq(keys, inserted);
+	ck_assert_int_eq(values, inserted);
+
+	for (idx = 0; idx < GROWTH_KEY_COUNT; idx++) {
+		hashmap_remove(test_hashmap, growth_keys[idx]);
+	}
+
+	ck_assert_int_eq(hashmap_count(test_hashmap), 0);
+	ck_assert_int_eq(keys, 0);
+	ck_assert_int_eq(values, 0);
+}
+END_TEST
+
+static TCase *growth_case_create(void)
+{
+	TCase *tc;
+	tc = tcase_create("Growth and iteration tests");
+
+	tcase_add_unchecked_fixture(tc,
+				    growth_fixture_create,
+				    growth_fixture_teardown);
+
+	tcase_add_test(tc, growth_insert_lookup_all);
+	tcase_add_test(tc, growth_iterate_remove);
+	tcase_add_loop_test(tc, growth_insert_alloc, 0, GROWTH_TEST_MALLOC_COUNT_MAX + 1);
+
+	return tc;
+}
+
+/* Throughput benchmark */
+
+/* The number of rounds of operations each benchmark phase performs */
+#define BENCHMARK_ROUNDS 4
+
+/* The number of keys used in the benchmark, a large cache's worth */
+#define BENCHMARK_KEY_COUNT 50000
+
+static nsurl *benchmark_keys[BENCHMARK_KEY_COUNT];
+
+static void
+benchmark_fixture_create(void)
+{
+	char url[64];
+	int idx;
+
+	corestring_create();
+
+	for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+		snprintf(url, sizeof(url),
+			 "http://host%d.example.com/path/%d.html",
+			 idx % 97, idx);
+		ck_assert(nsurl_create(url, &benchmark_keys[idx]) == NSERROR_OK);
+	}
+
+	test_hashmap = hashmap_create(&growth_params);
+
+	ck_assert(test_hashmap != NULL);
+}
+
+static void
+benchmark_fixture_teardown(void)
+{
+	int idx;
+
+	hashmap_destroy(test_hashmap);
+	test_hashmap = NULL;
+
+	for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+		nsurl_unref(benchmark_keys[idx]);
+		benchmark_keys[idx] = NULL;
+	}
+
+	corestring_teardown();
+}
+
+/**
+ * Reference fixed bucket chained hashmap.
+ *
+ * This is the implementation the open addressed hashmap replaced and
+ * is only retained to compare throughput against.
+ */
+#define REFERENCE_BUCKETS (4091)
+
+typedef struct reference_entry_s {
+	struct reference_entry_s *next;
+	void *key;
+	void *value;
+	uint32_t key_hash;
+} reference_entry_t;
+
+typedef struct {
+	hashmap_parameters_t *params;
+	reference_entry_t *buckets[REFERENCE_BUCKETS];
+} reference_map_t;
+
+static void *
+reference_lookup(reference_map_t *map, void *key)
+{
+	uint32_t hash = map->params->key_hash(key);
+	reference_entry_t *entry = map->buckets[hash % REFERENCE_BUCKETS];
+
+	for (; entry != NULL; entry = entry->next) {
+		if ((entry->key_hash == hash) &&
+		    map->params->key_eq(key, entry->key)) {
+			return entry->value;
+		}
+	}
+	return NULL;
+}
+
+static void *
+reference_insert(reference_map_t *map, void *key)
+{
+	uint32_t hash = map->params->key_hash(key);
+	reference_entry_t **bucket = &map->buckets[hash % REFERENCE_BUCKETS];
+	reference_entry_t *entry;
+
+	for (entry = *bucket; entry != NULL; entry = entry->next) {
+		if ((entry->key_hash == hash) &&
+		    map->params->key_eq(key, entry->key)) {
+			map->params->value_destroy(entry->value);
+			entry->value = map->params->value_alloc(entry->key);
+			return entry->value;
+		}
+	}
+
+	entry = malloc(sizeof(*entry));
+	ck_assert(entry != NULL);
+	entry->key = map->params->key_clone(key);
+	entry->value = map->params->value_alloc(entry->key);
+	entry->key_hash = hash;
+	entry->next = *bucket;
+	*bucket = entry;
+
+	return entry->value;
+}
+
+static bool
+reference_remove(reference_map_t *map, void *key)
+{
+	uint32_t hash = map->params->key_hash(key);
+	reference_entry_t **prevptr = &map->buckets[hash % REFERENCE_BUCKETS];
+	reference_entry_t *entry;
+
+	for (; (entry = *prevptr) != NULL; prevptr = &entry->next) {
+		if ((entry->key_hash == hash) &&
+		    map->params->key_eq(key, entry->key)) {
+			*prevptr = entry->next;
+			map->params->value_destroy(entry->value);
+			map->params->key_destroy(entry->key);
+			free(entry);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Report the operation rate of a benchmark phase
+ */
+static void
+benchmark_report(const char *phase, clock_t hm_time, clock_t ref_time)
+{
+	double ops = (double)BENCHMARK_KEY_COUNT * BENCHMARK_ROUNDS;
+	double hm_secs = (double)hm_time / CLOCKS_PER_SEC;
+	double ref_secs = (double)ref_time / CLOCKS_PER_SEC;
+
+	fprintf(stderr,
+		"hashmap %-6s %10.0f ops/s reference %10.0f ops/s\n",
+		phase,
+		(hm_secs > 0) ? ops / hm_secs : 0,
+		(ref_secs > 0) ? ops / ref_secs : 0);
+}
+
+START_TEST(benchmark_throughput)
+{
+	reference_map_t *ref;
+	clock_t start, hm_insert, hm_lookup, hm_remove;
+	clock_t ref_insert, ref_lookup, ref_remove;
+	int round;
+	int idx;
+
+	ref = malloc(sizeof(*ref));
+	ck_assert(ref != NULL);
+	memset(ref, 0, sizeof(*ref));
+	ref->params = &growth_params;
+
+	hm_insert = hm_lookup = hm_remove = 0;
+	ref_insert = ref_lookup = ref_remove = 0;
+
+	for (round = 0; round < BENCHMARK_ROUNDS; round++) {
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			hashmap_insert(test_hashmap, benchmark_keys[idx]);
+		}
+		hm_insert += clock() - start;
+
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			ck_assert(hashmap_lookup(test_hashmap,
+						 benchmark_keys[idx]) != NULL);
+		}
+		hm_lookup += clock() - start;
+
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			hashmap_remove(test_hashmap, benchmark_keys[idx]);
+		}
+		hm_remove += clock() - start;
+
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			reference_insert(ref, benchmark_keys[idx]);
+		}
+		ref_insert += clock() - start;
+
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			ck_assert(reference_lookup(ref,
+						   benchmark_keys[idx]) != NULL);
+		}
+		ref_lookup += clock() - start;
+
+		start = clock();
+		for (idx = 0; idx < BENCHMARK_KEY_COUNT; idx++) {
+			reference_remove(ref, benchmark_keys[idx]);
+		}
+		ref_remove += clock() - start;
+	}
+
+	benchmark_report("insert", hm_insert, ref_insert);
+	benchmark_report("lookup", hm_lookup, ref_lookup);
+	benchmark_report("remove", hm_remove, ref_remove);
+
+	free(ref);
+
+	ck_assert_int_eq(hashmap_count(test_hashmap), 0);
+}
+END_TEST
+
+static TCase *benchmark_case_create(void)
+{
+	TCase *tc;
+	tc = tcase_create("Benchmark");
+
+	tcase_add_unchecked_fixture(tc,
+				    benchmark_fixture_create,
+				    benchmark_fixture_teardown);
+
+	tcase_add_test(tc, benchmark_throughput);
+
+	return tc;
+}
+
 /*
  * hashmap test suite creation
  */
@@ -551,6 +1014,8 @@ static Suite *hashmap_suite_create(void)
 
 	suite_add_tcase(s, basic_api_case_create());
 	suite_add_tcase(s, chain_case_create());
+	suite_add_tcase(s, growth_case_create());
+	suite_add_tcase(s, benchmark_case_create());
 
 	return s;
 }
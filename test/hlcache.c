@@ -0,0 +1,510 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test high level cache retention of unused contents.
+ *
+ * The low level cache and the content handlers are replaced by mocks, so
+ * that the contents the high level cache keeps, reuses and destroys can
+ * be observed directly.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include "utils/errors.h"
+#include "utils/corestrings.h"
+#include "utils/nsurl.h"
+#include "utils/messages.h"
+#include "netsurf/misc.h"
+#include "netsurf/content.h"
+#include "content/llcache.h"
+#include "content/hlcache.h"
+#include "content/mimesniff.h"
+#include "content/content_protected.h"
+#include "content/content_factory.h"
+#include "desktop/gui_internal.h"
+
+/** Low level cache size limit the tests run with */
+#define TEST_LLCACHE_LIMIT (64 * 1024)
+
+/** Size of the mock contents which are not oversized */
+#define TEST_CONTENT_SIZE 1024
+
+struct netsurf_table *guit = NULL;
+
+/** Background clean scheduled by the high level cache */
+static void (*test_clean_cb)(void *p);
+
+/** Number of mock contents created */
+static unsigned int test_created;
+
+/** Number of mock contents destroyed */
+static unsigned int test_destroyed;
+
+/** Mock low level cache handle */
+struct llcache_handle {
+	nsurl *url;
+	llcache_handle_callback cb;
+	void *pw;
+};
+
+/** Low level handle whose headers have yet to be delivered */
+static llcache_handle *test_pending;
+
+/** Mock content */
+struct test_content {
+	struct content base;
+	content_type type;
+	uint32_t users;
+};
+
+
+/* mock gui interface */
+
+static nserror test_schedule(int t, void (*callback)(void *p), void *p)
+{
+	test_clean_cb = (t < 0) ? NULL : callback;
+	return NSERROR_OK;
+}
+
+static struct gui_misc_table test_misc_table = {
+	.schedule = test_schedule,
+};
+
+static struct netsurf_table test_table = {
+	.misc = &test_misc_table,
+};
+
+
+/* mock low level cache */
+
+nserror llcache_initialise(const struct llcache_parameters *parameters)
+{
+	return NSERROR_OK;
+}
+
+void llcache_finalise(void)
+{
+}
+
+void llcache_clean(bool purge)
+{
+}
+
+nserror llcache_handle_retrieve(nsurl *url, uint32_t flags,
+		nsurl *referer, const llcache_post_data *post,
+		llcache_handle_callback cb, void *pw,
+		llcache_handle **result)
+{
+	llcache_handle *handle;
+
+	handle = calloc(1, sizeof(*handle));
+	if (handle == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	handle->url = nsurl_ref(url);
+	handle->cb = cb;
+	handle->pw = pw;
+
+	test_pending = handle;
+	*result = handle;
+
+	return NSERROR_OK;
+}
+
+nserror llcache_handle_release(llcache_handle *handle)
+{
+	nsurl_unref(handle->url);
+	free(handle);
+	return NSERROR_OK;
+}
+
+nserror llcache_handle_abort(llcache_handle *handle)
+{
+	return NSERROR_OK;
+}
+
+nserror llcache_handle_force_stream(llcache_handle *handle)
+{
+	return NSERROR_OK;
+}
+
+nsurl *llcache_handle_get_url(const llcache_handle *handle)
+{
+	return handle->url;
+}
+
+const char *llcache_handle_get_header(const llcache_handle *handle,
+		const char *key)
+{
+	const char *path = nsurl_access(handle->url);
+	size_t len = strlen(path);
+
+	if (len > 4 && strcmp(path + len - 4, ".css") == 0) {
+		return "text/css";
+	}
+
+	return "image/png";
+}
+
+bool llcache_handle_references_same_object(const llcache_handle *a,
+		const llcache_handle *b)
+{
+	return nsurl_compare(a->url, b->url, NSURL_COMPLETE);
+}
+
+
+/* mock content handling */
+
+nserror mimesniff_compute_effective_type(const char *content_type_header,
+		const uint8_t *data, size_t len, bool sniff_allowed,
+		bool image_only, lwc_string **effective_type)
+{
+	if (lwc_intern_string(content_type_header,
+			strlen(content_type_header),
+			effective_type) != lwc_error_ok) {
+		return NSERROR_NOMEM;
+	}
+
+	return NSERROR_OK;
+}
+
+content_type content_factory_type_from_mime_type(lwc_string *mime_type)
+{
+	if (strcmp(lwc_string_data(mime_type), "text/css") == 0) {
+		return CONTENT_CSS;
+	}
+
+	return CONTENT_IMAGE;
+}
+
+struct content *content_factory_create_content(struct llcache_handle *llcache,
+		const char *fallback_charset, bool quirks,
+		lwc_string *effective_type)
+{
+	struct test_content *c;
+
+	c = calloc(1, sizeof(*c));
+	if (c == NULL) {
+		return NULL;
+	}
+
+	/* the content is complete as soon as it is created */
+	c->base.llcache = llcache;
+	c->base.status = CONTENT_STATUS_DONE;
+	c->base.size = TEST_CONTENT_SIZE;
+	if (strstr(nsurl_access(llcache->url), "large") != NULL) {
+		c->base.size = TEST_LLCACHE_LIMIT;
+	}
+	c->type = content_factory_type_from_mime_type(effective_type);
+
+	test_created++;
+
+	return &c->base;
+}
+
+void content_destroy(struct content *c)
+{
+	llcache_handle_release(c->llcache);
+	free(c);
+
+	test_destroyed++;
+}
+
+bool content_add_user(struct content *c,
+		void (*callback)(struct content *c, content_msg msg,
+				const union content_msg_data *data, void *pw),
+		void *pw)
+{
+	((struct test_content *) c)->users++;
+	return true;
+}
+
+void content_remove_user(struct content *c,
+		void (*callback)(struct content *c, content_msg msg,
+				const union content_msg_data *data, void *pw),
+		void *pw)
+{
+	((struct test_content *) c)->users--;
+}
+
+uint32_t content_count_users(struct content *c)
+{
+	return ((struct test_content *) c)->users;
+}
+
+content_type content_get_type(struct hlcache_handle *h)
+{
+	struct content *c = hlcache_handle_get_content(h);
+
+	return ((struct test_content *) c)->type;
+}
+
+content_status content__get_status(struct content *c)
+{
+	return c->status;
+}
+
+content_status content_get_status(struct hlcache_handle *h)
+{
+	return content__get_status(hlcache_handle_get_content(h));
+}
+
+const struct llcache_handle *content_get_llcache_handle(struct content *c)
+{
+	return c->llcache;
+}
+
+struct nsurl *content_get_url(struct content *c)
+{
+	return c->llcache->url;
+}
+
+bool content_is_shareable(struct content *c)
+{
+	return true;
+}
+
+bool content_matches_quirks(struct content *c, bool quirks)
+{
+	return true;
+}
+
+struct content *content_clone(struct content *c)
+{
+	return NULL;
+}
+
+nserror content_abort(struct content *c)
+{
+	return NSERROR_OK;
+}
+
+void content_set_error(struct content *c)
+{
+	c->status = CONTENT_STATUS_ERROR;
+}
+
+const char *messages_get(const char *key)
+{
+	return key;
+}
+
+
+/* helpers */
+
+static nserror test_hlcache_cb(hlcache_handle *handle,
+		const hlcache_event *event, void *pw)
+{
+	return NSERROR_OK;
+}
+
+/**
+ * Fetch a URL through the high level cache until it has a content
+ */
+static hlcache_handle *test_fetch(const char *url_str)
+{
+	llcache_event event = {
+		.type = LLCACHE_EVENT_HAD_HEADERS,
+	};
+	llcache_handle *llcache;
+	hlcache_handle *handle;
+	nsurl *url;
+	nserror res;
+
+	res = nsurl_create(url_str, &url);
+	ck_assert_int_eq(res, NSERROR_OK);
+
+	res = hlcache_handle_retrieve(url, 0, NULL, NULL,
+			test_hlcache_cb, NULL, NULL, CONTENT_ANY, &handle);
+	ck_assert_int_eq(res, NSERROR_OK);
+	nsurl_unref(url);
+
+	/* deliver the headers once the retrieval is under way */
+	llcache = test_pending;
+	test_pending = NULL;
+	ck_assert(llcache != NULL);
+	res = llcache->cb(llcache, &event, llcache->pw);
+	ck_assert_int_eq(res, NSERROR_OK);
+
+	ck_assert(hlcache_handle_get_content(handle) != NULL);
+
+	return handle;
+}
+
+/**
+ * Run a background clean of the high level cache
+ */
+static void test_clean(void)
+{
+	ck_assert(test_clean_cb != NULL);
+	test_clean_cb(NULL);
+}
+
+
+/* Fixtures */
+
+static void hlcache_create(void)
+{
+	const struct hlcache_parameters params = {
+		.bg_clean_time = 5000,
+		.llcache = {
+			.limit = TEST_LLCACHE_LIMIT,
+		},
+	};
+	nserror res;
+
+	guit = &test_table;
+
+	res = corestrings_init();
+	ck_assert_int_eq(res, NSERROR_OK);
+
+	test_created = 0;
+	test_destroyed = 0;
+
+	res = hlcache_initialise(&params);
+	ck_assert_int_eq(res, NSERROR_OK);
+}
+
+static void hlcache_teardown(void)
+{
+	/* finalising discards every kept content */
+	hlcache_finalise();
+	ck_assert_int_eq(test_destroyed, test_created);
+
+	corestrings_fini();
+}
+
+
+/* Tests */
+
+/**
+ * A fresh stylesheet fetched again after it was released is the same
+ * content
+ */
+START_TEST(hlcache_retain_css_test)
+{
+	hlcache_handle *handle;
+	struct content *c;
+
+	handle = test_fetch("http://example.com/site.css");
+	c = hlcache_handle_get_content(handle);
+	hlcache_handle_release(handle);
+
+	test_clean();
+	ck_assert_int_eq(test_destroyed, 0);
+
+	handle = test_fetch("http://example.com/site.css");
+	ck_assert(hlcache_handle_get_content(handle) == c);
+	ck_assert_int_eq(test_created, 1);
+	hlcache_handle_release(handle);
+}
+END_TEST
+
+/**
+ * Other contents are destroyed as soon as they are unused
+ */
+START_TEST(hlcache_retain_image_test)
+{
+	hlcache_handle *handle;
+
+	handle = test_fetch("http://example.com/logo.png");
+	hlcache_handle_release(handle);
+
+	test_clean();
+	ck_assert_int_eq(test_destroyed, 1);
+
+	handle = test_fetch("http://example.com/logo.png");
+	ck_assert_int_eq(test_created, 2);
+	hlcache_handle_release(handle);
+}
+END_TEST
+
+/**
+ * Stylesheets too large for the space set aside are not kept
+ */
+START_TEST(hlcache_retain_large_css_test)
+{
+	hlcache_handle *handle;
+
+	handle = test_fetch("http://example.com/large.css");
+	hlcache_handle_release(handle);
+
+	test_clean();
+	ck_assert_int_eq(test_destroyed, 1);
+}
+END_TEST
+
+/**
+ * Stylesheets from other URLs are not reused
+ */
+START_TEST(hlcache_retain_other_css_test)
+{
+	hlcache_handle *handle;
+
+	handle = test_fetch("http://example.com/site.css");
+	hlcache_handle_release(handle);
+
+	test_clean();
+
+	handle = test_fetch("http://example.com/print.css");
+	ck_assert_int_eq(test_created, 2);
+	hlcache_handle_release(handle);
+}
+END_TEST
+
+
+static Suite *hlcache_suite(void)
+{
+	Suite *s;
+	TCase *tc_retain;
+
+	s = suite_create("hlcache");
+
+	tc_retain = tcase_create("Retention");
+	tcase_add_checked_fixture(tc_retain,
+				  hlcache_create,
+				  hlcache_teardown);
+
+	tcase_add_test(tc_retain, hlcache_retain_css_test);
+	tcase_add_test(tc_retain, hlcache_retain_image_test);
+	tcase_add_test(tc_retain, hlcache_retain_large_css_test);
+	tcase_add_test(tc_retain, hlcache_retain_other_css_test);
+
+	suite_add_tcase(s, tc_retain);
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	SRunner *sr;
+
+	sr = srunner_create(hlcache_suite());
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/python3
+#
+# Copyright 2026 The NetSurf Browser Project
+#
+# This file is part of NetSurf, http://www.netsurf-browser.org/
+#
+# NetSurf is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# NetSurf is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+writes a page holding a huge table with collapsed borders
+
+The table has 1000 rows of 100 cells with a spanning cell on every
+seventh row, written out statically so that layout is timed without
+any script running.
+
+  python3 test/table/huge-collapsed.py > huge-collapsed.html
+
+Time layout by running with logging enabled and reading the duration
+reported for the reformat of the page.
+"""
+
+import sys
+
+ROWS = 1000
+COLS = 100
+
+HEAD = """<html>
+<head>
+<title>Huge collapsed border table</title>
+<style>
+table {
+	border-collapse: collapse;
+	border: 3px double black;
+}
+td {
+	border: 1px solid gray;
+	padding: 1px 3px;
+}
+td.wide {
+	border: 2px dashed blue;
+}
+tr.odd td {
+	border-bottom: 2px solid green;
+}
+</style>
+</head>
+<body>
+<table>
+"""
+
+TAIL = """</table>
+</body>
+</html>
+"""
+
+
+def row(r):
+    """returns the markup for one table row"""
+    cells = ["<tr class=odd>" if r % 2 else "<tr>"]
+    c = 0
+    while c < COLS:
+        if r % 7 == 0 and c % 10 == 0:
+            cells.append("<td class=wide colspan=5>{},{}".format(r, c))
+            c += 5
+        else:
+            cells.append("<td>{}".format(c))
+            c += 1
+    return "".join(cells) + "\n"
+
+
+def main():
+    out = sys.stdout
+    out.write(HEAD)
+    for r in range(ROWS):
+        out.write(row(r))
+    out.write(TAIL)
+
+
+if __name__ == "__main__":
+    main()
@@ -902,8 +902,11 @@ START_TEST(urldb_update_visit_test)
 
 	urldb_add_url(url);
 
+	urldb_reset_url_visit_data(url);
+	ck_assert(urldb_get_url_visited(url) == false);
+
 	urldb_update_url_visit_data(url);
-	/** \todo test needs to check results */
+	ck_assert(urldb_get_url_visited(url) == true);
 
 	nsurl_unref(url);
 }
@@ -919,8 +922,11 @@ START_TEST(urldb_reset_visit_test)
 
 	urldb_add_url(url);
 
+	urldb_update_url_visit_data(url);
+	ck_assert(urldb_get_url_visited(url) == true);
+
 	urldb_reset_url_visit_data(url);
-	/** \todo test needs to check results */
+	ck_assert(urldb_get_url_visited(url) == false);
 
 	nsurl_unref(url);
 }
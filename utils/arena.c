@@ -0,0 +1,214 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Bump pointer region allocator implementation.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/arena.h"
+
+/** Default size of arena blocks */
+#define ARENA_DEFAULT_BLOCK_SIZE (16 * 1024)
+
+/** Alignment of every allocation */
+#define ARENA_ALIGN (sizeof(void *) > sizeof(double) ? \
+		sizeof(void *) : sizeof(double))
+
+/**
+ * A block of memory allocations are carved from.
+ */
+struct arena_block {
+	struct arena_block *next; /**< Previously filled block */
+	size_t size; /**< Usable bytes in data */
+	size_t used; /**< Bytes already handed out */
+	/** Start of allocatable space, aligned for any basic type */
+	union {
+		void *p;
+		double d;
+		long long ll;
+	} data[];
+};
+
+/**
+ * Region allocator state.
+ */
+struct arena {
+	struct arena_block *current; /**< Block being allocated from */
+	size_t block_size; /**< Size of normal blocks */
+	size_t used; /**< Total bytes handed out */
+	size_t allocated; /**< Total bytes obtained from malloc */
+};
+
+
+/**
+ * Allocate a new block and link it into an arena.
+ *
+ * Oversized blocks are linked behind the current block so the space
+ * remaining in the current block is not abandoned.
+ *
+ * \param arena The arena to add the block to.
+ * \param size The minimum usable size of the block.
+ * \return The new block or NULL on memory exhaustion.
+ */
+static struct arena_block *arena_block_add(struct arena *arena, size_t size)
+{
+	struct arena_block *block;
+	bool oversize = false;
+
+	if (size < arena->block_size) {
+		size = arena->block_size;
+	} else {
+		oversize = true;
+	}
+
+	block = malloc(sizeof(*block) + size);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->size = size;
+	block->used = 0;
+	arena->allocated += sizeof(*block) + size;
+
+	if (oversize && arena->current != NULL) {
+		block->next = arena->current->next;
+		arena->current->next = block;
+	} else {
+		block->next = arena->current;
+		arena->current = block;
+	}
+
+	return block;
+}
+
+
+/* exported interface documented in utils/arena.h */
+nserror arena_create(size_t block_size, struct arena **arena_out)
+{
+	struct arena *arena;
+
+	arena = malloc(sizeof(*arena));
+	if (arena == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	if (block_size == 0) {
+		block_size = ARENA_DEFAULT_BLOCK_SIZE;
+	}
+
+	arena->current = NULL;
+	arena->block_size = block_size;
+	arena->used = 0;
+	arena->allocated = sizeof(*arena);
+
+	*arena_out = arena;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in utils/arena.h */
+void arena_destroy(struct arena *arena)
+{
+	struct arena_block *block;
+
+	if (arena == NULL) {
+		return;
+	}
+
+	while (arena->current != NULL) {
+		block = arena->current;
+		arena->current = block->next;
+		free(block);
+	}
+
+	free(arena);
+}
+
+
+/* exported interface documented in utils/arena.h */
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *block = arena->current;
+	void *ptr;
+
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	if (size == 0) {
+		size = ARENA_ALIGN;
+	}
+
+	if (block == NULL || block->size - block->used < size) {
+		block = arena_block_add(arena, size);
+		if (block == NULL) {
+			return NULL;
+		}
+	}
+
+	ptr = (char *)block->data + block->used;
+	block->used += size;
+	arena->used += size;
+
+	return ptr;
+}
+
+
+/* exported interface documented in utils/arena.h */
+char *arena_strndup(struct arena *arena, const char *s, size_t len)
+{
+	const char *end;
+	char *copy;
+
+	end = memchr(s, '\0', len);
+	if (end != NULL) {
+		len = end - s;
+	}
+
+	copy = arena_alloc(arena, len + 1);
+	if (copy == NULL) {
+		return NULL;
+	}
+
+	memcpy(copy, s, len);
+	copy[len] = '\0';
+
+	return copy;
+}
+
+
+/* exported interface documented in utils/arena.h */
+char *arena_strdup(struct arena *arena, const char *s)
+{
+	return arena_strndup(arena, s, strlen(s));
+}
+
+
+/* exported interface documented in utils/arena.h */
+void arena_stats(struct arena *arena, size_t *used, size_t *allocated)
+{
+	if (used != NULL) {
+		*used = arena->used;
+	}
+	if (allocated != NULL) {
+		*allocated = arena->allocated;
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Bump pointer region allocator interface.
+ *
+ * An arena hands out memory from large blocks by advancing a pointer.
+ * Individual allocations cannot be freed; everything allocated from
+ * an arena is released together when the arena is destroyed. This
+ * suits data such as box tree text whose lifetime is exactly that of
+ * the structure it belongs to.
+ */
+
+#ifndef NETSURF_UTILS_ARENA_H
+#define NETSURF_UTILS_ARENA_H
+
+#include <stddef.h>
+
+#include "utils/errors.h"
+
+struct arena;
+
+/**
+ * Create a new arena.
+ *
+ * \param block_size Size of the blocks memory is carved from, or zero
+ *                   for the default.
+ * \param arena_out Updated to the newly created arena on success.
+ * \return NSERROR_OK on success or NSERROR_NOMEM on allocation failure.
+ */
+nserror arena_create(size_t block_size, struct arena **arena_out);
+
+/**
+ * Destroy an arena, releasing every allocation made from it.
+ *
+ * \param arena The arena to destroy, may be NULL.
+ */
+void arena_destroy(struct arena *arena);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * The returned memory is suitably aligned for any basic type and is
+ * not initialised. Requests larger than the block size are satisfied
+ * with a dedicated block.
+ *
+ * \param arena The arena to allocate from.
+ * \param size The number of bytes required.
+ * \return Pointer to the allocation or NULL on memory exhaustion.
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * Duplicate at most len bytes of a string into an arena.
+ *
+ * The copy is always NUL terminated.
+ *
+ * \param arena The arena to allocate from.
+ * \param s The string to copy.
+ * \param len The maximum number of bytes to copy.
+ * \return The copy or NULL on memory exhaustion.
+ */
+char *arena_strndup(struct arena *arena, const char *s, size_t len);
+
+/**
+ * Duplicate a NUL terminated string into an arena.
+ *
+ * \param arena The arena to allocate from.
+ * \param s The string to copy.
+ * \return The copy or NULL on memory exhaustion.
+ */
+char *arena_strdup(struct arena *arena, const char *s);
+
+/**
+ * Obtain usage statistics for an arena.
+ *
+ * \param arena The arena to query.
+ * \param used Updated with the number of bytes handed out, may be NULL.
+ * \param allocated Updated with the number of bytes obtained from the
+ *                  system allocator, may be NULL.
+ */
+void arena_stats(struct arena *arena, size_t *used, size_t *allocated);
+
+#endif
@@ -175,6 +175,12 @@ char *realpath(const char *path, char *resolved_path);
 #define HAVE_EXECINFO
 #endif
 
+/* SSE2 vector instructions for bulk character classification; the
+ * scanning code also relies on the GCC/clang __builtin_ctz intrinsic */
+#if (defined(__SSE2__) && defined(__GNUC__))
+#define HAVE_SSE2
+#endif
+
 /* This section toggles build options on and off.
  * Simply undefine a symbol to turn the relevant feature off.
  *
@@ -245,6 +245,7 @@ CORESTRING_DOM_STRING(error);
 CORESTRING_DOM_STRING(Escape);
 CORESTRING_DOM_STRING(focus);
 CORESTRING_DOM_STRING(frameborder);
+CORESTRING_DOM_STRING(frameset);
 CORESTRING_DOM_STRING(hashchange);
 CORESTRING_DOM_STRING(height);
 CORESTRING_DOM_STRING(Home);
@@ -253,6 +254,7 @@ CORESTRING_DOM_STRING(hreflang);
 CORESTRING_DOM_STRING(hspace);
 /* http-equiv: see below */
 CORESTRING_DOM_STRING(id);
+CORESTRING_DOM_STRING(iframe);
 CORESTRING_DOM_STRING(input);
 CORESTRING_DOM_STRING(invalid);
 CORESTRING_DOM_STRING(keydown);
@@ -370,6 +372,7 @@ CORESTRING_DOM_STRING(__ns_key_file_name_node_data);
 CORESTRING_DOM_STRING(__ns_key_image_coords_node_data);
 CORESTRING_DOM_STRING(__ns_key_html_content_data);
 CORESTRING_DOM_STRING(__ns_key_canvas_node_data);
+CORESTRING_DOM_STRING(__ns_key_link_url_node_data);
 
 /* unusual DOM strings */
 CORESTRING_DOM_VALUE(text_javascript, "text/javascript");
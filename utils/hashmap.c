@@ -16,27 +16,72 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/**
+ * \file
+ * Generic hashmap implementation.
+ *
+ * The map is an open addressed table using Robin Hood linear probing.
+ * Every slot holds the key, value and key hash inline along with the
+ * distance of the entry from its home slot, so lookups touch a single
+ * contiguous run of memory and inserts only allocate when the table
+ * grows.
+ *
+ * When the table becomes too full a table of twice the size is
+ * allocated and the entries are moved across a few at a time by
+ * subsequent inserts and removals, so no single operation has to
+ * rehash the entire map. Lookups consult both tables while such a
+ * migration is in progress.
+ *
+ * Removals performed while the map is being iterated leave a marker
+ * in place of the entry rather than moving the following entries, so
+ * the iteration visits every remaining entry exactly once. The markers
+ * are cleared when the outermost iteration finishes.
+ */
+
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "utils/hashmap.h"
 
 /**
- * The default number of buckets in the hashmaps we create.
+ * The number of slots in the hashmaps we create, must be a power of two.
  */
-#define DEFAULT_HASHMAP_BUCKETS (4091)
+#define DEFAULT_HASHMAP_SLOTS (64)
 
 /**
- * Hashmaps have chains of entries in buckets.
+ * Maximum table load before growing, as a fraction of 256.
+ */
+#define HASHMAP_MAX_LOAD (224)
+
+/**
+ * The number of old table slots migrated by each mutating operation
+ * while the map is growing.
+ */
+#define HASHMAP_MIGRATE_SLOTS (16)
+
+/**
+ * Hashmap table slot.
+ *
+ * A distance of zero marks an empty slot. A slot with a non zero
+ * distance but no key is an entry removed during iteration.
  */
 typedef struct hashmap_entry_s {
-	struct hashmap_entry_s **prevptr;
-	struct hashmap_entry_s *next;
 	void *key;
 	void *value;
 	uint32_t key_hash;
+	uint32_t distance; /**< One plus the offset from the home slot */
 } hashmap_entry_t;
 
+/**
+ * A table of slots
+ */
+typedef struct hashmap_table_s {
+	hashmap_entry_t *slots;
+	uint32_t mask; /**< The number of slots minus one */
+	size_t count; /**< The number of occupied slots */
+} hashmap_table_t;
+
 /**
  * The content of a hashmap
  */
@@ -45,16 +90,32 @@ struct hashmap_s {
 	 * The parameters to be used for this hashmap
 	 */
 	hashmap_parameters_t *params;
-	
+
 	/**
-	 * The buckets for the hash chains
+	 * The table new entries are placed in
 	 */
-	hashmap_entry_t **buckets;
-	
+	hashmap_table_t table;
+
 	/**
-	 * The number of buckets in this map
+	 * The table being migrated from while growing, slots is NULL
+	 * when no migration is in progress.
 	 */
-	uint32_t bucket_count;
+	hashmap_table_t old;
+
+	/**
+	 * The next old table slot to migrate
+	 */
+	uint32_t migrate_slot;
+
+	/**
+	 * The depth of iterations currently in progress
+	 */
+	unsigned int iterating;
+
+	/**
+	 * The number of entries removed during iteration
+	 */
+	size_t removed_count;
 
 	/**
 	 * The number of entries in this map
@@ -62,6 +123,274 @@ struct hashmap_s {
 	size_t entry_count;
 };
 
+
+/**
+ * Allocate the slots for a table
+ *
+ * \param table The table to initialise
+ * \param slot_count The number of slots, must be a power of two
+ * \return true on success, false on allocation failure
+ */
+static bool
+hashmap__table_init(hashmap_table_t *table, uint32_t slot_count)
+{
+	table->slots = malloc(slot_count * sizeof(hashmap_entry_t));
+	if (table->slots == NULL) {
+		return false;
+	}
+
+	memset(table->slots, 0, slot_count * sizeof(hashmap_entry_t));
+	table->mask = slot_count - 1;
+	table->count = 0;
+
+	return true;
+}
+
+
+/**
+ * Compute the home slot of a key hash in a table
+ *
+ * Key hashes are often combinations of other hashes with poorly
+ * distributed low bits, so they are mixed before being masked.
+ *
+ * \param table The table to compute the slot in
+ * \param hash The key hash
+ * \return The index of the preferred slot for the hash
+ */
+static inline uint32_t
+hashmap__home_slot(hashmap_table_t *table, uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+
+	return hash & table->mask;
+}
+
+
+/**
+ * Find the slot holding a key in a table
+ *
+ * \param hashmap The hashmap the table belongs to
+ * \param table The table to search
+ * \param key The key to search for
+ * \param hash The hash of the key
+ * \return The slot holding the key or NULL if it is not present
+ */
+static hashmap_entry_t *
+hashmap__table_find(hashmap_t *hashmap,
+		    hashmap_table_t *table,
+		    void *key,
+		    uint32_t hash)
+{
+	uint32_t slot = hashmap__home_slot(table, hash);
+	uint32_t distance = 1;
+	hashmap_entry_t *entry;
+
+	if (table->slots == NULL) {
+		return NULL;
+	}
+
+	for (;;) {
+		entry = &table->slots[slot];
+
+		/* An entry closer to its home than we are to ours means
+		 * the key would have displaced it had it been present.
+		 */
+		if (entry->distance < distance) {
+			return NULL;
+		}
+
+		if ((entry->key_hash == hash) &&
+		    (entry->key != NULL) &&
+		    hashmap->params->key_eq(key, entry->key)) {
+			return entry;
+		}
+
+		slot = (slot + 1) & table->mask;
+		distance++;
+	}
+}
+
+
+/**
+ * Place an entry, known not to be present, into a table
+ *
+ * The table must have a free slot and hold no removed entry markers.
+ *
+ * \param table The table to place the entry in
+ * \param key The entry key
+ * \param value The entry value
+ * \param hash The hash of the key
+ */
+static void
+hashmap__table_place(hashmap_table_t *table,
+		     void *key,
+		     void *value,
+		     uint32_t hash)
+{
+	hashmap_entry_t carry = {
+		.key = key,
+		.value = value,
+		.key_hash = hash,
+		.distance = 1,
+	};
+	hashmap_entry_t swap;
+	uint32_t slot = hashmap__home_slot(table, hash);
+
+	assert(table->count <= table->mask);
+
+	for (;;) {
+		hashmap_entry_t *entry = &table->slots[slot];
+
+		if (entry->distance == 0) {
+			*entry = carry;
+			break;
+		}
+
+		/* Robin Hood: take the slot from an entry nearer home */
+		if (entry->distance < carry.distance) {
+			swap = *entry;
+			*entry = carry;
+			carry = swap;
+		}
+
+		slot = (slot + 1) & table->mask;
+		carry.distance++;
+	}
+
+	table->count++;
+}
+
+
+/**
+ * Empty a table slot, moving following displaced entries back
+ *
+ * \param table The table to remove from
+ * \param entry The slot to empty
+ */
+static void
+hashmap__table_erase(hashmap_table_t *table, hashmap_entry_t *entry)
+{
+	uint32_t slot = entry - table->slots;
+	uint32_t next = (slot + 1) & table->mask;
+
+	while (table->slots[next].distance > 1) {
+		table->slots[slot] = table->slots[next];
+		table->slots[slot].distance--;
+		slot = next;
+		next = (next + 1) & table->mask;
+	}
+
+	memset(&table->slots[slot], 0, sizeof(hashmap_entry_t));
+	table->count--;
+}
+
+
+/**
+ * Move entries from the old table to the current one
+ *
+ * \param hashmap The hashmap being grown
+ * \param slots The number of old table slots to process, zero for all
+ */
+static void
+hashmap__migrate(hashmap_t *hashmap, uint32_t slots)
+{
+	hashmap_table_t *old = &hashmap->old;
+
+	if ((old->slots == NULL) || (hashmap->iterating > 0)) {
+		return;
+	}
+
+	while (hashmap->migrate_slot <= old->mask) {
+		hashmap_entry_t *entry = &old->slots[hashmap->migrate_slot];
+
+		if (entry->distance != 0) {
+			hashmap__table_place(&hashmap->table,
+					     entry->key,
+					     entry->value,
+					     entry->key_hash);
+			/* erasing may move another entry into this slot */
+			hashmap__table_erase(old, entry);
+		} else {
+			hashmap->migrate_slot++;
+		}
+
+		if ((slots != 0) && (--slots == 0)) {
+			break;
+		}
+	}
+
+	if (old->count == 0) {
+		free(old->slots);
+		old->slots = NULL;
+	}
+}
+
+
+/**
+ * Ensure the current table has room for another entry
+ *
+ * \param hashmap The hashmap to check
+ * \return true if an entry can be placed, false on allocation failure
+ */
+static bool
+hashmap__reserve(hashmap_t *hashmap)
+{
+	hashmap_table_t *table = &hashmap->table;
+	size_t slot_count = (size_t)table->mask + 1;
+
+	if (((table->count + 1) * 256) <= (slot_count * HASHMAP_MAX_LOAD)) {
+		return true;
+	}
+
+	/* Any previous growth must be complete before the next */
+	hashmap__migrate(hashmap, 0);
+
+	if (slot_count <= (UINT32_MAX / 2)) {
+		hashmap_table_t grown;
+		if (hashmap__table_init(&grown, slot_count * 2)) {
+			hashmap->old = *table;
+			hashmap->migrate_slot = 0;
+			*table = grown;
+			return true;
+		}
+	}
+
+	/* Could not grow, carry on at a higher load if possible */
+	return table->count < table->mask;
+}
+
+
+/**
+ * Clear the markers left by removals during iteration
+ *
+ * \param hashmap The hashmap to tidy
+ * \param table The table to clear the markers from
+ */
+static void
+hashmap__table_purge(hashmap_t *hashmap, hashmap_table_t *table)
+{
+	uint32_t slot = 0;
+
+	if (table->slots == NULL) {
+		return;
+	}
+
+	while ((slot <= table->mask) && (hashmap->removed_count > 0)) {
+		hashmap_entry_t *entry = &table->slots[slot];
+
+		if ((entry->distance != 0) && (entry->key == NULL)) {
+			/* erasing may move another marker into this slot */
+			hashmap__table_erase(table, entry);
+			hashmap->removed_count--;
+		} else {
+			slot++;
+		}
+	}
+}
+
+
 /* Exported function, documented in hashmap.h */
 hashmap_t *
 hashmap_create(hashmap_parameters_t *params)
@@ -71,40 +400,54 @@ hashmap_create(hashmap_parameters_t *params)
 		return NULL;
 	}
 
+	memset(ret, 0, sizeof(hashmap_t));
 	ret->params = params;
-	ret->bucket_count = DEFAULT_HASHMAP_BUCKETS;
-	ret->entry_count = 0;
-	ret->buckets = malloc(ret->bucket_count * sizeof(hashmap_entry_t *));
 
-	if (ret->buckets == NULL) {
+	if (!hashmap__table_init(&ret->table, DEFAULT_HASHMAP_SLOTS)) {
 		free(ret);
 		return NULL;
 	}
 
-	memset(ret->buckets, 0, ret->bucket_count * sizeof(hashmap_entry_t *));
-
 	return ret;
 }
 
-/* Exported function, documented in hashmap.h */
-void
-hashmap_destroy(hashmap_t *hashmap)
+
+/**
+ * Destroy every entry in a table and free its slots
+ *
+ * \param hashmap The hashmap the table belongs to
+ * \param table The table to destroy
+ */
+static void
+hashmap__table_destroy(hashmap_t *hashmap, hashmap_table_t *table)
 {
-	uint32_t bucket;
-	hashmap_entry_t *entry;
+	uint32_t slot;
 
-	for (bucket = 0; bucket < hashmap->bucket_count; bucket++) {
-		for (entry = hashmap->buckets[bucket];
-		     entry != NULL;) {
-			hashmap_entry_t *next = entry->next;
+	if (table->slots == NULL) {
+		return;
+	}
+
+	for (slot = 0; slot <= table->mask; slot++) {
+		hashmap_entry_t *entry = &table->slots[slot];
+		if ((entry->distance != 0) && (entry->key != NULL)) {
 			hashmap->params->value_destroy(entry->value);
 			hashmap->params->key_destroy(entry->key);
-			free(entry);
-			entry = next;
 		}
 	}
 
-	free(hashmap->buckets);
+	free(table->slots);
+	table->slots = NULL;
+}
+
+/* Exported function, documented in hashmap.h */
+void
+hashmap_destroy(hashmap_t *hashmap)
+{
+	assert(hashmap->iterating == 0);
+
+	hashmap__table_destroy(hashmap, &hashmap->old);
+	hashmap__table_destroy(hashmap, &hashmap->table);
+
 	free(hashmap);
 }
 
@@ -113,17 +456,17 @@ void *
 hashmap_lookup(hashmap_t *hashmap, void *key)
 {
 	uint32_t hash = hashmap->params->key_hash(key);
-	hashmap_entry_t *entry = hashmap->buckets[hash % hashmap->bucket_count];
+	hashmap_entry_t *entry;
 
-	for(;entry != NULL; entry = entry->next) {
-		if (entry->key_hash == hash) {
-			if (hashmap->params->key_eq(key, entry->key)) {
-				return entry->value;
-			}
+	entry = hashmap__table_find(hashmap, &hashmap->table, key, hash);
+	if (entry == NULL) {
+		entry = hashmap__table_find(hashmap, &hashmap->old, key, hash);
+		if (entry == NULL) {
+			return NULL;
 		}
 	}
 
-	return NULL;
+	return entry->value;
 }
 
 /* Exported function, documented in hashmap.h */
@@ -131,74 +474,60 @@ void *
 hashmap_insert(hashmap_t *hashmap, void *key)
 {
 	uint32_t hash = hashmap->params->key_hash(key);
-	uint32_t bucket = hash % hashmap->bucket_count;
-	hashmap_entry_t *entry = hashmap->buckets[bucket];
+	hashmap_entry_t *entry;
 	void *new_key, *new_value;
 
-	for(;entry != NULL; entry = entry->next) {
-		if (entry->key_hash == hash) {
-			if (hashmap->params->key_eq(key, entry->key)) {
-				/* This key is already here */
-				new_key = hashmap->params->key_clone(key);
-				if (new_key == NULL) {
-					/* Allocation failed */
-					return NULL;
-				}
-				new_value = hashmap->params->value_alloc(entry->key);
-				if (new_value == NULL) {
-					/* Allocation failed */
-					hashmap->params->key_destroy(new_key);
-					return NULL;
-				}
-				hashmap->params->value_destroy(entry->value);
-				hashmap->params->key_destroy(entry->key);
-				entry->value = new_value;
-				entry->key = new_key;
-				return entry->value;
-			}
-		}
-	}
+	/* Entries may not be added while iterating */
+	assert(hashmap->iterating == 0);
 
-	/* The key was not found in the map, so allocate a new entry */
-	entry = malloc(sizeof(*entry));
+	hashmap__migrate(hashmap, HASHMAP_MIGRATE_SLOTS);
 
+	entry = hashmap__table_find(hashmap, &hashmap->table, key, hash);
 	if (entry == NULL) {
-		return NULL;
+		entry = hashmap__table_find(hashmap, &hashmap->old, key, hash);
 	}
-	
-	memset(entry, 0, sizeof(*entry));
 
-	entry->key = hashmap->params->key_clone(key);
-	if (entry->key == NULL) {
-		goto err;
+	if (entry != NULL) {
+		/* This key is already here */
+		new_key = hashmap->params->key_clone(key);
+		if (new_key == NULL) {
+			/* Allocation failed */
+			return NULL;
+		}
+		new_value = hashmap->params->value_alloc(new_key);
+		if (new_value == NULL) {
+			/* Allocation failed */
+			hashmap->params->key_destroy(new_key);
+			return NULL;
+		}
+		hashmap->params->value_destroy(entry->value);
+		hashmap->params->key_destroy(entry->key);
+		entry->value = new_value;
+		entry->key = new_key;
+		return entry->value;
 	}
-	entry->key_hash = hash;
 
-	entry->value = hashmap->params->value_alloc(entry->key);
-	if (entry->value == NULL) {
-		goto err;
+	/* The key was not found in the map, so create a new entry */
+	if (!hashmap__reserve(hashmap)) {
+		return NULL;
 	}
 
-	entry->prevptr = &(hashmap->buckets[bucket]);
-	entry->next = hashmap->buckets[bucket];
-	if (entry->next != NULL) {
-		entry->next->prevptr = &entry->next;
+	new_key = hashmap->params->key_clone(key);
+	if (new_key == NULL) {
+		return NULL;
 	}
 
-	hashmap->buckets[bucket] = entry;
-
-	hashmap->entry_count++;
+	new_value = hashmap->params->value_alloc(new_key);
+	if (new_value == NULL) {
+		hashmap->params->key_destroy(new_key);
+		return NULL;
+	}
 
-	return entry->value;
+	hashmap__table_place(&hashmap->table, new_key, new_value, hash);
 
-err:
-	if (entry->value != NULL)
-		hashmap->params->value_destroy(entry->value);
-	if (entry->key != NULL)
-		hashmap->params->key_destroy(entry->key);
-	free(entry);
+	hashmap->entry_count++;
 
-	return NULL;
+	return new_value;
 }
 
 /* Exported function, documented in hashmap.h */
@@ -206,22 +535,64 @@ bool
 hashmap_remove(hashmap_t *hashmap, void *key)
 {
 	uint32_t hash = hashmap->params->key_hash(key);
-	
-	hashmap_entry_t *entry = hashmap->buckets[hash % hashmap->bucket_count];
-
-	for(;entry != NULL; entry = entry->next) {
-		if (entry->key_hash == hash) {
-			if (hashmap->params->key_eq(key, entry->key)) {
-				hashmap->params->value_destroy(entry->value);
-				hashmap->params->key_destroy(entry->key);
-				if (entry->next != NULL) {
-					entry->next->prevptr = entry->prevptr;
-				}
-				*entry->prevptr = entry->next;
-				free(entry);
-				hashmap->entry_count--;
+	hashmap_table_t *table = &hashmap->table;
+	hashmap_entry_t *entry;
+
+	hashmap__migrate(hashmap, HASHMAP_MIGRATE_SLOTS);
+
+	entry = hashmap__table_find(hashmap, table, key, hash);
+	if (entry == NULL) {
+		table = &hashmap->old;
+		entry = hashmap__table_find(hashmap, table, key, hash);
+		if (entry == NULL) {
+			return false;
+		}
+	}
+
+	hashmap->params->value_destroy(entry->value);
+	hashmap->params->key_destroy(entry->key);
+
+	if (hashmap->iterating > 0) {
+		/* Leave a marker so iteration does not skip entries */
+		entry->key = NULL;
+		entry->value = NULL;
+		hashmap->removed_count++;
+	} else {
+		hashmap__table_erase(table, entry);
+	}
+
+	hashmap->entry_count--;
+
+	return true;
+}
+
+
+/**
+ * Iterate the entries of one table
+ *
+ * \param table The table to iterate
+ * \param cb The callback for each key,value pair
+ * \param ctx The callback context
+ * \return Whether or not we stopped iteration early
+ */
+static bool
+hashmap__table_iterate(hashmap_table_t *table,
+		       hashmap_iteration_cb_t cb,
+		       void *ctx)
+{
+	uint32_t slot;
+
+	if (table->slots == NULL) {
+		return false;
+	}
+
+	for (slot = 0; slot <= table->mask; slot++) {
+		hashmap_entry_t *entry = &table->slots[slot];
+
+		if ((entry->distance != 0) && (entry->key != NULL)) {
+			/* If the callback returns true, we early-exit */
+			if (cb(entry->key, entry->value, ctx))
 				return true;
-			}
 		}
 	}
 
@@ -232,19 +603,28 @@ hashmap_remove(hashmap_t *hashmap, void *key)
 bool
 hashmap_iterate(hashmap_t *hashmap, hashmap_iteration_cb_t cb, void *ctx)
 {
-	for (uint32_t bucket = 0;
-	     bucket < hashmap->bucket_count;
-	     bucket++) {
-		for (hashmap_entry_t *entry = hashmap->buckets[bucket];
-		     entry != NULL;
-		     entry = entry->next) {
-			/* If the callback returns true, we early-exit */
-			if (cb(entry->key, entry->value, ctx))
-				return true;
+	bool stopped;
+
+	hashmap->iterating++;
+
+	stopped = hashmap__table_iterate(&hashmap->old, cb, ctx);
+	if (!stopped) {
+		stopped = hashmap__table_iterate(&hashmap->table, cb, ctx);
+	}
+
+	hashmap->iterating--;
+
+	if ((hashmap->iterating == 0) && (hashmap->removed_count > 0)) {
+		hashmap__table_purge(hashmap, &hashmap->old);
+		hashmap__table_purge(hashmap, &hashmap->table);
+		if ((hashmap->old.slots != NULL) &&
+		    (hashmap->old.count == 0)) {
+			free(hashmap->old.slots);
+			hashmap->old.slots = NULL;
 		}
 	}
 
-	return false;
+	return stopped;
 }
 
 /* Exported function, documented in hashmap.h */
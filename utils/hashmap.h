@@ -27,7 +27,8 @@
  *
  * Hashmaps take ownership of the keys inserted into them by means of a
  * clone function in their parameters.  They also manage the value memory
- * directly.
+ * directly.  Value pointers remain valid until the entry is removed, the
+ * hashmap grows as required to accommodate its entries.
  */
 typedef struct hashmap_s hashmap_t;
 
@@ -177,7 +178,10 @@ bool hashmap_remove(hashmap_t *hashmap, void *key);
  * Iterate the hashmap
  *
  * For each key/value pair in the hashmap, call the callback passing in
- * the key and value.  During iteration you MUST NOT mutate the hashmap.
+ * the key and value.  During iteration entries may be removed from the
+ * hashmap, including the one passed to the callback, and every remaining
+ * entry will still be visited exactly once.  You MUST NOT insert into the
+ * hashmap during iteration.
  *
  * \param hashmap The hashmap to iterate
  * \param cb The callback for each key,value pair
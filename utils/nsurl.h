@@ -30,6 +30,9 @@
 /** NetSurf URL object */
 typedef struct nsurl nsurl;
 
+/** Base URL prepared for resolving many relative references against */
+struct nsurl_join_base;
+
 /** A type for URL schemes */
 enum nsurl_scheme_type {
 	NSURL_SCHEME_OTHER,
@@ -285,6 +288,64 @@ uint32_t nsurl_hash(const nsurl *url);
 nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined);
 
 
+/**
+ * Prepare a base url for joining many relative link parts to
+ *
+ * \param base	    NetSurf URL containing the base to join to
+ * \param prepared  Returns the prepared base
+ * \return NSERROR_OK on success, appropriate error otherwise
+ *
+ * The prepared base holds a reference to base and remembers recent
+ * results, so repeated references are resolved without parsing.  It
+ * must be destroyed with nsurl_join_base_destroy.
+ */
+nserror nsurl_join_base_create(nsurl *base, struct nsurl_join_base **prepared);
+
+
+/**
+ * Destroy a prepared base url
+ *
+ * \param prepared  Prepared base to destroy, may be NULL
+ */
+void nsurl_join_base_destroy(struct nsurl_join_base *prepared);
+
+
+/**
+ * Join a prepared base url to a relative link part
+ *
+ * \param prepared  Prepared base to join rel to
+ * \param rel	    String containing the relative link part
+ * \param joined    Returns joined NetSurf URL
+ * \return NSERROR_OK on success, appropriate error otherwise
+ *
+ * The result is identical to calling nsurl_join with the prepared base's
+ * URL.  If return value != NSERROR_OK, nothing will be returned in join.
+ *
+ * It is up to the client to call nsurl_unref when they are finished with
+ * the created object.
+ */
+nserror nsurl_join_prepared(struct nsurl_join_base *prepared,
+		const char *rel, nsurl **joined);
+
+
+/**
+ * Join a base url to each of a set of relative link parts
+ *
+ * \param base	 NetSurf URL containing the base to join to
+ * \param rel	 Array of count strings containing relative link parts
+ * \param count	 Number of relative link parts
+ * \param joined Array of count entries updated with the joined URLs
+ * \return NSERROR_OK on success, appropriate error otherwise
+ *
+ * If return value != NSERROR_OK, no URLs will be returned in joined.
+ *
+ * It is up to the client to call nsurl_unref on each joined URL when they
+ * are finished with it.
+ */
+nserror nsurl_join_batch(nsurl *base, const char * const *rel,
+		unsigned int count, nsurl **joined);
+
+
 /**
  * Create a NetSurf URL object without a fragment from a NetSurf URL
  *
@@ -388,6 +449,26 @@ nserror nsurl_nice(const nsurl *url, char **result, bool remove_extensions);
  */
 nserror nsurl_parent(const nsurl *url, nsurl **new_url);
 
+/**
+ * Enable sharing of NetSurf URL objects between identical URLs
+ *
+ * Once enabled, creating a URL identical to one which already exists
+ * returns a new reference to the existing object. Identical URLs then
+ * share memory and compare equal by identity.
+ *
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+nserror nsurl_intern_init(void);
+
+
+/**
+ * Stop sharing NetSurf URL objects between identical URLs
+ *
+ * Objects which remain referenced stay valid but are no longer shared.
+ */
+void nsurl_intern_fini(void);
+
+
 /**
  * Dump a NetSurf URL's internal components to stderr
  *
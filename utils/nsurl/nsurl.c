@@ -38,9 +38,12 @@
 #include <strings.h>
 #include <inttypes.h>
 
+#include "netsurf/inttypes.h"
+
 #include "utils/ascii.h"
 #include "utils/corestrings.h"
 #include "utils/errors.h"
+#include "utils/hashmap.h"
 #include "utils/idna.h"
 #include "utils/log.h"
 #include "utils/nsurl/private.h"
@@ -65,10 +68,165 @@
 
 
 
+/**
+ * Table of NetSurf URL objects shared between identical URLs
+ *
+ * NULL when URL interning is not enabled.
+ */
+static hashmap_t *nsurl__intern_table = NULL;
+
+
+/**
+ * Intern table key clone; the table holds no reference to its URLs
+ */
+static void *nsurl__intern_key_clone(void *key)
+{
+	return key;
+}
+
+
+/**
+ * Intern table key destroy; nothing to release
+ */
+static void nsurl__intern_key_destroy(void *key)
+{
+}
+
+
+/**
+ * Intern table key hash
+ */
+static uint32_t nsurl__intern_key_hash(void *key)
+{
+	return ((nsurl *)key)->hash;
+}
+
+
+/**
+ * Intern table key equality; identical including any fragment
+ */
+static bool nsurl__intern_key_eq(void *key1, void *key2)
+{
+	const nsurl *url1 = key1;
+	const nsurl *url2 = key2;
+
+	/* components are interned, so equal strings are the same string */
+	return ((url1->hash == url2->hash) &&
+		(url1->components.path == url2->components.path) &&
+		(url1->components.host == url2->components.host) &&
+		(url1->components.query == url2->components.query) &&
+		(url1->components.scheme == url2->components.scheme) &&
+		(url1->components.username == url2->components.username) &&
+		(url1->components.password == url2->components.password) &&
+		(url1->components.port == url2->components.port) &&
+		(url1->components.fragment == url2->components.fragment));
+}
+
+
+/**
+ * Intern table value allocation; the value is the URL itself
+ */
+static void *nsurl__intern_value_alloc(void *key)
+{
+	return key;
+}
+
+
+/**
+ * Intern table value destroy; nothing to release
+ */
+static void nsurl__intern_value_destroy(void *value)
+{
+}
+
+
+static hashmap_parameters_t nsurl__intern_parameters = {
+	.key_clone = nsurl__intern_key_clone,
+	.key_hash = nsurl__intern_key_hash,
+	.key_eq = nsurl__intern_key_eq,
+	.key_destroy = nsurl__intern_key_destroy,
+	.value_alloc = nsurl__intern_value_alloc,
+	.value_destroy = nsurl__intern_value_destroy,
+};
+
+
+/* exported interface, documented in nsurl/private.h */
+void nsurl__intern(nsurl **url)
+{
+	nsurl *existing;
+
+	(*url)->interned = false;
+
+	if (nsurl__intern_table == NULL) {
+		return;
+	}
+
+	existing = hashmap_lookup(nsurl__intern_table, *url);
+	if (existing != NULL) {
+		/* Discard the new object in favour of the existing one */
+		nsurl__components_destroy(&(*url)->components);
+		free(*url);
+
+		*url = nsurl_ref(existing);
+		return;
+	}
+
+	/* Failure to insert only loses the sharing of this URL */
+	if (hashmap_insert(nsurl__intern_table, *url) != NULL) {
+		(*url)->interned = true;
+	}
+}
+
+
+/**
+ * Intern table iterator which detaches every URL from the table
+ */
+static bool nsurl__intern_detach_cb(void *key, void *value, void *ctx)
+{
+	((nsurl *)value)->interned = false;
+
+	return false;
+}
+
+
 /******************************************************************************
  * NetSurf URL Public API                                                     *
  ******************************************************************************/
 
+/* exported interface, documented in nsurl.h */
+nserror nsurl_intern_init(void)
+{
+	if (nsurl__intern_table != NULL) {
+		return NSERROR_OK;
+	}
+
+	nsurl__intern_table = hashmap_create(&nsurl__intern_parameters);
+	if (nsurl__intern_table == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface, documented in nsurl.h */
+void nsurl_intern_fini(void)
+{
+	if (nsurl__intern_table == NULL) {
+		return;
+	}
+
+	NSLOG(netsurf, INFO, "%"PRIsizet" URL objects remain interned",
+	      hashmap_count(nsurl__intern_table));
+
+	/* URLs that outlive the table are simply no longer shared */
+	hashmap_iterate(nsurl__intern_table, nsurl__intern_detach_cb, NULL);
+
+	hashmap_destroy(nsurl__intern_table);
+	nsurl__intern_table = NULL;
+}
+
+
 /* exported interface, documented in nsurl.h */
 nsurl *nsurl_ref(nsurl *url)
 {
@@ -89,6 +247,10 @@ void nsurl_unref(nsurl *url)
 	if (--url->count > 0)
 		return;
 
+	if (url->interned) {
+		hashmap_remove(nsurl__intern_table, url);
+	}
+
 	/* Release lwc strings */
 	nsurl__components_destroy(&url->components);
 
@@ -105,6 +267,22 @@ bool nsurl_compare(const nsurl *url1, const nsurl *url2, nsurl_component parts)
 	assert(url1 != NULL);
 	assert(url2 != NULL);
 
+	if (url1 == url2) {
+		return true;
+	}
+
+	/* Identical interned URLs are always the same object */
+	if (url1->interned && url2->interned &&
+	    ((parts & NSURL_WITH_FRAGMENT) == NSURL_WITH_FRAGMENT)) {
+		return false;
+	}
+
+	/* The hash covers every component except the fragment */
+	if (((parts & NSURL_COMPLETE) == NSURL_COMPLETE) &&
+	    (url1->hash != url2->hash)) {
+		return false;
+	}
+
 	/* Compare URL components */
 
 	/* Path, host and query first, since they're most likely to differ */
@@ -526,6 +704,9 @@ nserror nsurl_defragment(const nsurl *url, nsurl **no_frag)
 	/* Give the URL a reference */
 	(*no_frag)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(no_frag);
+
 	return NSERROR_OK;
 }
 
@@ -594,6 +775,9 @@ nserror nsurl_refragment(const nsurl *url, lwc_string *frag, nsurl **new_url)
 	/* Give the URL a reference */
 	(*new_url)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(new_url);
+
 	return NSERROR_OK;
 }
 
@@ -689,6 +873,9 @@ nserror nsurl_replace_query(const nsurl *url, const char *query,
 	/* Give the URL a reference */
 	(*new_url)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(new_url);
+
 	return NSERROR_OK;
 }
 
@@ -776,6 +963,9 @@ nserror nsurl_replace_scheme(const nsurl *url, lwc_string *scheme,
 	/* Give the URL a reference */
 	(*new_url)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(new_url);
+
 	return NSERROR_OK;
 }
 
@@ -979,6 +1169,9 @@ nserror nsurl_parent(const nsurl *url, nsurl **new_url)
 	/* Give the URL a reference */
 	(*new_url)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(new_url);
+
 	return NSERROR_OK;
 }
 
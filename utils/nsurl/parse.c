@@ -38,6 +38,12 @@
 #include <string.h>
 #include <strings.h>
 
+#include "utils/config.h"
+
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
 #include "netsurf/inttypes.h"
 
 #include "utils/ascii.h"
@@ -190,6 +196,97 @@ static bool nsurl__is_no_escape(unsigned char c)
 }
 
 
+/**
+ * Find the first character in a URL section which needs normalising.
+ *
+ * Every character before the returned position may be copied verbatim
+ * into the normalised URL.  Where SSE2 is available the section is
+ * classified sixteen bytes at a time and only the remainder is
+ * examined individually.
+ *
+ * \param pos	start of the run to scan
+ * \param end	end of the URL section
+ * \param fold	true for the scheme and host, where only percent
+ *		escapes and upper case letters need attention
+ * \return first character needing attention, or end if there are none
+ */
+static const char *
+nsurl__find_normalise(const char *pos, const char *end, bool fold)
+{
+#if defined(HAVE_SSE2)
+	const __m128i percent = _mm_set1_epi8('%');
+
+	if (fold) {
+		const __m128i above = _mm_set1_epi8('A' - 1);
+		const __m128i below = _mm_set1_epi8('Z' + 1);
+
+		while (end - pos >= 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *)pos);
+			__m128i hit;
+			int mask;
+
+			hit = _mm_and_si128(_mm_cmpgt_epi8(v, above),
+					_mm_cmplt_epi8(v, below));
+			hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, percent));
+
+			mask = _mm_movemask_epi8(hit);
+			if (mask != 0) {
+				return pos + __builtin_ctz(mask);
+			}
+			pos += 16;
+		}
+	} else {
+		const __m128i graph = _mm_set1_epi8(0x21);
+		const __m128i two = _mm_set1_epi8(0x02);
+
+		while (end - pos >= 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *)pos);
+			__m128i v2 = _mm_or_si128(v, two);
+			__m128i hit;
+			int mask;
+
+			/* Signed compare catches controls, space and
+			 * every byte with the top bit set */
+			hit = _mm_cmplt_epi8(v, graph);
+			hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, percent));
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+			/* '<' and '>' */
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v2, _mm_set1_epi8('>')));
+			/* '\\' and '^' */
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v2, _mm_set1_epi8('^')));
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('`')));
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('{')));
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+			hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+
+			mask = _mm_movemask_epi8(hit);
+			if (mask != 0) {
+				return pos + __builtin_ctz(mask);
+			}
+			pos += 16;
+		}
+	}
+#endif
+
+	if (fold) {
+		while (pos < end && *pos != '%' && !ascii_is_alpha_upper(*pos))
+			pos++;
+	} else {
+		while (pos < end && *pos != '%' && nsurl__is_no_escape(*pos))
+			pos++;
+	}
+
+	return pos;
+}
+
+
 /**
  * Obtains a set of markers delimiting sections in a URL string
  *
@@ -406,32 +503,23 @@ static void nsurl__get_string_markers(const char * const url_s,
 	 */
 	if (*pos == '/' || ((marker.path == marker.authority) &&
 			(*pos != '?') && (*pos != '#') && (*pos != '\0'))) {
-		while (*(++pos) != '\0') {
-			if (*pos == '?' || *pos == '#') {
-				/* End of the path */
-				break;
-			}
-		}
+		/* End of the path is the query, fragment or string end */
+		pos += 1 + strcspn(pos + 1, "?#");
 	}
 
 	marker.query = pos - url_s;
 
 	/* Get query */
 	if (*pos == '?') {
-		while (*(++pos) != '\0') {
-			if (*pos == '#') {
-				/* End of the query */
-				break;
-			}
-		}
+		/* End of the query is the fragment or string end */
+		pos += 1 + strcspn(pos + 1, "#");
 	}
 
 	marker.fragment = pos - url_s;
 
 	/* Get fragment */
 	if (*pos == '#') {
-		while (*(++pos) != '\0')
-			;
+		pos += strlen(pos);
 	}
 
 	/* We got to the end of url_s.
@@ -696,6 +784,14 @@ static nserror nsurl__create_from_section(const char * const url_s,
 	pos = pos_url_s = url_s + start;
 	copy_len = 0;
 	for (; pos < url_s + end; pos++) {
+		/* Skip over any run of characters needing no change */
+		const char *run = nsurl__find_normalise(pos, url_s + end,
+				(section == URL_SCHEME || section == URL_HOST));
+		copy_len += run - pos;
+		pos = run;
+		if (pos == url_s + end)
+			break;
+
 		if (*pos == '%' && (pos + 2 < url_s + end)) {
 			/* Might be an escaped character needing unescaped */
 
@@ -1377,14 +1473,57 @@ nserror nsurl_create(const char * const url_s, nsurl **url)
 	/* Give the URL a reference */
 	(*url)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(url);
+
 	return NSERROR_OK;
 }
 
 
-/* exported interface, documented in nsurl.h */
-nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined)
+/**
+ * Get the length of a base URL's path up to and including its last '/'
+ *
+ * This is the part of the base path kept when a relative path is merged
+ * with it.
+ *
+ * \param base	base URL
+ * \return length of the directory part of the base path
+ */
+static size_t nsurl__base_dir_len(const nsurl *base)
 {
-	struct url_markers m;
+	size_t path_end;
+	const char *path;
+
+	if (base->components.path == NULL)
+		return 0;
+
+	path_end = lwc_string_length(base->components.path);
+	path = lwc_string_data(base->components.path);
+
+	while (*(path + path_end) != '/' && path_end != 0) {
+		path_end--;
+	}
+	if (*(path + path_end) == '/')
+		path_end++;
+
+	return path_end;
+}
+
+
+/**
+ * Join a base url to a relative link part whose markers are known
+ *
+ * \param base	    base URL
+ * \param base_dir_len length of the directory part of the base path
+ * \param rel	    relative link part
+ * \param mp	    markers for the sections of rel
+ * \param joined    updated to the joined URL on success
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror nsurl__join(const nsurl *base, size_t base_dir_len,
+		const char *rel, const struct url_markers *mp, nsurl **joined)
+{
+	struct url_markers m = *mp;
 	struct nsurl_components c;
 	size_t length;
 	char *buff;
@@ -1400,15 +1539,6 @@ nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined)
 		NSURL_F_BASE_QUERY	= (1 << 4)
 	} joined_parts;
 
-	assert(base != NULL);
-	assert(rel != NULL);
-
-	NSLOG(netsurf, DEEPDEBUG, "base: \"%s\", rel: \"%s\"",
-			nsurl_access(base), rel);
-
-	/* Peg out the URL sections */
-	nsurl__get_string_markers(rel, &m, true);
-
 	/* Get the length of the longest section */
 	length = nsurl__get_longest_section(&m);
 
@@ -1520,21 +1650,12 @@ nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined)
 		{
 			/* Append relative path to all but last segment of
 			 * base path. */
-			size_t path_end = lwc_string_length(
-					base->components.path);
 			const char *path = lwc_string_data(
 					base->components.path);
 
-			while (*(path + path_end) != '/' &&
-					path_end != 0) {
-				path_end--;
-			}
-			if (*(path + path_end) == '/')
-				path_end++;
-
 			/* Copy the base part */
-			memcpy(buff_pos, path, path_end);
-			buff_pos += path_end;
+			memcpy(buff_pos, path, base_dir_len);
+			buff_pos += base_dir_len;
 
 			/* Copy the relative part */
 			memcpy(buff_pos, rel + m.path, m.query - m.path);
@@ -1615,5 +1736,252 @@ nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined)
 	/* Give the URL a reference */
 	(*joined)->count = 1;
 
+	/* Share any identical URL object that already exists */
+	nsurl__intern(joined);
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface, documented in nsurl.h */
+nserror nsurl_join(const nsurl *base, const char *rel, nsurl **joined)
+{
+	struct url_markers m;
+
+	assert(base != NULL);
+	assert(rel != NULL);
+
+	NSLOG(netsurf, DEEPDEBUG, "base: \"%s\", rel: \"%s\"",
+			nsurl_access(base), rel);
+
+	/* Peg out the URL sections */
+	nsurl__get_string_markers(rel, &m, true);
+
+	return nsurl__join(base, nsurl__base_dir_len(base), rel, &m, joined);
+}
+
+
+/** Number of recently resolved references a prepared base remembers */
+#define NSURL_JOIN_BASE_CACHE_SIZE 256
+
+/** Longest relative reference a prepared base will remember */
+#define NSURL_JOIN_BASE_CACHE_MAX_REL 256
+
+/**
+ * Remembered resolution of a relative reference
+ */
+struct nsurl_join_base_entry {
+	char *rel;		/**< Relative reference, or NULL if unused */
+	uint32_t hash;		/**< Hash of rel */
+	nsurl *joined;		/**< Result of resolving rel */
+};
+
+/**
+ * Base URL prepared for resolving many relative references
+ */
+struct nsurl_join_base {
+	nsurl *base;		/**< The base URL */
+	nsurl *base_nofrag;	/**< The base URL without any fragment */
+	size_t dir_len;		/**< Length of directory part of base path */
+
+	unsigned int hits;	/**< References resolved from the cache */
+	unsigned int misses;	/**< References which needed joining */
+
+	/** Recently resolved references, indexed by hash */
+	struct nsurl_join_base_entry cache[NSURL_JOIN_BASE_CACHE_SIZE];
+};
+
+
+/* exported interface, documented in nsurl.h */
+nserror nsurl_join_base_create(nsurl *base, struct nsurl_join_base **prepared)
+{
+	struct nsurl_join_base *jb;
+	nserror error;
+
+	assert(base != NULL);
+
+	jb = calloc(1, sizeof(*jb));
+	if (jb == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	error = nsurl_defragment(base, &jb->base_nofrag);
+	if (error != NSERROR_OK) {
+		free(jb);
+		return error;
+	}
+
+	jb->base = nsurl_ref(base);
+	jb->dir_len = nsurl__base_dir_len(base);
+
+	*prepared = jb;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface, documented in nsurl.h */
+void nsurl_join_base_destroy(struct nsurl_join_base *prepared)
+{
+	unsigned int idx;
+
+	if (prepared == NULL)
+		return;
+
+	NSLOG(netsurf, DEBUG, "%s: %u cache hits, %u misses",
+			nsurl_access(prepared->base),
+			prepared->hits, prepared->misses);
+
+	for (idx = 0; idx < NSURL_JOIN_BASE_CACHE_SIZE; idx++) {
+		if (prepared->cache[idx].rel != NULL) {
+			free(prepared->cache[idx].rel);
+			nsurl_unref(prepared->cache[idx].joined);
+		}
+	}
+
+	nsurl_unref(prepared->base_nofrag);
+	nsurl_unref(prepared->base);
+	free(prepared);
+}
+
+
+/**
+ * Resolve a reference consisting of only a fragment against a base
+ *
+ * \param jb	  prepared base
+ * \param rel	  relative reference
+ * \param m	  markers for the sections of rel
+ * \param joined updated to the joined URL on success
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror nsurl__join_fragment(struct nsurl_join_base *jb,
+		const char *rel, const struct url_markers *m, nsurl **joined)
+{
+	struct nsurl_components c;
+	char *buff;
+	nserror error;
+
+	/* Allow for every character of the fragment being escaped */
+	buff = malloc((m->end - m->fragment) * 3 + 1);
+	if (buff == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	error = nsurl__create_from_section(rel, URL_FRAGMENT, m, buff, &c);
+	free(buff);
+	if (error != NSERROR_OK) {
+		return error;
+	}
+
+	if (c.fragment == NULL) {
+		/* Empty fragment refers to the document itself */
+		*joined = nsurl_ref(jb->base_nofrag);
+		return NSERROR_OK;
+	}
+
+	error = nsurl_refragment(jb->base, c.fragment, joined);
+	lwc_string_unref(c.fragment);
+
+	return error;
+}
+
+
+/* exported interface, documented in nsurl.h */
+nserror nsurl_join_prepared(struct nsurl_join_base *prepared,
+		const char *rel, nsurl **joined)
+{
+	struct nsurl_join_base_entry *entry;
+	struct url_markers m;
+	uint32_t hash = 0x811c9dc5; /* FNV-1a offset basis */
+	size_t rel_len;
+	nserror error;
+
+	assert(prepared != NULL);
+	assert(rel != NULL);
+
+	for (rel_len = 0; rel[rel_len] != '\0'; rel_len++) {
+		hash ^= (unsigned char)rel[rel_len];
+		hash *= 0x01000193;
+	}
+
+	/* Check for an earlier resolution of the same reference */
+	entry = &prepared->cache[hash & (NSURL_JOIN_BASE_CACHE_SIZE - 1)];
+	if (entry->rel != NULL && entry->hash == hash &&
+			strcmp(entry->rel, rel) == 0) {
+		prepared->hits++;
+		*joined = nsurl_ref(entry->joined);
+		return NSERROR_OK;
+	}
+	prepared->misses++;
+
+	/* Peg out the URL sections */
+	nsurl__get_string_markers(rel, &m, true);
+
+	if (m.start == m.end) {
+		/* Empty reference is the base document itself */
+		*joined = nsurl_ref(prepared->base_nofrag);
+		error = NSERROR_OK;
+
+	} else if (m.fragment == m.start && *(rel + m.start) == '#') {
+		/* Same document reference */
+		error = nsurl__join_fragment(prepared, rel, &m, joined);
+
+	} else {
+		error = nsurl__join(prepared->base, prepared->dir_len,
+				rel, &m, joined);
+	}
+
+	if (error != NSERROR_OK || rel_len > NSURL_JOIN_BASE_CACHE_MAX_REL) {
+		return error;
+	}
+
+	/* Remember the resolution, replacing any older one */
+	if (entry->rel != NULL) {
+		free(entry->rel);
+		nsurl_unref(entry->joined);
+	}
+	entry->rel = malloc(rel_len + 1);
+	if (entry->rel != NULL) {
+		memcpy(entry->rel, rel, rel_len + 1);
+		entry->hash = hash;
+		entry->joined = nsurl_ref(*joined);
+	}
+
 	return NSERROR_OK;
 }
+
+
+/* exported interface, documented in nsurl.h */
+nserror nsurl_join_batch(nsurl *base, const char * const *rel,
+		unsigned int count, nsurl **joined)
+{
+	struct nsurl_join_base *prepared;
+	unsigned int idx;
+	nserror error;
+
+	assert(base != NULL);
+	assert(rel != NULL || count == 0);
+	assert(joined != NULL || count == 0);
+
+	error = nsurl_join_base_create(base, &prepared);
+	if (error != NSERROR_OK) {
+		return error;
+	}
+
+	for (idx = 0; idx < count; idx++) {
+		error = nsurl_join_prepared(prepared, rel[idx], &joined[idx]);
+		if (error != NSERROR_OK) {
+			/* Release everything resolved so far */
+			while (idx > 0) {
+				idx--;
+				nsurl_unref(joined[idx]);
+				joined[idx] = NULL;
+			}
+			break;
+		}
+	}
+
+	nsurl_join_base_destroy(prepared);
+
+	return error;
+}
@@ -58,6 +58,7 @@ struct nsurl {
 	struct nsurl_components components;
 
 	int count;	/* Number of references to NetSurf URL object */
+	bool interned;	/* Whether the object is in the intern table */
 	uint32_t hash;	/* Hash value for nsurl identification */
 
 	size_t length;	/* Length of string */
@@ -128,6 +129,18 @@ nserror nsurl__components_to_string(
 void nsurl__calc_hash(nsurl *url);
 
 
+/**
+ * Share an existing NetSurf URL object identical to a new one
+ *
+ * If URL interning is enabled and an identical URL object already
+ * exists, the new object is destroyed and replaced with a new
+ * reference to the existing one. Otherwise the new object is added
+ * to the intern table.
+ *
+ * \param url	Newly created NetSurf URL object, updated on sharing
+ */
+void nsurl__intern(nsurl **url);
+
 
 
 /**